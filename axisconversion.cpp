@@ -0,0 +1,132 @@
+#include <streamer/processor/ptz/axisconversion.h>
+#include <math.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+void AxisConversion::span(float min, float max, float& frange, float& mid)
+{
+	if (max < 0) {
+		if (min < 0) {
+			frange = min + max;
+			mid = min + frange/2;
+		} else {
+			frange = min - max;
+			mid = min - frange/2;
+		}
+	} else {
+		if (min > 0) {
+			frange = max + min;
+			mid = min - frange/2;
+		} else {
+			frange = max - min;
+			mid = min + frange/2;
+		}
+	}
+}
+
+// convert degree to value
+float AxisConversion::to_raw(float degree, float min, float max, bool zoom)
+{
+	float r = degree;
+
+	if (zoom) {
+		if (min > max) {
+			float pv = (float)(r / 100.00);
+			r = min - (pv * (min - max));
+		} else {
+			if (degree != 0) {
+				float pv = (float)(r / 100.00);
+				r = min + (pv * (max - min));
+			}
+		}
+	} else	{
+		//-180 should equal camera min
+		//+180 should equal camera max
+		float mid = 0;
+		float frange;
+		span(min, max, frange, mid);
+
+		float pv = (float)(r / 180.0);
+		r = mid + (pv * frange/2.0);
+	}
+
+	float f = r;
+
+	if (min > max) {
+		if (f < max)
+			f = max;
+		if (f > min)
+			f = min;
+	} else {
+		if (f < min)
+			f = min;
+		if (f > max)
+			f = max;
+	}
+
+	return f;
+}
+
+// convert camera value to degree
+float AxisConversion::to_degree(float value, float min, float max, bool zoom)
+{
+	float r = value;
+
+	if (zoom) {
+		if ((max-min) != 0) {
+			float pv = (r-min) / (max - min);
+			pv *= 100;
+			r = (float)floor(pv + 0.5);
+			if (r > 100)
+				r = 100.0;
+			if (r < 0)
+				r = 0.0;
+		}
+	} else {
+		float mid = 0;
+		float frange;
+		span(min, max, frange, mid);
+
+		if (frange != 0) {
+			float pv = (r-min) / (frange);
+			r = pv * 360;
+			if (value < mid) {
+				r = (float)180.0 - r;
+				r = -r;
+			} else {
+				r -= (float)180.0;
+			}
+		}
+	}
+
+	return r;
+}
+
+float AxisConversion::from_percent(float percent, float min, float max)
+{
+	float mid = (max + min) / 2;
+	return mid + ((percent / 100) * (max - min) / 2);
+}
+
+float AxisConversion::range(float min, float max)
+{
+	float range = 0.0;
+
+	if (max < 0) {
+		if (min < 0)
+			range = min + max;
+		else
+			range = min - max;
+	} else {
+		if (min > 0)
+			range = max + min;
+		else
+			range = max - min;
+	}
+
+	return range;
+}
+
+}}}
@@ -0,0 +1,32 @@
+#pragma once
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+// Numeric conversion between NVR units (degrees for pan/tilt, percent for zoom)
+// and raw camera coordinates of an ONVIF space. Pure functions without
+// allocation, min may be greater than max for inverted axes.
+class AxisConversion {
+public:
+	// degree to camera value, clamped to [min, max]
+	static float to_raw(float degree, float min, float max, bool zoom);
+
+	// camera value to degree (-180 .. 180) or zoom percent (0 .. 100)
+	static float to_degree(float value, float min, float max, bool zoom);
+
+	// Value of a percentage (-100 .. 100) around the middle of the axis
+	static float from_percent(float percent, float min, float max);
+
+	static float range(float min, float max);
+
+	// Relative translation of degrees (pan/tilt) or percent (zoom) on an axis
+	// spanning range
+	static float relative(float degrees, float range, bool zoom) { return range * (degrees / (zoom ? 100.0f : 360.0f)); }
+
+private:
+	// Span and middle of a pan/tilt axis
+	static void span(float min, float max, float& frange, float& mid);
+};
+
+}}}
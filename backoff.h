@@ -0,0 +1,56 @@
+#pragma once
+#include <random>
+#include <stdint.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+// Exponential backoff schedule, each call to next() returns the current delay
+// and grows it by factor up to max. With jitter (0 - 1) the returned delay is
+// spread randomly by +/- jitter so many cameras do not retry in lockstep.
+class Backoff {
+public:
+	Backoff(uint32_t initial_ms, uint32_t max_ms, float factor, float jitter = 0)
+		: initial_ms_(initial_ms)
+		, max_ms_(max_ms)
+		, factor_(factor)
+		, jitter_(jitter)
+		, current_ms_(initial_ms)
+		, random_(jitter > 0 ? std::random_device()() : 1)
+	{
+	}
+
+	uint32_t next()
+	{
+		uint32_t ret = current_ms_;
+		if (jitter_ > 0) {
+			std::uniform_real_distribution<float> spread(1 - jitter_, 1 + jitter_);
+			ret = (uint32_t) (ret * spread(random_));
+		}
+
+		float grown = current_ms_ * factor_;
+		current_ms_ = (grown > max_ms_) ? max_ms_ : (uint32_t) grown;
+
+		return ret;
+	}
+
+	void reset()
+	{
+		current_ms_ = initial_ms_;
+	}
+
+	uint32_t initial() const { return initial_ms_; }
+
+	uint32_t max() const { return max_ms_; }
+
+private:
+	uint32_t initial_ms_;
+	uint32_t max_ms_;
+	float factor_;
+	float jitter_;
+	uint32_t current_ms_;
+	std::minstd_rand random_;
+};
+
+}}}
@@ -0,0 +1,204 @@
+// PtzCalibrator against a SimulatedCamera and the mapping functions of the
+// calibration it produces, no device involved.
+//
+//   g++ -std=c++11 -O2 -Wall -Wextra -I<include root> -o bench_calibration
+//       bench/microbench.cpp bench/simulatedcamera.cpp bench/bench_calibration.cpp ptzcalibration.cpp fovmodel.cpp
+//   ./bench_calibration [filter] [min seconds]
+//
+// The calibration starts from the axis limits and the datasheet field of
+// view, as OnvifControl::calibrate() does. calibrate_* fail the program when
+// the recovered field of view or pan/tilt scale is off by more than
+// MaxErrorPercent, pixel_to_ptz and ptz_to_pixel when they allocate and
+// click_to_center when the feature ends up further than MaxMiss from the
+// image center.
+#include <streamer/processor/ptz/bench/microbench.h>
+#include <streamer/processor/ptz/bench/simulatedcamera.h>
+#include <streamer/processor/ptz/ptzcalibration.h>
+#include <math.h>
+#include <stdio.h>
+
+using namespace orion::streamer::processor;
+using namespace orion::streamer::processor::bench;
+
+namespace {
+
+const float MaxErrorPercent = 0.5f;
+const float MaxMiss = 0.01f;
+
+// What OnvifControl::apply() starts from for a generic -1 to 1, 0 to 1 camera
+PtzCalibration uncalibrated(const SimulatedCamera& camera)
+{
+	AxisScale pan_tilt;
+	pan_tilt.valid_ = true;
+	pan_tilt.fx_min_ = pan_tilt.fy_min_ = -1;
+	pan_tilt.fx_max_ = pan_tilt.fy_max_ = 1;
+	AxisScale zoom;
+	zoom.valid_ = true;
+	zoom.fx_min_ = 0;
+	zoom.fx_max_ = 1;
+
+	PtzCalibration calibration;
+	calibration.set_limits(pan_tilt, zoom);
+	calibration.fov_ = camera.datasheet();
+	return calibration;
+}
+
+// Worst error in percent of the field of view samples and the pan/tilt scale
+float error_percent(const SimulatedCamera& camera, const PtzCalibration& calibration)
+{
+	float worst = 0;
+	for (uint32_t i = 0; i < calibration.fov_.samples(); i++) {
+		float zoom = 0, hfov = 0;
+		calibration.fov_.sample(i, zoom, hfov);
+		worst = fmaxf(worst, fabsf(hfov / camera.hfov(zoom) - 1) * 100);
+	}
+
+	float pan_scale = calibration.pan_.to_value(1) - calibration.pan_.to_value(0);
+	float tilt_scale = calibration.tilt_.to_value(1) - calibration.tilt_.to_value(0);
+	worst = fmaxf(worst, fabsf(pan_scale / camera.config().pan_degrees_ - 1) * 100);
+	return fmaxf(worst, fabsf(tilt_scale / camera.config().tilt_degrees_ - 1) * 100);
+}
+
+// Measured once for the mapping benchmarks
+const PtzCalibration& calibrated()
+{
+	static PtzCalibration calibration;
+	static bool done = false;
+	if (!done) {
+		SimulatedCamera camera;
+		calibration = uncalibrated(camera);
+		float pan = 0, tilt = 0;
+		camera.feature(pan, tilt);
+		PtzCalibrator().run(camera, pan - 0.1f, tilt - 0.05f, calibration);
+		done = true;
+	}
+	return calibration;
+}
+
+void report(State& state, bool ok, float error, uint32_t moves)
+{
+	char label[64];
+	snprintf(label, sizeof(label), "error %.3f%%, %u moves", error, moves);
+	state.set_label(label);
+	if (!ok || error > MaxErrorPercent)
+		state.set_error(ok ? label : "calibration failed");
+}
+
+// Whole run with the feature a little off center at the start
+void calibrate(State& state, float zoom_ratio, uint32_t zoom_steps)
+{
+	SimulatedCameraConfig config;
+	config.zoom_ratio_ = zoom_ratio;
+	SimulatedCamera camera(config);
+	PtzCalibrator calibrator(zoom_steps);
+	float pan = 0, tilt = 0;
+	camera.feature(pan, tilt);
+
+	bool ok = true;
+	PtzCalibration calibration;
+	uint32_t runs = 0;
+	while (state.keep_running()) {
+		calibration = uncalibrated(camera);
+		ok = calibrator.run(camera, pan - 0.1f, tilt - 0.05f, calibration) && ok;
+		runs++;
+	}
+
+	report(state, ok, error_percent(camera, calibration), runs ? camera.moves() / runs : 0);
+}
+
+void calibrate_zoom_10x(State& state) { calibrate(state, 10.0f, 8); }
+MICROBENCH(calibrate_zoom_10x);
+
+void calibrate_zoom_25x(State& state) { calibrate(state, 25.0f, 8); }
+MICROBENCH(calibrate_zoom_25x);
+
+void calibrate_zoom_30x_fine(State& state) { calibrate(state, 30.0f, FovModel::MaxSamples - 1); }
+MICROBENCH(calibrate_zoom_30x_fine);
+
+// Click-to-center and tracking per frame
+void pixel_to_ptz(State& state)
+{
+	const PtzCalibration& calibration = calibrated();
+	uint64_t allocations_before = allocations();
+
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		float pan = 0, tilt = 0;
+		float x = (i % 64) / 32.0f - 1;
+		calibration.pixel_to_ptz(x, -x / 2, 0.1f, 0.4f, (i % 11) / 10.0f, pan, tilt);
+		do_not_optimize(pan);
+		do_not_optimize(tilt);
+		i++;
+	}
+
+	if (allocations() != allocations_before)
+		state.set_error("pixel_to_ptz allocates");
+}
+MICROBENCH(pixel_to_ptz);
+
+// Overlays of known directions per frame
+void ptz_to_pixel(State& state)
+{
+	const PtzCalibration& calibration = calibrated();
+	uint64_t allocations_before = allocations();
+
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		float x = 0, y = 0;
+		bool visible = calibration.ptz_to_pixel(0.1f + (i % 64) / 640.0f, 0.4f, 0.1f, 0.4f, (i % 11) / 10.0f, x, y);
+		do_not_optimize(visible);
+		do_not_optimize(x);
+		do_not_optimize(y);
+		i++;
+	}
+
+	if (allocations() != allocations_before)
+		state.set_error("ptz_to_pixel allocates");
+}
+MICROBENCH(ptz_to_pixel);
+
+// A single move centers the feature seen anywhere in the image at any zoom
+void click_to_center(State& state)
+{
+	const PtzCalibration& calibration = calibrated();
+	SimulatedCamera camera;
+	float feature_pan = 0, feature_tilt = 0;
+	camera.feature(feature_pan, feature_tilt);
+
+	float worst = 0;
+	bool lost = false;
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		// Camera pointed off the feature by up to 40% of the image width
+		float zoom = (i % 5) / 4.0f;
+		float offset = camera.hfov(zoom) * (((i / 5) % 9) / 10.0f - 0.4f) / camera.config().pan_degrees_;
+		float pan = feature_pan + offset;
+		float tilt = feature_tilt - offset / 2;
+
+		float x = 0, y = 0, next_pan = 0, next_tilt = 0;
+		camera.move(pan, tilt, zoom);
+		if (!camera.locate(x, y)) {
+			lost = true;
+			break;
+		}
+		calibration.pixel_to_ptz(x, y, pan, tilt, zoom, next_pan, next_tilt);
+		camera.move(next_pan, next_tilt, zoom);
+		if (!camera.locate(x, y)) {
+			lost = true;
+			break;
+		}
+		worst = fmaxf(worst, fmaxf(fabsf(x), fabsf(y)));
+		i++;
+	}
+	while (state.keep_running())
+		;
+
+	char label[64];
+	snprintf(label, sizeof(label), "max miss %.4f", worst);
+	state.set_label(label);
+	if (lost || worst > MaxMiss)
+		state.set_error(lost ? "feature outside the image" : label);
+}
+MICROBENCH(click_to_center);
+
+}
@@ -0,0 +1,281 @@
+// Degree/raw conversion through AxisConversion against the string round trips
+// it replaced, and a check that both give the same values.
+//
+//   g++ -std=c++11 -O2 -Wall -Wextra -I<include root> -o bench_conversion
+//       bench/microbench.cpp bench/bench_conversion.cpp axisconversion.cpp
+//   ./bench_conversion [filter] [min seconds]
+//
+// The legacy_ functions are the conversions of OnvifControl before the change,
+// callers included: control() formatted the int16_t joystick value with
+// std::to_string, convert_to_raw parsed it with atof, convert_to_degree
+// returned std::to_string and save_position parsed that with std::stof.
+// equivalence_* run every whole degree and percent plus a grid of camera
+// values over normal and inverted (min > max) ranges and fail the program
+// when the paths differ by more than the float formatting of std::to_string.
+#include <streamer/processor/ptz/bench/microbench.h>
+#include <streamer/processor/ptz/axisconversion.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string>
+
+using namespace orion::streamer::processor;
+using namespace orion::streamer::processor::bench;
+
+namespace {
+
+float legacy_convert_to_raw(const std::string& degree, float min, float max, bool zoom)
+{
+	float v = (float) atof(degree.c_str());
+	float r = v;
+
+	if (zoom) {
+		if (min > max) {
+			float pv = (float) (r / 100.00);
+			r = min - (pv * (min - max));
+		} else {
+			if (v != 0) {
+				float pv = (float) (r / 100.00);
+				r = min + (pv * (max - min));
+			}
+		}
+	} else {
+		float mid = 0;
+		float frange;
+
+		if (max < 0) {
+			if (min < 0) {
+				frange = min + max;
+				mid = min + frange/2;
+			} else {
+				frange = min - max;
+				mid = min - frange/2;
+			}
+		} else {
+			if (min > 0) {
+				frange = max + min;
+				mid = min - frange/2;
+			} else {
+				frange = max - min;
+				mid = min + frange/2;
+			}
+		}
+
+		float pv = (float) (r / 180.0);
+		r = mid + (pv * frange/2.0);
+	}
+
+	float f = r;
+	if (min > max) {
+		if (f < max)
+			f = max;
+		if (f > min)
+			f = min;
+	} else {
+		if (f < min)
+			f = min;
+		if (f > max)
+			f = max;
+	}
+
+	return f;
+}
+
+std::string legacy_convert_to_degree(float value, float min, float max, bool zoom)
+{
+	float r = value;
+
+	if (zoom) {
+		if ((max-min) != 0) {
+			float pv = (r-min) / (max - min);
+			pv *= 100;
+			float iv = (float) floor(pv + 0.5);
+			r = (float) iv;
+			if (r > 100)
+				r = 100.0;
+			if (r < 0)
+				r = 0.0;
+		}
+	} else {
+		float mid = 0;
+		float frange;
+
+		if (max < 0) {
+			if (min < 0) {
+				frange = min + max;
+				mid = min + frange/2;
+			} else {
+				frange = min - max;
+				mid = min - frange/2;
+			}
+		} else {
+			if (min > 0) {
+				frange = max + min;
+				mid = min - frange/2;
+			} else {
+				frange = max - min;
+				mid = min + frange/2;
+			}
+		}
+
+		if (frange != 0) {
+			float pv = (r-min) / (frange);
+			r = pv;
+			r *= 360;
+			if (value < mid) {
+				r = (float) 180.0 - r;
+				r = -r;
+			} else {
+				r -= (float) 180.0;
+			}
+		}
+	}
+
+	return std::to_string(r);
+}
+
+// What a command paid before: format the joystick value, parse it again
+float legacy_to_raw(int16_t degree, float min, float max, bool zoom)
+{
+	return legacy_convert_to_raw(std::to_string(degree), min, max, zoom);
+}
+
+// What a status reply paid before: format the degree, parse it again
+float legacy_to_degree(float value, float min, float max, bool zoom)
+{
+	return std::stof(legacy_convert_to_degree(value, min, max, zoom));
+}
+
+class Range {
+public:
+	float min_;
+	float max_;
+	bool zoom_;
+};
+
+const Range ranges[] = {
+	{ -1.0f, 1.0f, false },
+	{ 1.0f, -1.0f, false },
+	{ -180.0f, 180.0f, false },
+	{ -90.0f, 0.0f, false },
+	{ 0.0f, -90.0f, false },
+	{ 0.0f, 360.0f, false },
+	{ 350.0f, 10.0f, false },
+	{ -350.0f, -10.0f, false },
+	{ 0.0f, 1.0f, true },
+	{ 1.0f, 0.0f, true },
+	{ 1.0f, 9999.0f, true },
+	{ 9999.0f, 1.0f, true }
+};
+
+enum {
+	Ranges = sizeof(ranges) / sizeof(ranges[0]),
+	Values = 64
+};
+
+int16_t command_value(uint32_t i, bool zoom)
+{
+	return zoom ? (int16_t) (i % 101) : (int16_t) ((int32_t) (i % 361) - 180);
+}
+
+// Camera values spread over the range, a little past both ends
+float camera_value(uint32_t i, const Range& range)
+{
+	return range.min_ + (range.max_ - range.min_) * ((int32_t) (i % (Values + 5)) - 2) / Values;
+}
+
+void to_raw_string(State& state)
+{
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		const Range& range = ranges[i % Ranges];
+		do_not_optimize(legacy_to_raw(command_value(i, range.zoom_), range.min_, range.max_, range.zoom_));
+		i++;
+	}
+}
+MICROBENCH(to_raw_string);
+
+void to_raw_numeric(State& state)
+{
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		const Range& range = ranges[i % Ranges];
+		do_not_optimize(AxisConversion::to_raw(command_value(i, range.zoom_), range.min_, range.max_, range.zoom_));
+		i++;
+	}
+}
+MICROBENCH(to_raw_numeric);
+
+void to_degree_string(State& state)
+{
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		const Range& range = ranges[i % Ranges];
+		do_not_optimize(legacy_to_degree(camera_value(i, range), range.min_, range.max_, range.zoom_));
+		i++;
+	}
+}
+MICROBENCH(to_degree_string);
+
+void to_degree_numeric(State& state)
+{
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		const Range& range = ranges[i % Ranges];
+		do_not_optimize(AxisConversion::to_degree(camera_value(i, range), range.min_, range.max_, range.zoom_));
+		i++;
+	}
+}
+MICROBENCH(to_degree_numeric);
+
+// std::to_string keeps 6 decimals, the degree differs by at most its rounding
+void equivalence_to_raw(State& state)
+{
+	float worst = 0;
+	while (state.keep_running()) {
+		worst = 0;
+		for (uint32_t r = 0; r < Ranges; r++) {
+			const Range& range = ranges[r];
+			for (uint32_t i = 0; i < (range.zoom_ ? 101u : 361u); i++) {
+				int16_t value = command_value(i, range.zoom_);
+				float diff = fabsf(legacy_to_raw(value, range.min_, range.max_, range.zoom_) - AxisConversion::to_raw(value, range.min_, range.max_, range.zoom_));
+				if (diff > worst)
+					worst = diff;
+			}
+		}
+	}
+
+	char label[64];
+	snprintf(label, sizeof(label), "max diff %g", worst);
+	state.set_label(label);
+	if (worst != 0)
+		state.set_error(label);
+}
+MICROBENCH(equivalence_to_raw);
+
+void equivalence_to_degree(State& state)
+{
+	float worst = 0;
+	while (state.keep_running()) {
+		worst = 0;
+		for (uint32_t r = 0; r < Ranges; r++) {
+			const Range& range = ranges[r];
+			for (uint32_t i = 0; i < Values + 5; i++) {
+				float value = camera_value(i, range);
+				float diff = fabsf(legacy_to_degree(value, range.min_, range.max_, range.zoom_) - AxisConversion::to_degree(value, range.min_, range.max_, range.zoom_));
+				if (diff > worst)
+					worst = diff;
+			}
+		}
+	}
+
+	char label[64];
+	snprintf(label, sizeof(label), "max diff %g", worst);
+	state.set_label(label);
+	if (worst > 1e-5f)
+		state.set_error(label);
+}
+MICROBENCH(equivalence_to_degree);
+
+}
@@ -0,0 +1,259 @@
+// Per command CPU of the conversion and dispatch paths, no device involved.
+//
+//   g++ -std=c++11 -O2 -Wall -Wextra -I<include root> -o bench_hotpath
+//       bench/microbench.cpp bench/bench_hotpath.cpp axisconversion.cpp coalescer.cpp fovmodel.cpp
+//   ./bench_hotpath [filter] [min seconds]
+//
+// convert_to_raw, convert_to_degree, calculate_range and the scaling of
+// scale_cam_rel_values live in AxisConversion. The type switch of control()
+// ends in a SOAP request and is measured against a mock device by
+// bench_onvif, here the switches every queued command passes through before
+// it (CommandCoalescer).
+#include <streamer/processor/ptz/bench/microbench.h>
+#include <streamer/processor/ptz/axisconversion.h>
+#include <streamer/processor/ptz/coalescer.h>
+#include <streamer/processor/ptz/fovmodel.h>
+#include <streamer/processor/ptz/ptzcontrol.h>
+#include <streamer/processor/ptz/ptzposition.h>
+#include <streamer/processor/ptz/seqlock.h>
+
+using namespace orion::streamer::processor;
+using namespace orion::streamer::processor::bench;
+
+namespace {
+
+// Axis limits reported by real devices, inverted ones have min > max
+class Range {
+public:
+	const char* name_;
+	float min_;
+	float max_;
+};
+
+const Range pan_tilt_ranges[] = {
+	{ "generic", -1.0f, 1.0f },
+	{ "generic inverted", 1.0f, -1.0f },
+	{ "degrees", -180.0f, 180.0f },
+	{ "tilt below horizon", -90.0f, 0.0f },
+	{ "tilt inverted", 0.0f, -90.0f },
+	{ "positive only", 0.0f, 360.0f },
+	{ "positive inverted", 350.0f, 10.0f },
+	{ "negative only", -350.0f, -10.0f }
+};
+
+const Range zoom_ranges[] = {
+	{ "zoom generic", 0.0f, 1.0f },
+	{ "zoom inverted", 1.0f, 0.0f },
+	{ "zoom steps", 1.0f, 9999.0f },
+	{ "zoom steps inverted", 9999.0f, 1.0f }
+};
+
+enum {
+	PanTiltRanges = sizeof(pan_tilt_ranges) / sizeof(pan_tilt_ranges[0]),
+	ZoomRanges = sizeof(zoom_ranges) / sizeof(zoom_ranges[0]),
+	Values = 64
+};
+
+// Joystick values as control() receives them
+float degree_values[Values];
+float percent_values[Values];
+
+void prepare()
+{
+	static bool prepared = false;
+	if (prepared)
+		return;
+
+	for (int i = 0; i < Values; i++) {
+		degree_values[i] = -180.0f + i * (360.0f / (Values - 1));
+		percent_values[i] = i * (100.0f / (Values - 1));
+	}
+	prepared = true;
+}
+
+void to_raw_pan_tilt(State& state)
+{
+	prepare();
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		const Range& range = pan_tilt_ranges[i % PanTiltRanges];
+		do_not_optimize(AxisConversion::to_raw(degree_values[i % Values], range.min_, range.max_, false));
+		i++;
+	}
+}
+MICROBENCH(to_raw_pan_tilt);
+
+void to_raw_pan_tilt_inverted(State& state)
+{
+	prepare();
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		do_not_optimize(AxisConversion::to_raw(degree_values[i % Values], 1.0f, -1.0f, false));
+		i++;
+	}
+}
+MICROBENCH(to_raw_pan_tilt_inverted);
+
+void to_raw_zoom(State& state)
+{
+	prepare();
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		const Range& range = zoom_ranges[i % ZoomRanges];
+		do_not_optimize(AxisConversion::to_raw(percent_values[i % Values], range.min_, range.max_, true));
+		i++;
+	}
+}
+MICROBENCH(to_raw_zoom);
+
+void to_degree_pan_tilt(State& state)
+{
+	prepare();
+	float raw[PanTiltRanges][Values];
+	for (int r = 0; r < PanTiltRanges; r++)
+		for (int v = 0; v < Values; v++)
+			raw[r][v] = AxisConversion::to_raw(degree_values[v], pan_tilt_ranges[r].min_, pan_tilt_ranges[r].max_, false);
+
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		uint32_t r = i % PanTiltRanges;
+		do_not_optimize(AxisConversion::to_degree(raw[r][i % Values], pan_tilt_ranges[r].min_, pan_tilt_ranges[r].max_, false));
+		i++;
+	}
+}
+MICROBENCH(to_degree_pan_tilt);
+
+void to_degree_zoom(State& state)
+{
+	prepare();
+	float raw[ZoomRanges][Values];
+	for (int r = 0; r < ZoomRanges; r++)
+		for (int v = 0; v < Values; v++)
+			raw[r][v] = AxisConversion::to_raw(percent_values[v], zoom_ranges[r].min_, zoom_ranges[r].max_, true);
+
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		uint32_t r = i % ZoomRanges;
+		do_not_optimize(AxisConversion::to_degree(raw[r][i % Values], zoom_ranges[r].min_, zoom_ranges[r].max_, true));
+		i++;
+	}
+}
+MICROBENCH(to_degree_zoom);
+
+void calculate_range(State& state)
+{
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		const Range& range = pan_tilt_ranges[i % PanTiltRanges];
+		do_not_optimize(AxisConversion::range(range.min_, range.max_));
+		i++;
+	}
+}
+MICROBENCH(calculate_range);
+
+// scale_cam_rel_values() without the lookup of the axis table
+void scale_relative(State& state)
+{
+	prepare();
+	float ranges[PanTiltRanges];
+	for (int r = 0; r < PanTiltRanges; r++)
+		ranges[r] = AxisConversion::range(pan_tilt_ranges[r].min_, pan_tilt_ranges[r].max_);
+
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		do_not_optimize(AxisConversion::relative(degree_values[i % Values], ranges[i % PanTiltRanges], (i & 3) == 0));
+		i++;
+	}
+}
+MICROBENCH(scale_relative);
+
+// Type switch every queued command passes
+void command_kind(State& state)
+{
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		do_not_optimize(CommandCoalescer::kind((uint8_t) (i % 32)));
+		i++;
+	}
+}
+MICROBENCH(command_kind);
+
+// A burst of joystick steps, each merged into the pending command
+void command_merge_relative(State& state)
+{
+	static const uint8_t steps[] = { PtzControl::Type::PanPlus, PtzControl::Type::TiltMinus, PtzControl::Type::Pan, PtzControl::Type::PanTilt };
+
+	Data pending;
+	pending.set("camera", "", PtzControl::Type::Pan, 10);
+	Data incoming[4];
+	for (int s = 0; s < 4; s++)
+		incoming[s].set("camera", "", steps[s], 5, 5);
+
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		do_not_optimize(CommandCoalescer::merge(pending, incoming[i & 3]));
+		i++;
+	}
+}
+MICROBENCH(command_merge_relative);
+
+// A barrier does not merge and leaves the pending command alone
+void command_merge_barrier(State& state)
+{
+	Data pending;
+	pending.set("camera", "", PtzControl::Type::PanPlus);
+	Data incoming;
+	incoming.set("camera", "", PtzControl::Type::GotoPreset, 0, 0, 0, 0, 0, 1);
+
+	while (state.keep_running())
+		do_not_optimize(CommandCoalescer::merge(pending, incoming));
+}
+MICROBENCH(command_merge_barrier);
+
+// Every command and status reply publishes the position
+void position_store(State& state)
+{
+	SeqLock<PtzPosition> lock;
+	PtzPosition position;
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		position.pan_ = (float) i++;
+		lock.store(position);
+	}
+	do_not_optimize(lock.version());
+}
+MICROBENCH(position_store);
+
+void position_load(State& state)
+{
+	SeqLock<PtzPosition> lock;
+	PtzPosition position;
+	position.timestamp_us_ = 1;
+	lock.store(position);
+
+	while (state.keep_running()) {
+		PtzPosition loaded = lock.load();
+		do_not_optimize(loaded);
+	}
+}
+MICROBENCH(position_load);
+
+// SelectiveZoom and tracking turn an image point into pan/tilt
+void fov_center(State& state)
+{
+	prepare();
+	FovModel model(60.0f, 3.0f, 16.0f / 9.0f);
+
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		float pan = 0, tilt = 0;
+		float x = (i % Values) / (float) Values * 2 - 1;
+		model.center(x, -x / 2, percent_values[i % Values] / 100, 20.0f, pan, tilt);
+		do_not_optimize(pan);
+		do_not_optimize(tilt);
+		i++;
+	}
+}
+MICROBENCH(fov_center);
+
+}
@@ -0,0 +1,415 @@
+// End to end OnvifControl against MockOnvifServer on loopback: control()
+// latency per PtzControl::Type, cold init() until Connected and commands per
+// second over several cameras through PtzDispatcher.
+//
+//   g++ -std=c++11 -O2 -Wall -Wextra -I<include root> -o bench_onvif bench/microbench.cpp bench/mockonvifserver.cpp bench/simulatedcamera.cpp
+//       bench/bench_onvif.cpp <ptz sources> <generated ONVIF proxies> <streamer common and core> -lcrypto -lpthread
+//   ./bench_onvif [filter] [min seconds]
+//
+// The device answers after LatencyMs and moves a -1 to 1 axis at one unit per
+// second, so a control() of a move includes the GetStatus polls of
+// MoveTracker until the device reports Idle. Nothing is random, differences
+// between runs come from scheduling only. Allocations are those of the whole
+// process, the mock device included. init_cold removes the PtzCache entry of
+// the device before every start. control_* fail the program when control()
+// fails, labels show exact percentiles in microseconds and SOAP requests per
+// command. calibrate_onvif runs OnvifControl::calibrate() on the mock device
+// with the feature located by a SimulatedCamera at the device position and
+// fails the program when the result is off as bench_calibration does.
+#include <streamer/processor/ptz/bench/microbench.h>
+#include <streamer/processor/ptz/bench/mockonvifserver.h>
+#include <streamer/processor/ptz/bench/simulatedcamera.h>
+#include <streamer/processor/ptz/onvifcontrol.h>
+#include <streamer/processor/ptz/ptzcache.h>
+#include <streamer/processor/ptz/ptzdispatcher.h>
+#include <streamer/core/camera.h>
+#include <math.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace orion::streamer;
+using namespace orion::streamer::processor;
+using namespace orion::streamer::processor::bench;
+
+namespace {
+
+enum {
+	LatencyMs = 2,
+	ConnectTimeoutMs = 10000,
+	MaxCameras = 32
+};
+
+typedef std::chrono::steady_clock clock_t;
+
+MockOnvifConfig device_config()
+{
+	MockOnvifConfig config;
+	config.latency_ms_ = LatencyMs;
+	config.pan_tilt_speed_ = 1.0f;
+	config.zoom_speed_ = 0.5f;
+	config.move_ms_ = 20;
+	return config;
+}
+
+std::string cache_key(const MockOnvifServer& server)
+{
+	return "127.0.0.1:" + std::to_string(server.port());
+}
+
+// A mock device and the OnvifControl connected to it
+class Device {
+public:
+	Device(const std::string& name)
+		: server_(device_config())
+	{
+		server_.start();
+		PtzCache().remove(cache_key(server_));
+		PtzCache().remove_calibration(cache_key(server_));
+
+		camera_.name = name;
+		camera_.ptz_control_ip = "127.0.0.1";
+		camera_.ptz_control_port = server_.port();
+		camera_.username = "admin";
+		camera_.password = "password123";
+	}
+
+	~Device()
+	{
+		control_.reset();
+		PtzCache().remove(cache_key(server_));
+		PtzCache().remove_calibration(cache_key(server_));
+	}
+
+	// Starts OnvifControl, false when it did not connect in time
+	bool connect()
+	{
+		control_ = std::make_shared<OnvifControl>(&camera_, "onvif", common::Logger::logger_t());
+		clock_t::time_point deadline = clock_t::now() + std::chrono::milliseconds(ConnectTimeoutMs);
+		while (OnvifControl::Connected != control_->init_state()) {
+			if (clock_t::now() > deadline)
+				return false;
+			usleep(100);
+		}
+		return true;
+	}
+
+	MockOnvifServer server_;
+	Camera camera_;
+	std::shared_ptr<OnvifControl> control_;
+};
+
+// Connected once and shared by the control_ benchmarks, presets 1 and 2 exist
+Device* shared_device()
+{
+	static std::unique_ptr<Device> device;
+	if (!device) {
+		device.reset(new Device("camera"));
+		if (!device->connect())
+			return NULL;
+
+		uint16_t tokens[] = { 1, 2 };
+		float pans[] = { -0.5f, 0.5f };
+		for (int i = 0; i < 2; i++) {
+			device->server_.set_position(pans[i], 0, 0);
+			data_ptr_t data = std::make_shared<Data>();
+			data->set("camera", "", PtzControl::Type::SetPreset, 0, 0, 0, 0, 0, tokens[i]);
+			device->control_->control(data);
+		}
+		device->server_.set_position(0, 0, 0);
+	}
+	return device.get();
+}
+
+uint64_t percentile(const std::vector<uint32_t>& sorted, double p)
+{
+	return sorted.empty() ? 0 : sorted[std::min(sorted.size() - 1, (size_t) (sorted.size() * p / 100.0))];
+}
+
+// Even iterations send even with the given values, odd ones odd with the
+// values negated and the next preset token, so moves go back and forth
+void control(State& state, uint8_t even, uint8_t odd, int16_t pan, int16_t tilt, int16_t zoom, uint16_t token = 0)
+{
+	state.pause();
+	Device* device = shared_device();
+	if (!device) {
+		state.set_error("device did not connect");
+		while (state.keep_running())
+			;
+		return;
+	}
+	device->server_.reset_counters();
+	std::vector<uint32_t> latency_us;
+	latency_us.reserve(state.iterations());
+	state.resume();
+
+	uint32_t i = 0, failed = 0;
+	while (state.keep_running()) {
+		bool flip = (i & 1) != 0;
+		data_ptr_t data = std::make_shared<Data>();
+		data->set("camera", "", flip ? odd : even, flip ? -pan : pan, flip ? -tilt : tilt, flip ? -zoom : zoom,
+			0, 0, (token && flip) ? token + 1 : token);
+		if (PtzControl::Type::SelectiveZoom == data->type) {
+			// A click pan pixels right or left of the center of a 1920x1080 image
+			data->spos_x = data->epos_x = 960 + data->pan;
+			data->spos_y = data->epos_y = 540;
+			data->width = 1920;
+			data->height = 1080;
+		}
+
+		clock_t::time_point start = clock_t::now();
+		if (!device->control_->control(data))
+			failed++;
+		latency_us.push_back((uint32_t) std::chrono::duration_cast<std::chrono::microseconds>(clock_t::now() - start).count());
+		i++;
+	}
+
+	std::sort(latency_us.begin(), latency_us.end());
+	char label[128];
+	snprintf(label, sizeof(label), "p50 %llu p90 %llu p99 %llu max %llu us, %.1f req/op",
+		(unsigned long long) percentile(latency_us, 50), (unsigned long long) percentile(latency_us, 90),
+		(unsigned long long) percentile(latency_us, 99), (unsigned long long) (latency_us.empty() ? 0 : latency_us.back()),
+		i ? (double) device->server_.requests() / i : 0.0);
+	state.set_label(label);
+	if (failed)
+		state.set_error(std::to_string(failed) + " of " + std::to_string(i) + " commands failed");
+}
+
+void control_get_position(State& state) { control(state, PtzControl::Type::GetPanTiltZoomPos, PtzControl::Type::GetPanTiltZoomPos, 0, 0, 0); }
+MICROBENCH(control_get_position);
+
+void control_pan(State& state) { control(state, PtzControl::Type::Pan, PtzControl::Type::Pan, 10, 0, 0); }
+MICROBENCH(control_pan);
+
+void control_tilt(State& state) { control(state, PtzControl::Type::Tilt, PtzControl::Type::Tilt, 0, 10, 0); }
+MICROBENCH(control_tilt);
+
+void control_zoom(State& state) { control(state, PtzControl::Type::Zoom, PtzControl::Type::Zoom, 0, 0, 10); }
+MICROBENCH(control_zoom);
+
+void control_pan_tilt(State& state) { control(state, PtzControl::Type::PanTilt, PtzControl::Type::PanTilt, 10, 10, 0); }
+MICROBENCH(control_pan_tilt);
+
+void control_pan_tilt_zoom(State& state) { control(state, PtzControl::Type::PanTiltZoom, PtzControl::Type::PanTiltZoom, 10, 10, 10); }
+MICROBENCH(control_pan_tilt_zoom);
+
+void control_pan_abs(State& state) { control(state, PtzControl::Type::PanAbs, PtzControl::Type::PanAbs, 45, 0, 0); }
+MICROBENCH(control_pan_abs);
+
+void control_tilt_abs(State& state) { control(state, PtzControl::Type::TiltAbs, PtzControl::Type::TiltAbs, 0, 45, 0); }
+MICROBENCH(control_tilt_abs);
+
+void control_zoom_abs(State& state) { control(state, PtzControl::Type::ZoomAbs, PtzControl::Type::ZoomAbs, 0, 0, 50); }
+MICROBENCH(control_zoom_abs);
+
+void control_pan_tilt_abs(State& state) { control(state, PtzControl::Type::PanTiltAbs, PtzControl::Type::PanTiltAbs, 45, 45, 0); }
+MICROBENCH(control_pan_tilt_abs);
+
+void control_pan_tilt_zoom_abs(State& state) { control(state, PtzControl::Type::PanTiltZoomAbs, PtzControl::Type::PanTiltZoomAbs, 45, 45, 50); }
+MICROBENCH(control_pan_tilt_zoom_abs);
+
+void control_pan_plus_minus(State& state) { control(state, PtzControl::Type::PanPlus, PtzControl::Type::PanMinus, 0, 0, 0); }
+MICROBENCH(control_pan_plus_minus);
+
+void control_tilt_plus_minus(State& state) { control(state, PtzControl::Type::TiltPlus, PtzControl::Type::TiltMinus, 0, 0, 0); }
+MICROBENCH(control_tilt_plus_minus);
+
+void control_zoom_plus_minus(State& state) { control(state, PtzControl::Type::ZoomPlus, PtzControl::Type::ZoomMinus, 0, 0, 0); }
+MICROBENCH(control_zoom_plus_minus);
+
+void control_goto_preset(State& state) { control(state, PtzControl::Type::GotoPreset, PtzControl::Type::GotoPreset, 0, 0, 0, 1); }
+MICROBENCH(control_goto_preset);
+
+void control_goto_home(State& state) { control(state, PtzControl::Type::GotoHomePosition, PtzControl::Type::PanAbs, 45, 0, 0); }
+MICROBENCH(control_goto_home);
+
+void control_set_preset(State& state) { control(state, PtzControl::Type::SetPreset, PtzControl::Type::SetPreset, 0, 0, 0, 1); }
+MICROBENCH(control_set_preset);
+
+void control_get_presets(State& state) { control(state, PtzControl::Type::GetPresets, PtzControl::Type::GetPresets, 0, 0, 0); }
+MICROBENCH(control_get_presets);
+
+void control_set_home(State& state) { control(state, PtzControl::Type::SetHomePosition, PtzControl::Type::SetHomePosition, 0, 0, 0); }
+MICROBENCH(control_set_home);
+
+void control_selective_zoom(State& state) { control(state, PtzControl::Type::SelectiveZoom, PtzControl::Type::SelectiveZoom, 200, 0, 0); }
+MICROBENCH(control_selective_zoom);
+
+void control_focus(State& state) { control(state, PtzControl::Type::FocusNear, PtzControl::Type::FocusStop, 0, 0, 0); }
+MICROBENCH(control_focus);
+
+// Construction until Connected without a cached configuration, discovery and
+// GetDeviceInformation
+void init_cold(State& state)
+{
+	std::vector<uint32_t> connect_us;
+	connect_us.reserve(state.iterations());
+	uint32_t failed = 0;
+
+	while (state.keep_running()) {
+		state.pause();
+		std::unique_ptr<Device> device(new Device("camera"));
+		state.resume();
+
+		clock_t::time_point start = clock_t::now();
+		if (!device->connect())
+			failed++;
+		connect_us.push_back((uint32_t) std::chrono::duration_cast<std::chrono::microseconds>(clock_t::now() - start).count());
+
+		state.pause();
+		device.reset();
+		state.resume();
+	}
+
+	std::sort(connect_us.begin(), connect_us.end());
+	char label[96];
+	snprintf(label, sizeof(label), "p50 %llu p99 %llu us", (unsigned long long) percentile(connect_us, 50), (unsigned long long) percentile(connect_us, 99));
+	state.set_label(label);
+	if (failed)
+		state.set_error(std::to_string(failed) + " cameras did not connect");
+}
+MICROBENCH(init_cold);
+
+// One iteration sends a command to each of the cameras at once and waits for
+// all of them, as one client per camera would
+void throughput(State& state, uint32_t cameras, uint8_t type)
+{
+	state.pause();
+	static std::vector<std::unique_ptr<Device> > devices;
+	while (devices.size() < cameras) {
+		devices.push_back(std::unique_ptr<Device>(new Device("camera" + std::to_string(devices.size()))));
+		if (!devices.back()->connect()) {
+			state.set_error("device did not connect");
+			devices.pop_back();
+			while (state.keep_running())
+				;
+			return;
+		}
+	}
+
+	PtzDispatcher dispatcher;
+	for (uint32_t c = 0; c < cameras; c++)
+		dispatcher.add_camera(devices[c]->camera_.name, devices[c]->control_);
+
+	std::mutex mutex;
+	std::condition_variable done;
+	uint32_t pending = 0, failed = 0;
+	CameraControl::callback_t complete = [&](const data_ptr_t&, const ControlResult& result) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (!result.success_)
+			failed++;
+		if (!--pending)
+			done.notify_all();
+	};
+	state.resume();
+
+	uint32_t i = 0;
+	clock_t::time_point start = clock_t::now();
+	while (state.keep_running()) {
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			pending = cameras;
+		}
+		for (uint32_t c = 0; c < cameras; c++) {
+			data_ptr_t data = std::make_shared<Data>();
+			data->set(devices[c]->camera_.name, "", (PtzControl::Type::PanPlus == type && (i & 1)) ? (uint8_t) PtzControl::Type::PanMinus : type);
+			if (!dispatcher.dispatch(data, complete)) {
+				std::lock_guard<std::mutex> lock(mutex);
+				failed++;
+				if (!--pending)
+					done.notify_all();
+			}
+		}
+
+		std::unique_lock<std::mutex> lock(mutex);
+		done.wait(lock, [&] { return !pending; });
+		i++;
+	}
+	double seconds = std::chrono::duration<double>(clock_t::now() - start).count();
+
+	state.pause();
+	dispatcher.stop();
+	state.resume();
+
+	char label[64];
+	snprintf(label, sizeof(label), "%.0f commands/s", seconds > 0 ? i * cameras / seconds : 0.0);
+	state.set_label(label);
+	if (failed)
+		state.set_error(std::to_string(failed) + " commands failed");
+}
+
+void throughput_status_1(State& state) { throughput(state, 1, PtzControl::Type::GetPanTiltZoomPos); }
+MICROBENCH(throughput_status_1);
+
+void throughput_status_8(State& state) { throughput(state, 8, PtzControl::Type::GetPanTiltZoomPos); }
+MICROBENCH(throughput_status_8);
+
+void throughput_status_32(State& state) { throughput(state, MaxCameras, PtzControl::Type::GetPanTiltZoomPos); }
+MICROBENCH(throughput_status_32);
+
+void throughput_move_8(State& state) { throughput(state, 8, PtzControl::Type::PanPlus); }
+MICROBENCH(throughput_move_8);
+
+void throughput_move_32(State& state) { throughput(state, MaxCameras, PtzControl::Type::PanPlus); }
+MICROBENCH(throughput_move_32);
+
+// Every run starts uncalibrated on a fresh device
+void calibrate_onvif(State& state)
+{
+	const float max_error_percent = 0.5f;
+	SimulatedCamera camera;
+	float pan = 0, tilt = 0;
+	camera.feature(pan, tilt);
+
+	bool ok = true;
+	float worst = 0;
+	uint64_t requests = 0;
+	uint32_t runs = 0;
+	while (state.keep_running()) {
+		state.pause();
+		std::unique_ptr<Device> device(new Device("calibration"));
+		ok = device->connect() && ok;
+		device->control_->set_fov_model(camera.datasheet());
+		device->server_.set_position(pan - 0.1f, tilt - 0.05f, 0);
+		device->server_.reset_counters();
+		MockOnvifServer& server = device->server_;
+		std::function<bool(float&, float&)> locate = [&](float& x, float& y) {
+			float p = 0, t = 0, z = 0;
+			server.position(p, t, z);
+			return camera.locate(p, t, z, x, y);
+		};
+		state.resume();
+
+		ok = device->control_->calibrate(locate) && ok;
+
+		state.pause();
+		PtzCalibration calibration = device->control_->calibration();
+		for (uint32_t i = 0; i < calibration.fov_.samples(); i++) {
+			float zoom = 0, hfov = 0;
+			calibration.fov_.sample(i, zoom, hfov);
+			worst = fmaxf(worst, fabsf(hfov / camera.hfov(zoom) - 1) * 100);
+		}
+		float pan_scale = calibration.pan_.to_value(1) - calibration.pan_.to_value(0);
+		float tilt_scale = calibration.tilt_.to_value(1) - calibration.tilt_.to_value(0);
+		worst = fmaxf(worst, fabsf(pan_scale / camera.config().pan_degrees_ - 1) * 100);
+		worst = fmaxf(worst, fabsf(tilt_scale / camera.config().tilt_degrees_ - 1) * 100);
+		requests += server.requests();
+		runs++;
+		device.reset();
+		state.resume();
+	}
+
+	char label[64];
+	snprintf(label, sizeof(label), "error %.3f%%, %llu req/run", worst, (unsigned long long) (runs ? requests / runs : 0));
+	state.set_label(label);
+	if (!ok || worst > max_error_percent)
+		state.set_error(ok ? label : "calibration failed");
+}
+MICROBENCH(calibrate_onvif);
+
+}
@@ -0,0 +1,226 @@
+// Envelope size and CPU of the precompiled PTZ requests, bytes/op is the size
+// of the rendered envelope including the WS-Security header.
+//
+//   g++ -std=c++11 -O2 -Wall -Wextra -I<include root> -o bench_templates
+//       bench/microbench.cpp bench/bench_templates.cpp soaptemplate.cpp wssecredential.cpp -lcrypto
+//   ./bench_templates [filter] [min seconds]
+//
+// With -DBENCH_GSOAP and the generated ONVIF sources and wsseapi linked in, the
+// same requests are also serialized by gSOAP the way the proxy methods do,
+// into a string stream instead of a socket. That is the output pass only, a
+// keep-alive proxy call serializes once more to count the content length.
+#include <streamer/processor/ptz/bench/microbench.h>
+#include <streamer/processor/ptz/soaptemplate.h>
+#include <streamer/processor/ptz/wssecredential.h>
+#include <string>
+
+#ifdef BENCH_GSOAP
+#include <sstream>
+#include "soapPTZBindingProxy.h"
+#include "wsseapi.h"
+#endif
+
+using namespace orion::streamer::processor;
+using namespace orion::streamer::processor::bench;
+
+namespace {
+
+const char* profile_token = "Profile_1";
+const char* username = "admin";
+const char* password = "password123";
+
+// Joystick sized values, different every call as on a live camera
+float value(uint32_t i)
+{
+	return ((int32_t) (i % 2001) - 1000) / 1000.0f;
+}
+
+const PtzTemplates& templates()
+{
+	static PtzTemplates ptz_templates;
+	if (ptz_templates.empty())
+		ptz_templates.build(profile_token);
+	return ptz_templates;
+}
+
+// What send_request() does per call: a fresh UsernameToken, then the envelope
+void render(State& state, PtzTemplates::Request request)
+{
+	WsseCredential credential;
+	std::string header;
+	std::string body;
+
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		float values[] = { value(i), value(i + 7), value(i + 13) };
+		credential.header(username, password, header);
+		templates().get(request).render(header, values, templates().get(request).values(), body);
+		do_not_optimize(body.data());
+		i++;
+	}
+	state.set_bytes(body.size());
+}
+
+void template_get_status(State& state) { render(state, PtzTemplates::GetStatus); }
+MICROBENCH(template_get_status);
+
+void template_stop(State& state) { render(state, PtzTemplates::StopPanTilt); }
+MICROBENCH(template_stop);
+
+void template_absolute_move(State& state) { render(state, PtzTemplates::AbsoluteMovePanTiltZoom); }
+MICROBENCH(template_absolute_move);
+
+void template_relative_move(State& state) { render(state, PtzTemplates::RelativeMove); }
+MICROBENCH(template_relative_move);
+
+void template_continuous_move(State& state) { render(state, PtzTemplates::ContinuousMovePanTiltTimeout); }
+MICROBENCH(template_continuous_move);
+
+// The share of the UsernameToken in the above
+void wsse_header(State& state)
+{
+	WsseCredential credential;
+	std::string header;
+	while (state.keep_running()) {
+		credential.header(username, password, header);
+		do_not_optimize(header.data());
+	}
+	state.set_bytes(header.size());
+}
+MICROBENCH(wsse_header);
+
+#ifdef BENCH_GSOAP
+
+// Output half of a generated proxy method
+template<typename Request>
+size_t serialize(struct soap* soap, const Request& request, const char* tag, std::ostringstream& stream)
+{
+	soap_begin(soap);
+	soap->encodingStyle = NULL;
+	soap_wsse_add_UsernameTokenDigest(soap, NULL, username, password);
+
+	stream.str(std::string());
+	soap->os = &stream;
+	soap_serializeheader(soap);
+	request.soap_serialize(soap);
+	bool ok = !(soap_begin_send(soap) || soap_envelope_begin_out(soap) || soap_putheader(soap) || soap_body_begin_out(soap)
+		|| request.soap_put(soap, tag, "") || soap_body_end_out(soap) || soap_envelope_end_out(soap) || soap_end_send(soap));
+	soap->os = NULL;
+
+	size_t size = ok ? (size_t) stream.tellp() : 0;
+	soap_destroy(soap);
+	soap_end(soap);
+	return size;
+}
+
+void gsoap_get_status(State& state)
+{
+	PTZBindingProxy proxy;
+	std::ostringstream stream;
+	_tptz__GetStatus request;
+	request.ProfileToken = profile_token;
+
+	size_t size = 0;
+	while (state.keep_running())
+		size = serialize(proxy.soap, request, "tptz:GetStatus", stream);
+	state.set_bytes(size);
+}
+MICROBENCH(gsoap_get_status);
+
+void gsoap_stop(State& state)
+{
+	PTZBindingProxy proxy;
+	std::ostringstream stream;
+	bool pan_tilt = true, zoom = false;
+	_tptz__Stop request;
+	request.ProfileToken = profile_token;
+	request.PanTilt = &pan_tilt;
+	request.Zoom = &zoom;
+
+	size_t size = 0;
+	while (state.keep_running())
+		size = serialize(proxy.soap, request, "tptz:Stop", stream);
+	state.set_bytes(size);
+}
+MICROBENCH(gsoap_stop);
+
+void gsoap_absolute_move(State& state)
+{
+	PTZBindingProxy proxy;
+	std::ostringstream stream;
+	tt__PTZVector position;
+	tt__Vector2D pan_tilt;
+	tt__Vector1D zoom;
+	position.PanTilt = &pan_tilt;
+	position.Zoom = &zoom;
+	_tptz__AbsoluteMove request;
+	request.ProfileToken = profile_token;
+	request.Position = &position;
+
+	size_t size = 0;
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		pan_tilt.x = value(i);
+		pan_tilt.y = value(i + 7);
+		zoom.x = value(i + 13);
+		size = serialize(proxy.soap, request, "tptz:AbsoluteMove", stream);
+		i++;
+	}
+	state.set_bytes(size);
+}
+MICROBENCH(gsoap_absolute_move);
+
+void gsoap_relative_move(State& state)
+{
+	PTZBindingProxy proxy;
+	std::ostringstream stream;
+	tt__PTZVector translation;
+	tt__Vector2D pan_tilt;
+	tt__Vector1D zoom;
+	translation.PanTilt = &pan_tilt;
+	translation.Zoom = &zoom;
+	_tptz__RelativeMove request;
+	request.ProfileToken = profile_token;
+	request.Translation = &translation;
+
+	size_t size = 0;
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		pan_tilt.x = value(i);
+		pan_tilt.y = value(i + 7);
+		zoom.x = value(i + 13);
+		size = serialize(proxy.soap, request, "tptz:RelativeMove", stream);
+		i++;
+	}
+	state.set_bytes(size);
+}
+MICROBENCH(gsoap_relative_move);
+
+void gsoap_continuous_move(State& state)
+{
+	PTZBindingProxy proxy;
+	std::ostringstream stream;
+	tt__PTZSpeed velocity;
+	tt__Vector2D pan_tilt;
+	velocity.PanTilt = &pan_tilt;
+	LONG64 timeout = 1000;
+	_tptz__ContinuousMove request;
+	request.ProfileToken = profile_token;
+	request.Velocity = &velocity;
+	request.Timeout = &timeout;
+
+	size_t size = 0;
+	uint32_t i = 0;
+	while (state.keep_running()) {
+		pan_tilt.x = value(i);
+		pan_tilt.y = value(i + 7);
+		size = serialize(proxy.soap, request, "tptz:ContinuousMove", stream);
+		i++;
+	}
+	state.set_bytes(size);
+}
+MICROBENCH(gsoap_continuous_move);
+
+#endif
+
+}
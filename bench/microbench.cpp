@@ -0,0 +1,158 @@
+#include <streamer/processor/ptz/bench/microbench.h>
+#include <atomic>
+#include <new>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace {
+
+std::atomic<uint64_t> heap_allocs(0);
+std::atomic<uint64_t> heap_bytes(0);
+
+void* counted_alloc(size_t size)
+{
+	heap_allocs.fetch_add(1, std::memory_order_relaxed);
+	heap_bytes.fetch_add(size, std::memory_order_relaxed);
+
+	void* ptr = malloc(size ? size : 1);
+	if (!ptr)
+		throw std::bad_alloc();
+	return ptr;
+}
+
+}
+
+void* operator new(size_t size) { return counted_alloc(size); }
+void* operator new[](size_t size) { return counted_alloc(size); }
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+
+namespace orion {
+namespace streamer {
+namespace processor {
+namespace bench {
+
+double Registry::min_time_s = 0.2;
+
+uint64_t allocations()
+{
+	return heap_allocs.load(std::memory_order_relaxed);
+}
+
+uint64_t allocated_bytes()
+{
+	return heap_bytes.load(std::memory_order_relaxed);
+}
+
+State::State(uint64_t iterations)
+	: iterations_(iterations)
+	, remaining_(iterations)
+	, bytes_(0)
+	, elapsed_(0)
+	, allocs_(0)
+	, alloc_bytes_(0)
+	, running_(false)
+	, stopped_(false)
+{
+	resume();
+}
+
+void State::pause()
+{
+	if (!running_)
+		return;
+
+	elapsed_ += clock_t::now() - start_;
+	allocs_ += allocations();
+	alloc_bytes_ += allocated_bytes();
+	running_ = false;
+}
+
+void State::resume()
+{
+	if (running_)
+		return;
+
+	allocs_ -= allocations();
+	alloc_bytes_ -= allocated_bytes();
+	start_ = clock_t::now();
+	running_ = true;
+}
+
+void State::stop()
+{
+	if (!stopped_) {
+		pause();
+		stopped_ = true;
+	}
+}
+
+Registry& Registry::instance()
+{
+	static Registry registry;
+	return registry;
+}
+
+void Registry::add(const char* name, function_t function)
+{
+	Entry entry;
+	entry.name_ = name;
+	entry.function_ = function;
+	entries_.push_back(entry);
+}
+
+int Registry::run(const char* filter)
+{
+	int ret = 0;
+	printf("%-44s %12s %12s %10s %12s %10s\n", "benchmark", "iterations", "ns/op", "allocs/op", "alloc B/op", "bytes/op");
+
+	for (size_t i = 0; i < entries_.size(); i++) {
+		const Entry& entry = entries_[i];
+		if (filter && !strstr(entry.name_.c_str(), filter))
+			continue;
+
+		// Grow the iteration count until the loop runs long enough
+		uint64_t iterations = 1;
+		for (;;) {
+			State state(iterations);
+			entry.function_(state);
+			state.stop();
+
+			if (!state.error_.empty()) {
+				printf("%-44s FAILED %s\n", entry.name_.c_str(), state.error_.c_str());
+				ret = 1;
+				break;
+			}
+
+			double seconds = std::chrono::duration<double>(state.elapsed_).count();
+			if (seconds >= min_time_s || iterations >= (1ull << 40)) {
+				double n = (double) state.iterations_;
+				printf("%-44s %12llu %12.1f %10.2f %12.1f %10.1f %s\n", entry.name_.c_str(), (unsigned long long) state.iterations_,
+					seconds * 1e9 / n, state.allocs_ / n, state.alloc_bytes_ / n, (double) state.bytes_, state.label_.c_str());
+				break;
+			}
+
+			double scale = (seconds > 0) ? min_time_s * 1.4 / seconds : 100;
+			if (scale > 100)
+				scale = 100;
+			if (scale < 2)
+				scale = 2;
+			iterations = (uint64_t) (iterations * scale);
+		}
+	}
+
+	return ret;
+}
+
+}}}}
+
+int main(int argc, char** argv)
+{
+	const char* filter = (argc > 1) ? argv[1] : NULL;
+	if (argc > 2)
+		orion::streamer::processor::bench::Registry::min_time_s = atof(argv[2]);
+	return orion::streamer::processor::bench::Registry::instance().run(filter);
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <chrono>
+#include <stdint.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+namespace bench {
+
+// Minimal harness in the style of Google Benchmark for the standalone
+// benchmarks in this directory. A benchmark is a function taking a State and
+// looping while keep_running(), the iteration count grows until the loop runs
+// for at least the minimum time. Reported per iteration: time, heap
+// allocations and allocated bytes (counted by the operator new of
+// microbench.cpp) and optional processed bytes. Link microbench.cpp once per
+// benchmark program, it provides main(). The first argument selects the
+// benchmarks whose name contains it.
+class State {
+public:
+	explicit State(uint64_t iterations);
+
+	bool keep_running()
+	{
+		if (remaining_) {
+			remaining_--;
+			return true;
+		}
+		stop();
+		return false;
+	}
+
+	uint64_t iterations() const { return iterations_; }
+
+	// Exclude setup inside the loop from the measurement
+	void pause();
+
+	void resume();
+
+	// Payload produced per iteration, reported as bytes/op
+	void set_bytes(uint64_t bytes) { bytes_ = bytes; }
+
+	void set_label(const std::string& label) { label_ = label; }
+
+	// Fails the benchmark program, for checks that run alongside a measurement
+	void set_error(const std::string& error) { error_ = error; }
+
+private:
+	friend class Registry;
+
+	typedef std::chrono::steady_clock clock_t;
+
+	void stop();
+
+	uint64_t iterations_;
+	uint64_t remaining_;
+	uint64_t bytes_;
+	std::string label_;
+	std::string error_;
+
+	clock_t::time_point start_;
+	clock_t::duration elapsed_;
+	uint64_t allocs_;
+	uint64_t alloc_bytes_;
+	bool running_;
+	bool stopped_;
+};
+
+typedef void (*function_t)(State&);
+
+class Registry {
+public:
+	static Registry& instance();
+
+	void add(const char* name, function_t function);
+
+	// Runs the benchmarks whose name contains filter, returns the process exit code
+	int run(const char* filter);
+
+	static double min_time_s;
+
+private:
+	class Entry {
+	public:
+		std::string name_;
+		function_t function_;
+	};
+
+	std::vector<Entry> entries_;
+};
+
+class Registrar {
+public:
+	Registrar(const char* name, function_t function) { Registry::instance().add(name, function); }
+};
+
+// Heap operations since start, from the counting operator new
+uint64_t allocations();
+
+uint64_t allocated_bytes();
+
+// Keeps the compiler from dropping a computation whose result is unused
+template<typename T>
+inline void do_not_optimize(const T& value)
+{
+	asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void clobber_memory()
+{
+	asm volatile("" : : : "memory");
+}
+
+}}}}
+
+#define MICROBENCH_CONCAT2(a, b) a##b
+#define MICROBENCH_CONCAT(a, b) MICROBENCH_CONCAT2(a, b)
+#define MICROBENCH(function) \
+	static ::orion::streamer::processor::bench::Registrar MICROBENCH_CONCAT(microbench_, __LINE__)(#function, function)
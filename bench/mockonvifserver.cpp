@@ -0,0 +1,793 @@
+#include <streamer/processor/ptz/bench/mockonvifserver.h>
+#include <algorithm>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+namespace bench {
+
+namespace {
+
+const char* pan_tilt_position_space = "http://www.onvif.org/ver10/tptz/PanTiltSpaces/PositionGenericSpace";
+const char* pan_tilt_translation_space = "http://www.onvif.org/ver10/tptz/PanTiltSpaces/TranslationGenericSpace";
+const char* pan_tilt_velocity_space = "http://www.onvif.org/ver10/tptz/PanTiltSpaces/VelocityGenericSpace";
+const char* zoom_position_space = "http://www.onvif.org/ver10/tptz/ZoomSpaces/PositionGenericSpace";
+const char* zoom_translation_space = "http://www.onvif.org/ver10/tptz/ZoomSpaces/TranslationGenericSpace";
+const char* zoom_velocity_space = "http://www.onvif.org/ver10/tptz/ZoomSpaces/VelocityGenericSpace";
+
+enum {
+	// Largest request accepted, ONVIF requests are a few kB
+	MaxRequest = 1 << 20
+};
+
+// Next start tag at or after from whose local name is local (any when NULL),
+// begin/end span the tag from '<' to past '>'
+bool find_tag(const std::string& xml, const char* local, size_t from, size_t& begin, size_t& end, std::string* name = NULL)
+{
+	size_t length = local ? strlen(local) : 0;
+	while ((begin = xml.find('<', from)) != std::string::npos) {
+		from = begin + 1;
+		if (from >= xml.size() || xml[from] == '/' || xml[from] == '?' || xml[from] == '!')
+			continue;
+
+		size_t name_end = xml.find_first_of(" \t\r\n/>", from);
+		if (name_end == std::string::npos)
+			return false;
+		size_t colon = xml.find(':', from);
+		size_t local_begin = (colon != std::string::npos && colon < name_end) ? colon + 1 : from;
+
+		if (!local || (name_end - local_begin == length && !xml.compare(local_begin, length, local))) {
+			end = xml.find('>', name_end);
+			if (end == std::string::npos)
+				return false;
+			end++;
+			if (name)
+				*name = xml.substr(local_begin, name_end - local_begin);
+			return true;
+		}
+	}
+	return false;
+}
+
+// Attribute of the start tag spanning begin - end
+bool attribute(const std::string& xml, size_t begin, size_t end, const char* name, float& value)
+{
+	std::string key = std::string(" ") + name + "=\"";
+	size_t at = xml.find(key, begin);
+	if (at == std::string::npos || at >= end)
+		return false;
+
+	char* parsed = NULL;
+	const char* start = xml.c_str() + at + key.size();
+	float v = strtof(start, &parsed);
+	if (parsed == start)
+		return false;
+	value = v;
+	return true;
+}
+
+// Text of the first element named local after from
+bool text(const std::string& xml, const char* local, size_t from, std::string& value)
+{
+	size_t begin = 0, end = 0;
+	if (!find_tag(xml, local, from, begin, end) || xml[end - 2] == '/')
+		return false;
+
+	size_t close = xml.find('<', end);
+	if (close == std::string::npos)
+		return false;
+	value = xml.substr(end, close - end);
+	return true;
+}
+
+// xs:duration as used for PTZ timeouts, e.g. "PT1.5S" or "PT1M"
+uint32_t duration_ms(const std::string& duration)
+{
+	const char* p = duration.c_str();
+	if (strncmp(p, "PT", 2))
+		return 0;
+	p += 2;
+
+	double ms = 0;
+	while (*p) {
+		char* unit = NULL;
+		double v = strtod(p, &unit);
+		if (unit == p)
+			break;
+		if (*unit == 'H')
+			ms += v * 3600000;
+		else if (*unit == 'M')
+			ms += v * 60000;
+		else if (*unit == 'S')
+			ms += v * 1000;
+		else
+			break;
+		p = unit + 1;
+	}
+	return (uint32_t) ms;
+}
+
+// Header value of name in the header block, case insensitive
+bool header(const std::string& headers, const char* name, std::string& value)
+{
+	size_t length = strlen(name);
+	size_t line = 0;
+	while ((line = headers.find("\r\n", line)) != std::string::npos) {
+		line += 2;
+		if (!strncasecmp(headers.c_str() + line, name, length) && headers[line + length] == ':') {
+			size_t begin = headers.find_first_not_of(" \t", line + length + 1);
+			size_t end = headers.find("\r\n", line);
+			if (begin == std::string::npos || end == std::string::npos || begin > end)
+				return false;
+			value = headers.substr(begin, end - begin);
+			return true;
+		}
+	}
+	return false;
+}
+
+std::string number(float value)
+{
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%g", value);
+	return buffer;
+}
+
+std::string range(float min, float max)
+{
+	return "<tt:Min>" + number(min) + "</tt:Min><tt:Max>" + number(max) + "</tt:Max>";
+}
+
+// xs:dateTime in UTC
+std::string utc_time(time_t now)
+{
+	struct tm tm;
+	gmtime_r(&now, &tm);
+	char buffer[32];
+	strftime(buffer, sizeof(buffer), "%Y-%m-%dT%H:%M:%SZ", &tm);
+	return buffer;
+}
+
+}
+
+MockOnvifServer::MockOnvifServer(const MockOnvifConfig& config /*= MockOnvifConfig()*/)
+	: config_(config)
+	, latency_ms_(config.latency_ms_)
+	, listen_fd_(-1)
+	, port_(0)
+	, stop_(false)
+	, next_preset_(1)
+	, requests_(0)
+	, connections_(0)
+{
+	float center[3] = { 0, 0, config_.zoom_min_ };
+	clamp(center);
+	for (int i = 0; i < 3; i++) {
+		motion_.from_[i] = home_[i] = center[i];
+		motion_.rate_[i] = 0;
+		motion_.end_[i] = motion_.begin_;
+	}
+}
+
+MockOnvifServer::~MockOnvifServer()
+{
+	stop();
+}
+
+bool MockOnvifServer::start()
+{
+	if (listen_fd_ >= 0)
+		return true;
+
+	listen_fd_ = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (listen_fd_ < 0)
+		return false;
+
+	struct sockaddr_in address;
+	memset(&address, 0, sizeof(address));
+	address.sin_family = AF_INET;
+	address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	address.sin_port = 0;
+
+	socklen_t length = sizeof(address);
+	if (bind(listen_fd_, (struct sockaddr*) &address, sizeof(address)) || listen(listen_fd_, 64)
+		|| getsockname(listen_fd_, (struct sockaddr*) &address, &length)) {
+		close(listen_fd_);
+		listen_fd_ = -1;
+		return false;
+	}
+
+	port_ = ntohs(address.sin_port);
+	stop_ = false;
+	accept_thread_ = std::thread(&MockOnvifServer::accept_loop, this);
+	return true;
+}
+
+void MockOnvifServer::stop()
+{
+	if (listen_fd_ < 0)
+		return;
+
+	// shutdown() wakes the threads blocked in accept() and recv()
+	stop_ = true;
+	shutdown(listen_fd_, SHUT_RDWR);
+	if (accept_thread_.joinable())
+		accept_thread_.join();
+	close(listen_fd_);
+	listen_fd_ = -1;
+
+	std::vector<std::thread> threads;
+	{
+		std::lock_guard<std::mutex> lock(connections_mutex_);
+		for (size_t i = 0; i < connection_fds_.size(); i++)
+			shutdown(connection_fds_[i], SHUT_RDWR);
+		threads.swap(connection_threads_);
+	}
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+}
+
+std::string MockOnvifServer::device_url() const
+{
+	return service_url("device_service");
+}
+
+std::string MockOnvifServer::service_url(const char* service) const
+{
+	return "http://127.0.0.1:" + std::to_string(port_) + "/onvif/" + service;
+}
+
+bool MockOnvifServer::position(float& pan, float& tilt, float& zoom) const
+{
+	std::lock_guard<std::mutex> lock(state_mutex_);
+	clock_t::time_point now = clock_t::now();
+	float p[3];
+	current(now, p);
+	pan = p[0];
+	tilt = p[1];
+	zoom = p[2];
+	return !moving(now, 0) && !moving(now, 1) && !moving(now, 2);
+}
+
+void MockOnvifServer::set_position(float pan, float tilt, float zoom)
+{
+	std::lock_guard<std::mutex> lock(state_mutex_);
+	float p[3] = { pan, tilt, zoom };
+	clamp(p);
+	motion_.begin_ = clock_t::now();
+	for (int i = 0; i < 3; i++) {
+		motion_.from_[i] = p[i];
+		motion_.rate_[i] = 0;
+		motion_.end_[i] = motion_.begin_;
+	}
+}
+
+uint64_t MockOnvifServer::requests(const std::string& operation) const
+{
+	std::lock_guard<std::mutex> lock(state_mutex_);
+	std::map<std::string, uint64_t>::const_iterator it = operations_.find(operation);
+	return (it != operations_.end()) ? it->second : 0;
+}
+
+void MockOnvifServer::reset_counters()
+{
+	std::lock_guard<std::mutex> lock(state_mutex_);
+	operations_.clear();
+	requests_ = 0;
+	connections_ = 0;
+}
+
+void MockOnvifServer::accept_loop()
+{
+	while (!stop_) {
+		int fd = accept4(listen_fd_, NULL, NULL, SOCK_CLOEXEC);
+		if (fd < 0) {
+			if (stop_)
+				break;
+			continue;
+		}
+
+		// Replies go out in one write, do not hold them back for an ACK
+		int on = 1;
+		setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+
+		connections_++;
+		std::lock_guard<std::mutex> lock(connections_mutex_);
+		connection_fds_.push_back(fd);
+		connection_threads_.push_back(std::thread(&MockOnvifServer::connection_loop, this, fd));
+	}
+}
+
+void MockOnvifServer::connection_loop(int fd)
+{
+	std::string buffer;
+	std::string path;
+	std::string request;
+	bool keep_alive = true;
+
+	while (keep_alive && !stop_ && read_request(fd, buffer, path, request, keep_alive)) {
+		// Operation is the first element in the Body
+		std::string operation;
+		size_t begin = 0, end = 0;
+		if (find_tag(request, "Body", 0, begin, end))
+			find_tag(request, NULL, end, begin, end, &operation);
+
+		std::string body;
+		int status = handle(path, operation, request, body);
+		std::string reply = envelope(body);
+
+		uint32_t latency = latency_ms_.load();
+		if (latency)
+			usleep(latency * 1000);
+
+		std::string response = "HTTP/1.1 " + std::to_string(status) + ((200 == status) ? " OK" : (400 == status) ? " Bad Request" : " Internal Server Error")
+			+ "\r\nContent-Type: application/soap+xml; charset=utf-8\r\nContent-Length: " + std::to_string(reply.size())
+			+ (keep_alive ? "\r\nConnection: keep-alive\r\n\r\n" : "\r\nConnection: close\r\n\r\n") + reply;
+		if (!write_all(fd, response))
+			break;
+	}
+
+	std::lock_guard<std::mutex> lock(connections_mutex_);
+	for (size_t i = 0; i < connection_fds_.size(); i++) {
+		if (connection_fds_[i] == fd) {
+			connection_fds_.erase(connection_fds_.begin() + i);
+			break;
+		}
+	}
+	close(fd);
+}
+
+bool MockOnvifServer::read_request(int fd, std::string& buffer, std::string& path, std::string& body, bool& keep_alive)
+{
+	char chunk[4096];
+
+	// Header block, earlier requests of the connection may have left data
+	size_t header_end = 0;
+	while ((header_end = buffer.find("\r\n\r\n")) == std::string::npos) {
+		if (buffer.size() > MaxRequest)
+			return false;
+		ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+		if (n <= 0)
+			return false;
+		buffer.append(chunk, n);
+	}
+	std::string headers = buffer.substr(0, header_end + 2);
+	buffer.erase(0, header_end + 4);
+
+	// POST /onvif/ptz_service HTTP/1.1
+	size_t path_begin = headers.find(' ');
+	size_t path_end = (path_begin != std::string::npos) ? headers.find(' ', path_begin + 1) : std::string::npos;
+	if (path_end == std::string::npos)
+		return false;
+	path = headers.substr(path_begin + 1, path_end - path_begin - 1);
+
+	std::string value;
+	bool http10 = headers.compare(path_end + 1, 8, "HTTP/1.0") == 0;
+	if (header(headers, "Connection", value))
+		keep_alive = !strcasecmp(value.c_str(), "keep-alive") || (!http10 && strcasecmp(value.c_str(), "close"));
+	else
+		keep_alive = !http10;
+
+	body.clear();
+	if (header(headers, "Transfer-Encoding", value) && !strcasecmp(value.c_str(), "chunked")) {
+		while (true) {
+			size_t line_end = 0;
+			while ((line_end = buffer.find("\r\n")) == std::string::npos) {
+				ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+				if (n <= 0)
+					return false;
+				buffer.append(chunk, n);
+			}
+			size_t size = strtoul(buffer.c_str(), NULL, 16);
+			if (body.size() + size > MaxRequest)
+				return false;
+			while (buffer.size() < line_end + 2 + size + 2) {
+				ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+				if (n <= 0)
+					return false;
+				buffer.append(chunk, n);
+			}
+			body.append(buffer, line_end + 2, size);
+			buffer.erase(0, line_end + 2 + size + 2);
+			if (!size)
+				return true;
+		}
+	}
+
+	size_t length = header(headers, "Content-Length", value) ? strtoul(value.c_str(), NULL, 10) : 0;
+	if (length > MaxRequest)
+		return false;
+	while (buffer.size() < length) {
+		ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+		if (n <= 0)
+			return false;
+		buffer.append(chunk, n);
+	}
+	body = buffer.substr(0, length);
+	buffer.erase(0, length);
+	return true;
+}
+
+bool MockOnvifServer::write_all(int fd, const std::string& data)
+{
+	size_t sent = 0;
+	while (sent < data.size()) {
+		ssize_t n = send(fd, data.data() + sent, data.size() - sent, MSG_NOSIGNAL);
+		if (n <= 0)
+			return false;
+		sent += n;
+	}
+	return true;
+}
+
+int MockOnvifServer::handle(const std::string& path, const std::string& operation, const std::string& request, std::string& reply)
+{
+	requests_++;
+	{
+		std::lock_guard<std::mutex> lock(state_mutex_);
+		operations_[operation]++;
+	}
+
+	if (operation.empty())
+		return fault(true, "ter:InvalidArgVal", NULL, "No operation in the body", reply);
+
+	if (path.find("/ptz") != std::string::npos)
+		return ptz(operation, request, reply);
+	if (path.find("/media") != std::string::npos)
+		return media(operation, reply);
+	if (path.find("/imaging") != std::string::npos)
+		return imaging(operation, reply);
+	return device(operation, reply);
+}
+
+int MockOnvifServer::device(const std::string& operation, std::string& reply)
+{
+	if ("GetCapabilities" == operation) {
+		reply = "<tds:GetCapabilitiesResponse><tds:Capabilities>"
+			"<tt:Device><tt:XAddr>" + service_url("device_service") + "</tt:XAddr></tt:Device>"
+			"<tt:Imaging><tt:XAddr>" + service_url("imaging_service") + "</tt:XAddr></tt:Imaging>"
+			"<tt:Media><tt:XAddr>" + service_url("media_service") + "</tt:XAddr><tt:StreamingCapabilities>"
+			"<tt:RTPMulticast>false</tt:RTPMulticast><tt:RTP_TCP>true</tt:RTP_TCP><tt:RTP_RTSP_TCP>true</tt:RTP_RTSP_TCP>"
+			"</tt:StreamingCapabilities></tt:Media>"
+			"<tt:PTZ><tt:XAddr>" + service_url("ptz_service") + "</tt:XAddr></tt:PTZ>"
+			"</tds:Capabilities></tds:GetCapabilitiesResponse>";
+	} else if ("GetDeviceInformation" == operation) {
+		reply = "<tds:GetDeviceInformationResponse><tds:Manufacturer>Mock</tds:Manufacturer><tds:Model>PTZ</tds:Model>"
+			"<tds:FirmwareVersion>1.0</tds:FirmwareVersion><tds:SerialNumber>" + std::to_string(port_) + "</tds:SerialNumber>"
+			"<tds:HardwareId>1</tds:HardwareId></tds:GetDeviceInformationResponse>";
+	} else if ("GetSystemDateAndTime" == operation) {
+		struct tm tm;
+		time_t now = time(NULL) + config_.clock_offset_s_;
+		gmtime_r(&now, &tm);
+		reply = "<tds:GetSystemDateAndTimeResponse><tds:SystemDateAndTime><tt:DateTimeType>Manual</tt:DateTimeType>"
+			"<tt:DaylightSavings>false</tt:DaylightSavings><tt:UTCDateTime><tt:Time><tt:Hour>" + std::to_string(tm.tm_hour)
+			+ "</tt:Hour><tt:Minute>" + std::to_string(tm.tm_min) + "</tt:Minute><tt:Second>" + std::to_string(tm.tm_sec)
+			+ "</tt:Second></tt:Time><tt:Date><tt:Year>" + std::to_string(tm.tm_year + 1900) + "</tt:Year><tt:Month>"
+			+ std::to_string(tm.tm_mon + 1) + "</tt:Month><tt:Day>" + std::to_string(tm.tm_mday)
+			+ "</tt:Day></tt:Date></tt:UTCDateTime></tds:SystemDateAndTime></tds:GetSystemDateAndTimeResponse>";
+	} else if ("SetSystemDateAndTime" == operation) {
+		reply = "<tds:SetSystemDateAndTimeResponse/>";
+	} else if ("SystemReboot" == operation) {
+		reply = "<tds:SystemRebootResponse><tds:Message>Rebooting</tds:Message></tds:SystemRebootResponse>";
+	} else {
+		return fault(false, "ter:ActionNotSupported", NULL, "Operation not supported", reply);
+	}
+	return 200;
+}
+
+int MockOnvifServer::media(const std::string& operation, std::string& reply)
+{
+	if ("GetProfiles" != operation)
+		return fault(false, "ter:ActionNotSupported", NULL, "Operation not supported", reply);
+
+	reply = "<trt:GetProfilesResponse><trt:Profiles token=\"Profile_1\" fixed=\"true\"><tt:Name>Profile_1</tt:Name>"
+		"<tt:VideoSourceConfiguration token=\"VideoSourceConfig_1\"><tt:Name>VideoSourceConfig_1</tt:Name><tt:UseCount>1</tt:UseCount>"
+		"<tt:SourceToken>VideoSource_1</tt:SourceToken><tt:Bounds x=\"0\" y=\"0\" width=\"1920\" height=\"1080\"/></tt:VideoSourceConfiguration>"
+		"<tt:VideoEncoderConfiguration token=\"VideoEncoderConfig_1\"><tt:Name>VideoEncoderConfig_1</tt:Name><tt:UseCount>1</tt:UseCount>"
+		"<tt:Encoding>H264</tt:Encoding><tt:Resolution><tt:Width>1920</tt:Width><tt:Height>1080</tt:Height></tt:Resolution>"
+		"<tt:Quality>5</tt:Quality><tt:RateControl><tt:FrameRateLimit>30</tt:FrameRateLimit><tt:EncodingInterval>1</tt:EncodingInterval>"
+		"<tt:BitrateLimit>4096</tt:BitrateLimit></tt:RateControl><tt:Multicast><tt:Address><tt:Type>IPv4</tt:Type>"
+		"<tt:IPv4Address>0.0.0.0</tt:IPv4Address></tt:Address><tt:Port>0</tt:Port><tt:TTL>0</tt:TTL><tt:AutoStart>false</tt:AutoStart>"
+		"</tt:Multicast><tt:SessionTimeout>PT60S</tt:SessionTimeout></tt:VideoEncoderConfiguration>"
+		"<tt:PTZConfiguration token=\"PTZConfig_1\"><tt:Name>PTZConfig_1</tt:Name><tt:UseCount>1</tt:UseCount><tt:NodeToken>PTZNode_1</tt:NodeToken>";
+	if (config_.ptz_timeout_ms_)
+		reply += "<tt:DefaultPTZTimeout>PT" + number(config_.ptz_timeout_ms_ / 1000.0f) + "S</tt:DefaultPTZTimeout>";
+	reply += "</tt:PTZConfiguration></trt:Profiles></trt:GetProfilesResponse>";
+	return 200;
+}
+
+int MockOnvifServer::imaging(const std::string& operation, std::string& reply)
+{
+	if ("GetMoveOptions" == operation) {
+		reply = "<timg:GetMoveOptionsResponse><timg:MoveOptions><tt:Continuous><tt:Speed>" + range(-1, 1)
+			+ "</tt:Speed></tt:Continuous></timg:MoveOptions></timg:GetMoveOptionsResponse>";
+	} else if ("GetImagingSettings" == operation) {
+		reply = "<timg:GetImagingSettingsResponse><timg:ImagingSettings><tt:Focus><tt:AutoFocusMode>MANUAL</tt:AutoFocusMode>"
+			"</tt:Focus></timg:ImagingSettings></timg:GetImagingSettingsResponse>";
+	} else if ("Move" == operation) {
+		reply = "<timg:MoveResponse/>";
+	} else if ("Stop" == operation) {
+		reply = "<timg:StopResponse/>";
+	} else {
+		return fault(false, "ter:ActionNotSupported", NULL, "Operation not supported", reply);
+	}
+	return 200;
+}
+
+int MockOnvifServer::ptz(const std::string& operation, const std::string& request, std::string& reply)
+{
+	size_t begin = 0, end = 0;
+	find_tag(request, operation.c_str(), 0, begin, end);
+
+	if ("GetStatus" == operation) {
+		reply = status_reply();
+	} else if ("GetNodes" == operation) {
+		reply = "<tptz:GetNodesResponse><tptz:PTZNode token=\"PTZNode_1\">" + node() + "</tptz:PTZNode></tptz:GetNodesResponse>";
+	} else if ("GetNode" == operation) {
+		reply = "<tptz:GetNodeResponse><tptz:PTZNode token=\"PTZNode_1\">" + node() + "</tptz:PTZNode></tptz:GetNodeResponse>";
+	} else if ("AbsoluteMove" == operation || "RelativeMove" == operation) {
+		bool relative = ("RelativeMove" == operation);
+		float target[3];
+		std::lock_guard<std::mutex> lock(state_mutex_);
+		current(clock_t::now(), target);
+
+		// Only the vector of the move, Speed follows it
+		size_t vector_begin = 0, vector_end = 0, tag_begin = 0, tag_end = 0;
+		if (find_tag(request, relative ? "Translation" : "Position", end, vector_begin, vector_end)) {
+			size_t vector_close = request.find(relative ? "Translation>" : "Position>", vector_end);
+			float value = 0;
+			if (find_tag(request, "PanTilt", vector_end, tag_begin, tag_end) && tag_begin < vector_close) {
+				if (attribute(request, tag_begin, tag_end, "x", value))
+					target[0] = relative ? target[0] + value : value;
+				if (attribute(request, tag_begin, tag_end, "y", value))
+					target[1] = relative ? target[1] + value : value;
+			}
+			if (find_tag(request, "Zoom", vector_end, tag_begin, tag_end) && tag_begin < vector_close
+				&& attribute(request, tag_begin, tag_end, "x", value))
+				target[2] = relative ? target[2] + value : value;
+		}
+		move_to(target);
+		reply = relative ? "<tptz:RelativeMoveResponse/>" : "<tptz:AbsoluteMoveResponse/>";
+	} else if ("ContinuousMove" == operation) {
+		float velocity[3] = { 0, 0, 0 };
+		size_t tag_begin = 0, tag_end = 0;
+		if (find_tag(request, "PanTilt", end, tag_begin, tag_end)) {
+			attribute(request, tag_begin, tag_end, "x", velocity[0]);
+			attribute(request, tag_begin, tag_end, "y", velocity[1]);
+		}
+		if (find_tag(request, "Zoom", end, tag_begin, tag_end))
+			attribute(request, tag_begin, tag_end, "x", velocity[2]);
+
+		std::string timeout;
+		uint32_t timeout_ms = text(request, "Timeout", end, timeout) ? duration_ms(timeout) : config_.ptz_timeout_ms_;
+
+		std::lock_guard<std::mutex> lock(state_mutex_);
+		move_at(velocity, timeout_ms);
+		reply = "<tptz:ContinuousMoveResponse/>";
+	} else if ("Stop" == operation) {
+		std::string pan_tilt, zoom;
+		bool stop_pan_tilt = !text(request, "PanTilt", end, pan_tilt) || "true" == pan_tilt;
+		bool stop_zoom = !text(request, "Zoom", end, zoom) || "true" == zoom;
+
+		std::lock_guard<std::mutex> lock(state_mutex_);
+		halt(stop_pan_tilt, stop_zoom);
+		reply = "<tptz:StopResponse/>";
+	} else if ("GetPresets" == operation) {
+		std::lock_guard<std::mutex> lock(state_mutex_);
+		reply = presets_reply();
+	} else if ("SetPreset" == operation) {
+		std::string token, name;
+		text(request, "PresetToken", end, token);
+		text(request, "PresetName", end, name);
+
+		// Like most devices a new token is taken as given, not only replaced
+		std::lock_guard<std::mutex> lock(state_mutex_);
+		if (token.empty() || !presets_.count(token)) {
+			if (presets_.size() >= config_.max_presets_)
+				return fault(false, "ter:Action", "ter:TooManyPresets", "Maximum number of presets reached", reply);
+			while (token.empty() && presets_.count(std::to_string(next_preset_)))
+				next_preset_++;
+			if (token.empty())
+				token = std::to_string(next_preset_++);
+		}
+
+		Preset& preset = presets_[token];
+		preset.name_ = name.empty() ? token : name;
+		current(clock_t::now(), preset.position_);
+		reply = "<tptz:SetPresetResponse><tptz:PresetToken>" + token + "</tptz:PresetToken></tptz:SetPresetResponse>";
+	} else if ("RemovePreset" == operation) {
+		std::string token;
+		text(request, "PresetToken", end, token);
+
+		std::lock_guard<std::mutex> lock(state_mutex_);
+		if (!presets_.erase(token))
+			return fault(true, "ter:InvalidArgVal", "ter:NoToken", "No such preset", reply);
+		reply = "<tptz:RemovePresetResponse/>";
+	} else if ("GotoPreset" == operation) {
+		std::string token;
+		text(request, "PresetToken", end, token);
+
+		std::lock_guard<std::mutex> lock(state_mutex_);
+		std::map<std::string, Preset>::const_iterator it = presets_.find(token);
+		if (it == presets_.end())
+			return fault(true, "ter:InvalidArgVal", "ter:NoToken", "No such preset", reply);
+		move_to(it->second.position_);
+		reply = "<tptz:GotoPresetResponse/>";
+	} else if ("GotoHomePosition" == operation) {
+		std::lock_guard<std::mutex> lock(state_mutex_);
+		move_to(home_);
+		reply = "<tptz:GotoHomePositionResponse/>";
+	} else if ("SetHomePosition" == operation) {
+		std::lock_guard<std::mutex> lock(state_mutex_);
+		current(clock_t::now(), home_);
+		reply = "<tptz:SetHomePositionResponse/>";
+	} else {
+		return fault(false, "ter:ActionNotSupported", NULL, "Operation not supported", reply);
+	}
+	return 200;
+}
+
+void MockOnvifServer::current(clock_t::time_point now, float position[3]) const
+{
+	for (int i = 0; i < 3; i++) {
+		clock_t::time_point until = std::min(std::max(now, motion_.begin_), motion_.end_[i]);
+		position[i] = motion_.from_[i] + motion_.rate_[i] * std::chrono::duration<float>(until - motion_.begin_).count();
+	}
+	clamp(position);
+}
+
+bool MockOnvifServer::moving(clock_t::time_point now, int axis) const
+{
+	return motion_.rate_[axis] != 0 && now >= motion_.begin_ && now < motion_.end_[axis];
+}
+
+void MockOnvifServer::move_to(const float target[3])
+{
+	clock_t::time_point now = clock_t::now();
+	float from[3], to[3] = { target[0], target[1], target[2] };
+	current(now, from);
+	clamp(to);
+
+	// All axes arrive together, the slowest sets the pace
+	float seconds = 0;
+	float speed[3] = { config_.pan_tilt_speed_, config_.pan_tilt_speed_, config_.zoom_speed_ };
+	for (int i = 0; i < 3; i++) {
+		if (speed[i] > 0)
+			seconds = std::max(seconds, fabsf(to[i] - from[i]) / speed[i]);
+	}
+	seconds += config_.move_ms_ / 1000.0f;
+
+	motion_.begin_ = now + std::chrono::milliseconds(config_.start_delay_ms_);
+	clock_t::time_point end = motion_.begin_ + std::chrono::duration_cast<clock_t::duration>(std::chrono::duration<float>(seconds));
+	for (int i = 0; i < 3; i++) {
+		bool moves = seconds > 0 && to[i] != from[i];
+		motion_.from_[i] = moves ? from[i] : to[i];
+		motion_.rate_[i] = moves ? (to[i] - from[i]) / seconds : 0;
+		motion_.end_[i] = moves ? end : motion_.begin_;
+	}
+}
+
+void MockOnvifServer::move_at(const float velocity[3], uint32_t timeout_ms)
+{
+	clock_t::time_point now = clock_t::now();
+	float from[3];
+	current(now, from);
+
+	// No timeout keeps moving until Stop
+	motion_.begin_ = now + std::chrono::milliseconds(config_.start_delay_ms_);
+	clock_t::time_point end = motion_.begin_ + (timeout_ms ? std::chrono::milliseconds(timeout_ms) : std::chrono::hours(24));
+	float speed[3] = { config_.pan_tilt_speed_, config_.pan_tilt_speed_, config_.zoom_speed_ };
+	for (int i = 0; i < 3; i++) {
+		motion_.from_[i] = from[i];
+		motion_.rate_[i] = velocity[i] * speed[i];
+		motion_.end_[i] = velocity[i] ? end : motion_.begin_;
+	}
+}
+
+void MockOnvifServer::halt(bool pan_tilt, bool zoom)
+{
+	clock_t::time_point now = clock_t::now();
+	for (int i = 0; i < 3; i++) {
+		if ((i < 2) ? pan_tilt : zoom)
+			motion_.end_[i] = std::min(motion_.end_[i], std::max(now, motion_.begin_));
+	}
+}
+
+void MockOnvifServer::clamp(float position[3]) const
+{
+	float min[3] = { config_.pan_min_, config_.tilt_min_, config_.zoom_min_ };
+	float max[3] = { config_.pan_max_, config_.tilt_max_, config_.zoom_max_ };
+	for (int i = 0; i < 3; i++)
+		position[i] = fmaxf(fminf(min[i], max[i]), fminf(position[i], fmaxf(min[i], max[i])));
+}
+
+std::string MockOnvifServer::status_reply()
+{
+	std::lock_guard<std::mutex> lock(state_mutex_);
+	clock_t::time_point now = clock_t::now();
+	float p[3];
+	current(now, p);
+	bool pan_tilt = moving(now, 0) || moving(now, 1);
+	bool zoom = moving(now, 2);
+
+	return "<tptz:GetStatusResponse><tptz:PTZStatus><tt:Position>"
+		"<tt:PanTilt x=\"" + number(p[0]) + "\" y=\"" + number(p[1]) + "\" space=\"" + pan_tilt_position_space + "\"/>"
+		"<tt:Zoom x=\"" + number(p[2]) + "\" space=\"" + zoom_position_space + "\"/></tt:Position>"
+		"<tt:MoveStatus><tt:PanTilt>" + (pan_tilt ? "MOVING" : "IDLE") + "</tt:PanTilt><tt:Zoom>" + (zoom ? "MOVING" : "IDLE")
+		+ "</tt:Zoom></tt:MoveStatus><tt:UtcTime>" + utc_time(time(NULL) + config_.clock_offset_s_)
+		+ "</tt:UtcTime></tptz:PTZStatus></tptz:GetStatusResponse>";
+}
+
+std::string MockOnvifServer::presets_reply()
+{
+	std::string reply = "<tptz:GetPresetsResponse>";
+	for (std::map<std::string, Preset>::const_iterator it = presets_.begin(); it != presets_.end(); ++it) {
+		const float* p = it->second.position_;
+		reply += "<tptz:Preset token=\"" + it->first + "\"><tt:Name>" + it->second.name_ + "</tt:Name><tt:PTZPosition>"
+			"<tt:PanTilt x=\"" + number(p[0]) + "\" y=\"" + number(p[1]) + "\" space=\"" + pan_tilt_position_space + "\"/>"
+			"<tt:Zoom x=\"" + number(p[2]) + "\" space=\"" + zoom_position_space + "\"/></tt:PTZPosition></tptz:Preset>";
+	}
+	return reply + "</tptz:GetPresetsResponse>";
+}
+
+std::string MockOnvifServer::node() const
+{
+	float pan_span = fabsf(config_.pan_max_ - config_.pan_min_);
+	float tilt_span = fabsf(config_.tilt_max_ - config_.tilt_min_);
+	float zoom_span = fabsf(config_.zoom_max_ - config_.zoom_min_);
+
+	return "<tt:Name>PTZNode_1</tt:Name><tt:SupportedPTZSpaces>"
+		"<tt:AbsolutePanTiltPositionSpace><tt:URI>" + std::string(pan_tilt_position_space) + "</tt:URI>"
+		"<tt:XRange>" + range(config_.pan_min_, config_.pan_max_) + "</tt:XRange>"
+		"<tt:YRange>" + range(config_.tilt_min_, config_.tilt_max_) + "</tt:YRange></tt:AbsolutePanTiltPositionSpace>"
+		"<tt:AbsoluteZoomPositionSpace><tt:URI>" + zoom_position_space + "</tt:URI>"
+		"<tt:XRange>" + range(config_.zoom_min_, config_.zoom_max_) + "</tt:XRange></tt:AbsoluteZoomPositionSpace>"
+		"<tt:RelativePanTiltTranslationSpace><tt:URI>" + pan_tilt_translation_space + "</tt:URI>"
+		"<tt:XRange>" + range(-pan_span, pan_span) + "</tt:XRange>"
+		"<tt:YRange>" + range(-tilt_span, tilt_span) + "</tt:YRange></tt:RelativePanTiltTranslationSpace>"
+		"<tt:RelativeZoomTranslationSpace><tt:URI>" + zoom_translation_space + "</tt:URI>"
+		"<tt:XRange>" + range(-zoom_span, zoom_span) + "</tt:XRange></tt:RelativeZoomTranslationSpace>"
+		"<tt:ContinuousPanTiltVelocitySpace><tt:URI>" + pan_tilt_velocity_space + "</tt:URI>"
+		"<tt:XRange>" + range(-1, 1) + "</tt:XRange><tt:YRange>" + range(-1, 1) + "</tt:YRange></tt:ContinuousPanTiltVelocitySpace>"
+		"<tt:ContinuousZoomVelocitySpace><tt:URI>" + zoom_velocity_space + "</tt:URI>"
+		"<tt:XRange>" + range(-1, 1) + "</tt:XRange></tt:ContinuousZoomVelocitySpace>"
+		"</tt:SupportedPTZSpaces><tt:MaximumNumberOfPresets>" + std::to_string(config_.max_presets_)
+		+ "</tt:MaximumNumberOfPresets><tt:HomeSupported>true</tt:HomeSupported>";
+}
+
+std::string MockOnvifServer::envelope(const std::string& body)
+{
+	return "<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+		"<SOAP-ENV:Envelope xmlns:SOAP-ENV=\"http://www.w3.org/2003/05/soap-envelope\""
+		" xmlns:tt=\"http://www.onvif.org/ver10/schema\""
+		" xmlns:tds=\"http://www.onvif.org/ver10/device/wsdl\""
+		" xmlns:trt=\"http://www.onvif.org/ver10/media/wsdl\""
+		" xmlns:tptz=\"http://www.onvif.org/ver20/ptz/wsdl\""
+		" xmlns:timg=\"http://www.onvif.org/ver20/imaging/wsdl\""
+		" xmlns:ter=\"http://www.onvif.org/ver10/error\">"
+		"<SOAP-ENV:Body>" + body + "</SOAP-ENV:Body></SOAP-ENV:Envelope>";
+}
+
+int MockOnvifServer::fault(bool sender, const char* subcode, const char* detail, const char* reason, std::string& reply)
+{
+	reply = std::string("<SOAP-ENV:Fault><SOAP-ENV:Code><SOAP-ENV:Value>") + (sender ? "SOAP-ENV:Sender" : "SOAP-ENV:Receiver")
+		+ "</SOAP-ENV:Value><SOAP-ENV:Subcode><SOAP-ENV:Value>" + subcode + "</SOAP-ENV:Value>";
+	if (detail)
+		reply += std::string("<SOAP-ENV:Subcode><SOAP-ENV:Value>") + detail + "</SOAP-ENV:Value></SOAP-ENV:Subcode>";
+	reply += std::string("</SOAP-ENV:Subcode></SOAP-ENV:Code><SOAP-ENV:Reason><SOAP-ENV:Text xml:lang=\"en\">") + reason
+		+ "</SOAP-ENV:Text></SOAP-ENV:Reason></SOAP-ENV:Fault>";
+	return sender ? 400 : 500;
+}
+
+}}}}
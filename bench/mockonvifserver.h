@@ -0,0 +1,197 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+namespace bench {
+
+// Behaviour of a MockOnvifServer, the defaults answer at once and move a
+// generic -1 to 1 pan/tilt and 0 to 1 zoom camera over its full range in 2 s
+class MockOnvifConfig {
+public:
+	// Added before every reply
+	uint32_t latency_ms_;
+
+	// Camera units per second, 0 completes moves at once
+	float pan_tilt_speed_;
+	float zoom_speed_;
+
+	// Added to every move, acceleration and settling of the motors
+	uint32_t move_ms_;
+
+	// Idle and the old position are reported this long after a move was
+	// accepted, as devices do before the motors start
+	uint32_t start_delay_ms_;
+
+	// DefaultPTZTimeout of the PTZ configuration, 0 leaves it out
+	uint32_t ptz_timeout_ms_;
+
+	// Device clock ahead of the host by this much
+	int32_t clock_offset_s_;
+
+	float pan_min_;
+	float pan_max_;
+	float tilt_min_;
+	float tilt_max_;
+	float zoom_min_;
+	float zoom_max_;
+
+	uint32_t max_presets_;
+
+	MockOnvifConfig()
+		: latency_ms_(0)
+		, pan_tilt_speed_(1.0f)
+		, zoom_speed_(0.5f)
+		, move_ms_(0)
+		, start_delay_ms_(0)
+		, ptz_timeout_ms_(1000)
+		, clock_offset_s_(0)
+		, pan_min_(-1.0f)
+		, pan_max_(1.0f)
+		, tilt_min_(-1.0f)
+		, tilt_max_(1.0f)
+		, zoom_min_(0.0f)
+		, zoom_max_(1.0f)
+		, max_presets_(64)
+	{
+	}
+};
+
+// ONVIF device on 127.0.0.1 for benchmarks and simulations: the device,
+// media, PTZ and imaging services a PTZ camera needs, over HTTP keep-alive
+// connections with SOAP 1.2. Requests are told apart by service path and
+// the first element in the Body, WS-Security headers are accepted without
+// checking. Absolute, relative and continuous moves run along a straight
+// line at the configured speed, GetStatus reports the position on it and
+// MOVING until the move ended.
+class MockOnvifServer {
+public:
+	explicit MockOnvifServer(const MockOnvifConfig& config = MockOnvifConfig());
+
+	~MockOnvifServer();
+
+	// Binds an ephemeral port, false when the socket could not be set up
+	bool start();
+
+	void stop();
+
+	uint16_t port() const { return port_; }
+
+	// e.g. "http://127.0.0.1:40123/onvif/device_service"
+	std::string device_url() const;
+
+	// Takes effect from the next request
+	void set_latency(uint32_t latency_ms) { latency_ms_ = latency_ms; }
+
+	// Camera values now, false while moving
+	bool position(float& pan, float& tilt, float& zoom) const;
+
+	// Jump to a position without moving, ends a running move
+	void set_position(float pan, float tilt, float zoom);
+
+	// Requests answered, all or of one operation such as "GetStatus"
+	uint64_t requests() const { return requests_.load(); }
+
+	uint64_t requests(const std::string& operation) const;
+
+	uint64_t connections() const { return connections_.load(); }
+
+	void reset_counters();
+
+private:
+	typedef std::chrono::steady_clock clock_t;
+
+	// Pan, tilt and zoom each from from_ at rate_ per second between begin_
+	// and their end_, a Stop ends an axis early
+	class Motion {
+	public:
+		float from_[3];
+		float rate_[3];
+		clock_t::time_point begin_;
+		clock_t::time_point end_[3];
+	};
+
+	class Preset {
+	public:
+		std::string name_;
+		float position_[3];
+	};
+
+	void accept_loop();
+
+	void connection_loop(int fd);
+
+	// Reads one request, false on end of stream or a malformed request
+	static bool read_request(int fd, std::string& buffer, std::string& path, std::string& body, bool& keep_alive);
+
+	static bool write_all(int fd, const std::string& data);
+
+	// SOAP body of the reply, returns the HTTP status
+	int handle(const std::string& path, const std::string& operation, const std::string& request, std::string& reply);
+
+	int device(const std::string& operation, std::string& reply);
+
+	int media(const std::string& operation, std::string& reply);
+
+	int ptz(const std::string& operation, const std::string& request, std::string& reply);
+
+	int imaging(const std::string& operation, std::string& reply);
+
+	// With state_mutex_ held
+	void current(clock_t::time_point now, float position[3]) const;
+
+	bool moving(clock_t::time_point now, int axis) const;
+
+	void move_to(const float target[3]);
+
+	void move_at(const float velocity[3], uint32_t timeout_ms);
+
+	void halt(bool pan_tilt, bool zoom);
+
+	void clamp(float position[3]) const;
+
+	std::string status_reply();
+
+	std::string presets_reply();
+
+	std::string node() const;
+
+	std::string service_url(const char* service) const;
+
+	static std::string envelope(const std::string& body);
+
+	// Sender faults are answered with 400, receiver faults with 500
+	static int fault(bool sender, const char* subcode, const char* detail, const char* reason, std::string& reply);
+
+	MockOnvifConfig config_;
+	std::atomic<uint32_t> latency_ms_;
+
+	int listen_fd_;
+	uint16_t port_;
+	std::atomic<bool> stop_;
+	std::thread accept_thread_;
+
+	std::mutex connections_mutex_;
+	std::vector<int> connection_fds_;
+	std::vector<std::thread> connection_threads_;
+
+	mutable std::mutex state_mutex_;
+	Motion motion_;
+	float home_[3];
+	std::map<std::string, Preset> presets_;
+	uint32_t next_preset_;
+	std::map<std::string, uint64_t> operations_;
+
+	std::atomic<uint64_t> requests_;
+	std::atomic<uint64_t> connections_;
+};
+
+}}}}
@@ -0,0 +1,67 @@
+#include <streamer/processor/ptz/bench/simulatedcamera.h>
+#include <math.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+namespace bench {
+
+SimulatedCamera::SimulatedCamera(const SimulatedCameraConfig& config /*= SimulatedCameraConfig()*/)
+	: config_(config)
+	, pan_(0)
+	, tilt_(0)
+	, zoom_(0)
+	, moves_(0)
+{
+}
+
+bool SimulatedCamera::move(float pan, float tilt, float zoom)
+{
+	pan_ = pan;
+	tilt_ = tilt;
+	zoom_ = zoom;
+	moves_++;
+	return true;
+}
+
+bool SimulatedCamera::locate(float& x, float& y)
+{
+	return locate(pan_, tilt_, zoom_, x, y);
+}
+
+bool SimulatedCamera::locate(float pan, float tilt, float zoom, float& x, float& y) const
+{
+	float pan_degree = pan * config_.pan_degrees_;
+	float tilt_degree = tilt * config_.tilt_degrees_;
+
+	float pan_delta = config_.feature_pan_ - pan_degree;
+	if (pan_delta > 180)
+		pan_delta -= 360;
+	else if (pan_delta < -180)
+		pan_delta += 360;
+
+	// A constant focal length model at this zoom is the true projection
+	float h = hfov(zoom);
+	FovModel lens(h, h, config_.aspect_);
+	return lens.project(pan_delta, config_.feature_tilt_ - tilt_degree, 0, tilt_degree, x, y);
+}
+
+float SimulatedCamera::hfov(float zoom) const
+{
+	float wide = 1.0f / tanf(config_.wide_hfov_ * (float) M_PI / 360.0f);
+	float focal = wide * powf(config_.zoom_ratio_, zoom);
+	return 2.0f * atanf(1.0f / focal) * 180.0f / (float) M_PI;
+}
+
+FovModel SimulatedCamera::datasheet() const
+{
+	return FovModel(hfov(0), hfov(1), config_.aspect_);
+}
+
+void SimulatedCamera::feature(float& pan, float& tilt) const
+{
+	pan = config_.feature_pan_ / config_.pan_degrees_;
+	tilt = config_.feature_tilt_ / config_.tilt_degrees_;
+}
+
+}}}}
@@ -0,0 +1,83 @@
+#pragma once
+#include <stdint.h>
+#include <streamer/processor/ptz/fovmodel.h>
+#include <streamer/processor/ptz/ptzcalibration.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+namespace bench {
+
+// Optics and mechanics of a SimulatedCamera, by default a 25x zoom lens on a
+// camera turning 170 degrees per unit of a -1 to 1 pan axis and 45 per unit
+// of tilt, with the feature 10 degrees right of and 20 degrees above the
+// camera values 0, 0
+class SimulatedCameraConfig {
+public:
+	float wide_hfov_;
+
+	// Focal length at tele over the one at wide
+	float zoom_ratio_;
+
+	float aspect_;
+
+	// Degrees per camera unit, the 0 of the camera values is at 0 degrees
+	float pan_degrees_;
+	float tilt_degrees_;
+
+	// Direction of the reference feature in degrees
+	float feature_pan_;
+	float feature_tilt_;
+
+	SimulatedCameraConfig()
+		: wide_hfov_(58.0f)
+		, zoom_ratio_(25.0f)
+		, aspect_(16.0f / 9.0f)
+		, pan_degrees_(170.0f)
+		, tilt_degrees_(45.0f)
+		, feature_pan_(10.0f)
+		, feature_tilt_(20.0f)
+	{
+	}
+};
+
+// CalibrationProbe of a simulated camera looking at a fixed feature. The
+// focal length grows exponentially over the zoom range as with real zoom
+// lenses, not linearly as the default FovModel assumes, and the pan/tilt
+// scale differs from what the axis limits tell, so a calibration has
+// something to find. locate() projects the feature through a pinhole camera.
+class SimulatedCamera : public CalibrationProbe {
+public:
+	explicit SimulatedCamera(const SimulatedCameraConfig& config = SimulatedCameraConfig());
+
+	// Moves at once
+	bool move(float pan, float tilt, float zoom);
+
+	bool locate(float& x, float& y);
+
+	// Image point of the feature seen from camera values pan, tilt, zoom, e.g.
+	// the position of a MockOnvifServer
+	bool locate(float pan, float tilt, float zoom, float& x, float& y) const;
+
+	// True horizontal field of view at a zoom position
+	float hfov(float zoom) const;
+
+	// What a datasheet gives: the wide and tele field of view
+	FovModel datasheet() const;
+
+	// Camera values that center the feature
+	void feature(float& pan, float& tilt) const;
+
+	uint32_t moves() const { return moves_; }
+
+	const SimulatedCameraConfig& config() const { return config_; }
+
+private:
+	SimulatedCameraConfig config_;
+	float pan_;
+	float tilt_;
+	float zoom_;
+	uint32_t moves_;
+};
+
+}}}}
@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <stdint.h>
+#include <streamer/processor/ptz/seqlock.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+// Fixed size ring written by one producer at a time and read by any number of
+// consumers, each with its own cursor. Readers never block the writer, a reader
+// that falls more than Capacity entries behind skips the overwritten ones.
+template<typename T, uint32_t Capacity>
+class BroadcastRing {
+public:
+	BroadcastRing() : head_(0)
+	{
+	}
+
+	void push(const T& value)
+	{
+		uint64_t index = head_.load(std::memory_order_relaxed);
+
+		Entry entry;
+		entry.index_ = index;
+		entry.value_ = value;
+		slots_[index % Capacity].store(entry);
+
+		head_.store(index + 1, std::memory_order_release);
+	}
+
+	// Cursor of the next entry to be pushed, start here to only see new entries
+	uint64_t head() const { return head_.load(std::memory_order_acquire); }
+
+	// Cursor of the oldest entry still available
+	uint64_t tail() const
+	{
+		uint64_t head = head_.load(std::memory_order_acquire);
+		return (head > Capacity) ? head - Capacity : 0;
+	}
+
+	// Read the entry at cursor and advance it, false when the reader caught up.
+	// lost (optional) is increased by the number of entries skipped.
+	bool read(uint64_t& cursor, T& value, uint64_t* lost = NULL) const
+	{
+		for (;;) {
+			uint64_t head = head_.load(std::memory_order_acquire);
+			if (cursor >= head)
+				return false;
+
+			uint64_t oldest = (head > Capacity) ? head - Capacity : 0;
+			if (cursor < oldest) {
+				if (lost)
+					*lost += oldest - cursor;
+				cursor = oldest;
+			}
+
+			Entry entry = slots_[cursor % Capacity].load();
+			if (entry.index_ == cursor) {
+				value = entry.value_;
+				cursor++;
+				return true;
+			}
+
+			// Overwritten while reading, continue from the new tail
+		}
+	}
+
+	static uint32_t capacity() { return Capacity; }
+
+private:
+	class Entry {
+	public:
+		uint64_t index_;
+		T value_;
+
+		Entry() : index_(UINT64_MAX)
+		{
+		}
+	};
+
+	std::atomic<uint64_t> head_;
+	SeqLock<Entry> slots_[Capacity];
+};
+
+}}}
@@ -1,9 +1,14 @@
 #pragma once
 #include<string>
 #include<map>
+#include<future>
+#include<functional>
 #include <streamer/common/logger.h>
 #include<streamer/processor/ptz/data.h>
 #include<streamer/processor/ptz/preset.h>
+#include<streamer/processor/ptz/executor.h>
+#include<streamer/processor/ptz/controlmetrics.h>
+#include<streamer/processor/ptz/ptzshm.h>
 
 namespace orion {
 namespace streamer {
@@ -70,6 +75,22 @@ public:
 	bool load_config(const std::string& camera_name, const std::string& file);
 };
 
+// Outcome of one command, replaces reading send_response()/update_position()
+// after control() when commands run concurrently
+class ControlResult {
+public:
+	bool success_;
+	bool send_response_;
+	bool update_position_;
+
+	ControlResult()
+		: success_(false)
+		, send_response_(false)
+		, update_position_(false)
+	{
+	}
+};
+
 class CameraControl {
 
 public:
@@ -77,6 +98,11 @@ public:
 	typedef std::map<std::string, CameraPreset> presets_t;
 	typedef std::list<std::string> preset_list_t;
 
+	typedef std::function<void(const data_ptr_t&, const ControlResult&)> callback_t;
+
+	// Takes a command and its completion, false if it was not accepted
+	typedef std::function<bool(const data_ptr_t&, const callback_t&)> router_t;
+
 	enum Type {
 		TypeControlInvalid = -1,
 		HttpGeneric = 0,
@@ -84,9 +110,50 @@ public:
 		GpioStepper
 	};
 
-	~CameraControl();
+	virtual ~CameraControl();
 
 	virtual bool control(const data_ptr_t& data) = 0;
+
+	// Same as control() but reports the response/position flags in the result
+	virtual ControlResult execute(const data_ptr_t& data)
+	{
+		ControlResult result;
+		result.success_ = control(data);
+		result.send_response_ = send_response_;
+		result.update_position_ = update_position_;
+		return result;
+	}
+
+	// Queue the command on this camera's executor, or on the router when one is
+	// set, commands run in order and the callback (optional) is invoked on the
+	// thread that ran it. A command that never runs because the camera shuts
+	// down completes with a failed result.
+	std::future<ControlResult> control_async(const data_ptr_t& data, const callback_t& callback = callback_t())
+	{
+		std::shared_ptr<std::promise<ControlResult> > promise = std::make_shared<std::promise<ControlResult> >();
+		std::future<ControlResult> future = promise->get_future();
+
+		callback_t complete = [callback, promise](const data_ptr_t& command, const ControlResult& result) {
+			if (callback)
+				callback(command, result);
+			promise->set_value(result);
+		};
+
+		if (!post_async(data, complete))
+			complete(data, ControlResult());
+
+		return future;
+	}
+
+	// Hand control_async() commands to router instead of the camera's own
+	// executor, e.g. the queue of a PtzDispatcher, so they are ordered with the
+	// commands queued there. router must call the completion exactly once,
+	// never from within itself. An empty router restores the executor.
+	void set_async_router(const router_t& router)
+	{
+		std::lock_guard<std::mutex> lock(async_.mutex_);
+		async_.router_ = router;
+	}
 	
 	virtual void get_position(data_ptr_t& data) = 0;
 
@@ -104,6 +171,22 @@ public:
 
 	bool update_position() { return update_position_; }
 
+	// Latency and error counts of the requests sent to the camera
+	const ControlMetrics& metrics() const { return metrics_; }
+
+	// Publish position and presets into the shared memory segment of camera so
+	// other processes can read them, see PtzSharedState
+	bool export_state(const std::string& camera)
+	{
+		// Commands publish positions and presets under the same lock
+		std::lock_guard<std::mutex> lock(config_mutex_);
+		if (!shared_state_.create(camera))
+			return false;
+
+		shared_state_.publish(presets_);
+		return true;
+	}
+
 	static std::map<Type, std::string> control_type_;
 
 	CameraDetails details_;
@@ -125,8 +208,65 @@ protected:
 
 	presets_t presets_;
 	preset_list_t preset_list_;
+
+	ControlMetrics metrics_;
+
+	PtzSharedState shared_state_;
+
+	// Held by commands while they run and by apply() while the configuration changes
+	std::mutex config_mutex_;
+
+	// Derived classes call this first in their destructor so no queued command
+	// runs against a partially destroyed object
+	void stop_async()
+	{
+		std::unique_ptr<SerialExecutor> executor;
+		{
+			std::lock_guard<std::mutex> lock(async_.mutex_);
+			executor.swap(async_.executor_);
+			async_.router_ = router_t();
+			async_.stopped_ = true;
+		}
+
+		if (executor.get())
+			executor->stop();
+	}
 private:
 
+	// control_async() destination, the router is called under mutex_ so
+	// set_async_router() waits for calls in progress before its owner goes away
+	class AsyncTarget {
+	public:
+		std::mutex mutex_;
+		std::unique_ptr<SerialExecutor> executor_;
+		router_t router_;
+		bool stopped_;
+
+		AsyncTarget()
+			: stopped_(false)
+		{
+		}
+	};
+
+	bool post_async(const data_ptr_t& data, const callback_t& complete)
+	{
+		std::lock_guard<std::mutex> lock(async_.mutex_);
+		if (async_.stopped_)
+			return false;
+		if (async_.router_)
+			return async_.router_(data, complete);
+
+		if (!async_.executor_.get())
+			async_.executor_.reset(new SerialExecutor(std::string("ptz-") + type_));
+		return async_.executor_->post([this, data, complete]() {
+			complete(data, execute(data));
+		}, [data, complete]() {
+			complete(data, ControlResult());
+		});
+	}
+
+	AsyncTarget async_;
+
 	common::Logger::logger_t logger_;
 
 };
@@ -0,0 +1,162 @@
+#include <streamer/processor/ptz/coalescer.h>
+#include <streamer/processor/ptz/ptzcontrol.h>
+#include <limits>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+CommandCoalescer::Kind CommandCoalescer::kind(uint8_t type)
+{
+	Kind ret = Kind::Barrier;
+
+	switch((PtzControl::Type) type) {
+		case PtzControl::Type::Pan:
+		case PtzControl::Type::Tilt:
+		case PtzControl::Type::Zoom:
+		case PtzControl::Type::PanTilt:
+		case PtzControl::Type::PanTiltZoom:
+		case PtzControl::Type::PanPlus:
+		case PtzControl::Type::PanMinus:
+		case PtzControl::Type::TiltPlus:
+		case PtzControl::Type::TiltMinus:
+		case PtzControl::Type::ZoomPlus:
+		case PtzControl::Type::ZoomMinus:
+			ret = Kind::Relative;
+			break;
+		case PtzControl::Type::FocusNear:
+		case PtzControl::Type::FocusFar:
+			ret = Kind::Continuous;
+			break;
+		default:
+			break;
+	}
+
+	return ret;
+}
+
+bool CommandCoalescer::merge(Data& pending, const Data& incoming)
+{
+	bool ret = false;
+
+	if (pending.camera_name != incoming.camera_name)
+		return false;
+
+	Kind pending_kind = kind(pending.type);
+	Kind incoming_kind = kind(incoming.type);
+
+	if (Kind::Relative == pending_kind && Kind::Relative == incoming_kind) {
+		int32_t pan = 0, tilt = 0, zoom = 0;
+		int32_t add_pan = 0, add_tilt = 0, add_zoom = 0;
+		if (translation(pending, pan, tilt, zoom) && translation(incoming, add_pan, add_tilt, add_zoom)) {
+			pan += add_pan;
+			tilt += add_tilt;
+			zoom += add_zoom;
+
+			if (tilt == 0 && zoom == 0)
+				pending.type = (uint8_t) PtzControl::Type::Pan;
+			else if (pan == 0 && zoom == 0)
+				pending.type = (uint8_t) PtzControl::Type::Tilt;
+			else if (pan == 0 && tilt == 0)
+				pending.type = (uint8_t) PtzControl::Type::Zoom;
+			else if (zoom == 0)
+				pending.type = (uint8_t) PtzControl::Type::PanTilt;
+			else
+				pending.type = (uint8_t) PtzControl::Type::PanTiltZoom;
+
+			pending.pan = clamp(pan);
+			pending.tilt = clamp(tilt);
+			pending.zoom = clamp(zoom);
+			ret = true;
+		}
+	} else if (Kind::Continuous == pending_kind && Kind::Continuous == incoming_kind) {
+		// Only the latest velocity of an axis matters
+		if (continuous_axis(pending.type) == continuous_axis(incoming.type)) {
+			pending = incoming;
+			ret = true;
+		}
+	}
+
+	return ret;
+}
+
+bool CommandCoalescer::noop(const Data& data)
+{
+	int32_t pan = 0, tilt = 0, zoom = 0;
+
+	return Kind::Relative == kind(data.type) && translation(data, pan, tilt, zoom) && pan == 0 && tilt == 0 && zoom == 0;
+}
+
+bool CommandCoalescer::translation(const Data& data, int32_t& pan, int32_t& tilt, int32_t& zoom)
+{
+	bool ret = true;
+
+	pan = tilt = zoom = 0;
+
+	// Step sizes match the fixed degrees OnvifControl uses for the plus/minus commands
+	switch((PtzControl::Type) data.type) {
+		case PtzControl::Type::Pan:
+			pan = data.pan;
+			break;
+		case PtzControl::Type::Tilt:
+			tilt = data.tilt;
+			break;
+		case PtzControl::Type::Zoom:
+			zoom = data.zoom;
+			break;
+		case PtzControl::Type::PanTilt:
+			pan = data.pan;
+			tilt = data.tilt;
+			break;
+		case PtzControl::Type::PanTiltZoom:
+			pan = data.pan;
+			tilt = data.tilt;
+			zoom = data.zoom;
+			break;
+		case PtzControl::Type::PanPlus:
+			pan = 10;
+			break;
+		case PtzControl::Type::PanMinus:
+			pan = -10;
+			break;
+		case PtzControl::Type::TiltPlus:
+			tilt = 10;
+			break;
+		case PtzControl::Type::TiltMinus:
+			tilt = -10;
+			break;
+		default:
+			// ZoomPlus/ZoomMinus step by a fraction of a percent, not representable in Data
+			ret = false;
+			break;
+	}
+
+	return ret;
+}
+
+int CommandCoalescer::continuous_axis(uint8_t type)
+{
+	int ret = -1;
+
+	switch((PtzControl::Type) type) {
+		case PtzControl::Type::FocusNear:
+		case PtzControl::Type::FocusFar:
+			ret = 0;
+			break;
+		default:
+			break;
+	}
+
+	return ret;
+}
+
+int16_t CommandCoalescer::clamp(int32_t value)
+{
+	if (value > std::numeric_limits<int16_t>::max())
+		value = std::numeric_limits<int16_t>::max();
+	if (value < std::numeric_limits<int16_t>::min())
+		value = std::numeric_limits<int16_t>::min();
+	return (int16_t) value;
+}
+
+}}}
@@ -0,0 +1,42 @@
+#pragma once
+#include <streamer/processor/ptz/data.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+// Merges joystick commands that are still queued for a camera:
+//  - consecutive relative moves are summed into a single Pan/Tilt/Zoom/PanTilt/PanTiltZoom,
+//    moves that cancel out leave a no-op (see noop())
+//  - a continuous move replaces a queued continuous move of the same axis
+//  - every other command (stop, presets, absolute moves, ...) is a barrier
+class CommandCoalescer {
+public:
+	enum Kind {
+		Barrier = 0,
+		Relative,
+		Continuous
+	};
+
+	static Kind kind(uint8_t type);
+
+	// Merge incoming into pending, the newest queued command that did not start
+	// yet. Returns false when incoming has to be queued on its own.
+	static bool merge(Data& pending, const Data& incoming);
+
+	// Relative move of zero on every axis. A merge result like this completes
+	// successfully without reaching the camera, which rejects an empty move.
+	static bool noop(const Data& data);
+
+private:
+
+	// Relative translation in nvr units, false if the command cannot be expressed as one
+	static bool translation(const Data& data, int32_t& pan, int32_t& tilt, int32_t& zoom);
+
+	// Axis a continuous command drives, -1 if none
+	static int continuous_axis(uint8_t type);
+
+	static int16_t clamp(int32_t value);
+};
+
+}}}
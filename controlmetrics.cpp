@@ -0,0 +1,208 @@
+#include <streamer/processor/ptz/controlmetrics.h>
+#include <algorithm>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+static const char* operation_names[ControlMetrics::OperationCount] = {
+	"GetCapabilities",
+	"GetDeviceInformation",
+	"SetSystemDateAndTime",
+	"GetSystemDateAndTime",
+	"SystemReboot",
+	"GetProfiles",
+	"GetNodes",
+	"GetNode",
+	"GetStatus",
+	"AbsoluteMove",
+	"RelativeMove",
+	"ContinuousMove",
+	"Stop",
+	"GetPresets",
+	"SetPreset",
+	"RemovePreset",
+	"GotoPreset",
+	"SetHomePosition",
+	"GotoHomePosition",
+	"GetMoveOptions",
+	"ImagingMove",
+	"ImagingStop",
+	"GetImagingSettings"
+};
+
+static const char* latency_name = "orion_ptz_request_duration_microseconds";
+static const char* requests_name = "orion_ptz_requests_total";
+static const char* errors_name = "orion_ptz_request_errors_total";
+
+OperationStats::OperationStats()
+	: success_(0)
+	, fault_(0)
+	, other_errors_(0)
+{
+	for (int i = 0; i < ErrorSlots; i++) {
+		error_codes_[i].store(0, std::memory_order_relaxed);
+		error_counts_[i].store(0, std::memory_order_relaxed);
+	}
+}
+
+void OperationStats::record(int error, uint64_t elapsed_us)
+{
+	latency_us_.record(elapsed_us);
+
+	// SOAP_OK is 0, which also marks a free error slot
+	if (!error) {
+		success_.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	fault_.fetch_add(1, std::memory_order_relaxed);
+
+	for (int i = 0; i < ErrorSlots; i++) {
+		int code = error_codes_[i].load(std::memory_order_relaxed);
+		if (!code && error_codes_[i].compare_exchange_strong(code, error, std::memory_order_relaxed))
+			code = error;
+		if (code == error) {
+			error_counts_[i].fetch_add(1, std::memory_order_relaxed);
+			return;
+		}
+	}
+
+	other_errors_.fetch_add(1, std::memory_order_relaxed);
+}
+
+const char* ControlMetrics::to_str(Operation op)
+{
+	return (op >= 0 && op < OperationCount) ? operation_names[op] : "Unknown";
+}
+
+bool ControlMetrics::idempotent(Operation op)
+{
+	switch (op) {
+		case GetCapabilities:
+		case GetDeviceInformation:
+		case GetSystemDateAndTime:
+		case GetProfiles:
+		case GetNodes:
+		case GetNode:
+		case GetStatus:
+		case AbsoluteMove:
+		case ContinuousMove:
+		case Stop:
+		case GetPresets:
+		case GetMoveOptions:
+		case ImagingStop:
+		case GetImagingSettings:
+			return true;
+		default:
+			return false;
+	}
+}
+
+void ControlMetrics::reset()
+{
+	for (int op = 0; op < OperationCount; op++) {
+		OperationStats& stats = operations_[op];
+		stats.latency_us_.reset();
+		stats.success_.store(0, std::memory_order_relaxed);
+		stats.fault_.store(0, std::memory_order_relaxed);
+		stats.other_errors_.store(0, std::memory_order_relaxed);
+		for (int i = 0; i < OperationStats::ErrorSlots; i++) {
+			stats.error_codes_[i].store(0, std::memory_order_relaxed);
+			stats.error_counts_[i].store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+void ControlMetrics::append_latency(const std::string& camera, std::string& out) const
+{
+	for (int op = 0; op < OperationCount; op++) {
+		const OperationStats& stats = operations_[op];
+		if (!stats.latency_us_.count())
+			continue;
+
+		std::string labels = std::string("camera=\"") + camera + "\",operation=\"" + operation_names[op] + "\"";
+
+		// Cumulative buckets up to the highest one in use, the total is summed from
+		// the same reads so +Inf never falls below a finite bucket
+		int last = 0;
+		uint64_t total = 0;
+		for (int i = 0; i < Histogram::Buckets; i++) {
+			uint64_t count = stats.latency_us_.bucket_count(i);
+			if (count)
+				last = i;
+			total += count;
+		}
+
+		uint64_t cumulative = 0;
+		for (int i = 0; i <= last; i++) {
+			cumulative += stats.latency_us_.bucket_count(i);
+			out += std::string(latency_name) + "_bucket{" + labels + ",le=\"" + std::to_string(Histogram::upper_bound(i)) + "\"} " + std::to_string(std::min(cumulative, total)) + "\n";
+		}
+		out += std::string(latency_name) + "_bucket{" + labels + ",le=\"+Inf\"} " + std::to_string(total) + "\n";
+		out += std::string(latency_name) + "_sum{" + labels + "} " + std::to_string(stats.latency_us_.sum()) + "\n";
+		out += std::string(latency_name) + "_count{" + labels + "} " + std::to_string(total) + "\n";
+	}
+}
+
+void ControlMetrics::append_requests(const std::string& camera, std::string& out) const
+{
+	for (int op = 0; op < OperationCount; op++) {
+		const OperationStats& stats = operations_[op];
+		if (!stats.latency_us_.count())
+			continue;
+
+		std::string labels = std::string("camera=\"") + camera + "\",operation=\"" + operation_names[op] + "\"";
+		out += std::string(requests_name) + "{" + labels + ",result=\"success\"} " + std::to_string(stats.success_.load(std::memory_order_relaxed)) + "\n";
+		out += std::string(requests_name) + "{" + labels + ",result=\"fault\"} " + std::to_string(stats.fault_.load(std::memory_order_relaxed)) + "\n";
+	}
+}
+
+void ControlMetrics::append_errors(const std::string& camera, std::string& out) const
+{
+	for (int op = 0; op < OperationCount; op++) {
+		const OperationStats& stats = operations_[op];
+		if (!stats.fault_.load(std::memory_order_relaxed))
+			continue;
+
+		std::string labels = std::string("camera=\"") + camera + "\",operation=\"" + operation_names[op] + "\"";
+		for (int i = 0; i < OperationStats::ErrorSlots; i++) {
+			int code = stats.error_codes_[i].load(std::memory_order_relaxed);
+			if (code)
+				out += std::string(errors_name) + "{" + labels + ",code=\"" + std::to_string(code) + "\"} " + std::to_string(stats.error_counts_[i].load(std::memory_order_relaxed)) + "\n";
+		}
+
+		uint64_t other = stats.other_errors_.load(std::memory_order_relaxed);
+		if (other)
+			out += std::string(errors_name) + "{" + labels + ",code=\"other\"} " + std::to_string(other) + "\n";
+	}
+}
+
+void ControlMetrics::prometheus(const std::string& camera, std::string& out) const
+{
+	std::map<std::string, const ControlMetrics*> cameras;
+	cameras[camera] = this;
+	prometheus(cameras, out);
+}
+
+void ControlMetrics::prometheus(const std::map<std::string, const ControlMetrics*>& cameras, std::string& out)
+{
+	std::map<std::string, const ControlMetrics*>::const_iterator it;
+
+	out += std::string("# HELP ") + latency_name + " Latency of requests sent to the camera\n";
+	out += std::string("# TYPE ") + latency_name + " histogram\n";
+	for (it = cameras.begin(); it != cameras.end(); ++it)
+		it->second->append_latency(it->first, out);
+
+	out += std::string("# HELP ") + requests_name + " Requests sent to the camera by result\n";
+	out += std::string("# TYPE ") + requests_name + " counter\n";
+	for (it = cameras.begin(); it != cameras.end(); ++it)
+		it->second->append_requests(it->first, out);
+
+	out += std::string("# HELP ") + errors_name + " Failed requests by soap error code\n";
+	out += std::string("# TYPE ") + errors_name + " counter\n";
+	for (it = cameras.begin(); it != cameras.end(); ++it)
+		it->second->append_errors(it->first, out);
+}
+
+}}}
@@ -0,0 +1,111 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <string>
+#include <stdint.h>
+#include <streamer/processor/ptz/histogram.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+// Outcome counters of one operation, soap error codes are kept in a small
+// lock free table, codes beyond its capacity are only counted as other_
+class OperationStats {
+public:
+	enum {
+		ErrorSlots = 8
+	};
+
+	OperationStats();
+
+	void record(int error, uint64_t elapsed_us);
+
+	Histogram latency_us_;
+	std::atomic<uint64_t> success_;
+	std::atomic<uint64_t> fault_;
+	std::atomic<int> error_codes_[ErrorSlots];
+	std::atomic<uint64_t> error_counts_[ErrorSlots];
+	std::atomic<uint64_t> other_errors_;
+
+private:
+	OperationStats(const OperationStats&);
+	OperationStats& operator=(const OperationStats&);
+};
+
+// Latency and result of every request a CameraControl sends to the camera.
+// Recording is a handful of relaxed atomic increments so it stays enabled.
+class ControlMetrics {
+public:
+	enum Operation {
+		GetCapabilities = 0,
+		GetDeviceInformation,
+		SetSystemDateAndTime,
+		GetSystemDateAndTime,
+		SystemReboot,
+		GetProfiles,
+		GetNodes,
+		GetNode,
+		GetStatus,
+		AbsoluteMove,
+		RelativeMove,
+		ContinuousMove,
+		Stop,
+		GetPresets,
+		SetPreset,
+		RemovePreset,
+		GotoPreset,
+		SetHomePosition,
+		GotoHomePosition,
+		GetMoveOptions,
+		ImagingMove,
+		ImagingStop,
+		GetImagingSettings,
+		OperationCount
+	};
+
+	static const char* to_str(Operation op);
+
+	// Sending op twice leaves the device as sending it once. Relative moves,
+	// preset changes, preset recalls and reboots are not.
+	static bool idempotent(Operation op);
+
+	void record(Operation op, int error, uint64_t elapsed_us)
+	{
+		operations_[op].record(error, elapsed_us);
+	}
+
+	// Time call() and record its soap error code
+	template<typename Call>
+	int measure(Operation op, Call call)
+	{
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		int ret = call();
+		record(op, ret, std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count());
+		return ret;
+	}
+
+	const OperationStats& operation(Operation op) const { return operations_[op]; }
+
+	void reset();
+
+	// Append the snapshot in Prometheus text exposition format, operations never
+	// issued are omitted
+	void prometheus(const std::string& camera, std::string& out) const;
+
+	// Same for several cameras, keyed by camera name, each metric family is
+	// written as one group as the format requires
+	static void prometheus(const std::map<std::string, const ControlMetrics*>& cameras, std::string& out);
+
+private:
+	void append_latency(const std::string& camera, std::string& out) const;
+
+	void append_requests(const std::string& camera, std::string& out) const;
+
+	void append_errors(const std::string& camera, std::string& out) const;
+
+	OperationStats operations_[OperationCount];
+};
+
+}}}
@@ -0,0 +1,82 @@
+#include <streamer/processor/ptz/executor.h>
+#include <sys/prctl.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+SerialExecutor::SerialExecutor(const std::string& name /*= ""*/)
+	: name_(name)
+	, stop_(false)
+	, thread_(&SerialExecutor::run, this)
+{
+}
+
+SerialExecutor::~SerialExecutor()
+{
+	stop();
+}
+
+bool SerialExecutor::post(const task_t& task, const task_t& cancel /*= task_t()*/)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (stop_)
+			return false;
+		Task entry;
+		entry.run_ = task;
+		entry.cancel_ = cancel;
+		tasks_.push_back(entry);
+	}
+
+	cv_.notify_one();
+	return true;
+}
+
+void SerialExecutor::stop()
+{
+	std::deque<Task> dropped;
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stop_ = true;
+		dropped.swap(tasks_);
+	}
+
+	cv_.notify_one();
+
+	if (thread_.joinable() && thread_.get_id() != std::this_thread::get_id())
+		thread_.join();
+
+	for (size_t i = 0; i < dropped.size(); i++) {
+		if (dropped[i].cancel_)
+			dropped[i].cancel_();
+	}
+}
+
+size_t SerialExecutor::pending() const
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return tasks_.size();
+}
+
+void SerialExecutor::run()
+{
+	if (!name_.empty())
+		prctl(PR_SET_NAME, name_.substr(0, 15).c_str(), 0, 0, 0);
+
+	while (true) {
+		Task task;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			cv_.wait(lock, [this] { return stop_ || !tasks_.empty(); });
+			if (stop_)
+				break;
+			task = tasks_.front();
+			tasks_.pop_front();
+		}
+
+		task.run_();
+	}
+}
+
+}}}
@@ -0,0 +1,54 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+// Runs posted tasks one at a time, in order, on a dedicated thread
+class SerialExecutor {
+public:
+	typedef std::function<void()> task_t;
+
+	SerialExecutor(const std::string& name = "");
+
+	~SerialExecutor();
+
+	// cancel (optional) runs instead of task when stop() drops it, so whoever
+	// waits on the task is told
+	bool post(const task_t& task, const task_t& cancel = task_t());
+
+	// Cancels tasks that did not start yet and joins the worker thread. The
+	// cancel functions run on the calling thread.
+	void stop();
+
+	size_t pending() const;
+
+private:
+	SerialExecutor(const SerialExecutor&);
+	SerialExecutor& operator=(const SerialExecutor&);
+
+	void run();
+
+	class Task {
+	public:
+		task_t run_;
+		task_t cancel_;
+	};
+
+	std::string name_;
+
+	mutable std::mutex mutex_;
+	std::condition_variable cv_;
+	std::deque<Task> tasks_;
+	bool stop_;
+
+	std::thread thread_;
+};
+
+}}}
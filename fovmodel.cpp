@@ -0,0 +1,172 @@
+#include <streamer/processor/ptz/fovmodel.h>
+#include <math.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+static const float radians = (float) (M_PI / 180.0);
+
+static float clamp(float value, float min, float max)
+{
+	return (value < min) ? min : ((value > max) ? max : value);
+}
+
+static float to_focal(float hfov)
+{
+	return 1.0f / tanf(clamp(hfov, 0.1f, 179.0f) * radians / 2);
+}
+
+FovModel::FovModel(float wide_hfov, float tele_hfov, float aspect)
+	: samples_(0)
+{
+	set(wide_hfov, tele_hfov, aspect);
+}
+
+void FovModel::set(float wide_hfov, float tele_hfov, float aspect)
+{
+	wide_hfov = clamp(wide_hfov, 0.1f, 179.0f);
+	tele_hfov = clamp(tele_hfov, 0.1f, wide_hfov);
+
+	wide_focal_ = to_focal(wide_hfov);
+	tele_focal_ = to_focal(tele_hfov);
+	set_aspect(aspect);
+}
+
+bool FovModel::add_sample(float zoom, float hfov)
+{
+	if (samples_ >= MaxSamples || !isfinite(zoom) || !isfinite(hfov))
+		return false;
+
+	zoom = clamp(zoom, 0, 1);
+	uint32_t i = samples_;
+	while (i > 0 && sample_zoom_[i - 1] > zoom) {
+		sample_zoom_[i] = sample_zoom_[i - 1];
+		sample_focal_[i] = sample_focal_[i - 1];
+		i--;
+	}
+	sample_zoom_[i] = zoom;
+	sample_focal_[i] = to_focal(hfov);
+	samples_++;
+	return true;
+}
+
+void FovModel::sample(uint32_t i, float& zoom, float& hfov) const
+{
+	zoom = sample_zoom_[i];
+	hfov = 2 * atanf(1.0f / sample_focal_[i]) / radians;
+}
+
+void FovModel::set_aspect(float aspect)
+{
+	aspect_ = (aspect > 0 && isfinite(aspect)) ? aspect : 16.0f / 9.0f;
+}
+
+float FovModel::wide_hfov() const
+{
+	return hfov(0);
+}
+
+float FovModel::tele_hfov() const
+{
+	return hfov(1);
+}
+
+float FovModel::hfov(float zoom) const
+{
+	return 2 * atanf(1.0f / focal(zoom)) / radians;
+}
+
+float FovModel::vfov(float zoom) const
+{
+	return 2 * atanf(1.0f / (focal(zoom) * aspect_)) / radians;
+}
+
+float FovModel::zoom_for_scale(float zoom, float scale) const
+{
+	if (!(scale > 0))
+		return clamp(zoom, 0, 1);
+
+	return zoom_for_focal(focal(zoom) / scale);
+}
+
+void FovModel::center(float x, float y, float zoom, float tilt, float& pan_delta, float& tilt_delta) const
+{
+	float f = focal(zoom);
+
+	// Ray through the point in camera coordinates, z forward and y up
+	float rx = x;
+	float ry = -y / aspect_;
+	float rz = f;
+
+	// Rotate by the camera elevation into pan aligned coordinates
+	float elevation = tilt * radians;
+	float wy = rz * sinf(elevation) + ry * cosf(elevation);
+	float wz = rz * cosf(elevation) - ry * sinf(elevation);
+
+	pan_delta = atan2f(rx, wz) / radians;
+	tilt_delta = atan2f(wy, sqrtf(rx * rx + wz * wz)) / radians - tilt;
+}
+
+bool FovModel::project(float pan_delta, float tilt_delta, float zoom, float tilt, float& x, float& y) const
+{
+	float f = focal(zoom);
+
+	// Direction in pan aligned coordinates, z forward and y up
+	float azimuth = pan_delta * radians;
+	float elevation = (tilt + tilt_delta) * radians;
+	float wx = cosf(elevation) * sinf(azimuth);
+	float wy = sinf(elevation);
+	float wz = cosf(elevation) * cosf(azimuth);
+
+	// Rotate back by the camera elevation
+	float camera = tilt * radians;
+	float cy = wy * cosf(camera) - wz * sinf(camera);
+	float cz = wz * cosf(camera) + wy * sinf(camera);
+	if (cz <= 0) {
+		x = y = 0;
+		return false;
+	}
+
+	x = f * wx / cz;
+	y = -f * cy / cz * aspect_;
+	return fabsf(x) <= 1 && fabsf(y) <= 1;
+}
+
+float FovModel::focal(float zoom) const
+{
+	zoom = clamp(zoom, 0, 1);
+	if (samples_ < 2)
+		return wide_focal_ + zoom * (tele_focal_ - wide_focal_);
+
+	// Piecewise linear, the outer segments extend to the ends of the range
+	uint32_t i = 1;
+	while (i < samples_ - 1 && zoom > sample_zoom_[i])
+		i++;
+
+	float span = sample_zoom_[i] - sample_zoom_[i - 1];
+	if (span <= 0)
+		return sample_focal_[i];
+	return sample_focal_[i - 1] + (zoom - sample_zoom_[i - 1]) / span * (sample_focal_[i] - sample_focal_[i - 1]);
+}
+
+float FovModel::zoom_for_focal(float target) const
+{
+	if (samples_ < 2) {
+		if (tele_focal_ == wide_focal_)
+			return 0;
+		return clamp((target - wide_focal_) / (tele_focal_ - wide_focal_), 0, 1);
+	}
+
+	// Focal length grows with zoom, find the segment containing target
+	uint32_t i = 1;
+	while (i < samples_ - 1 && target > sample_focal_[i])
+		i++;
+
+	float span = sample_focal_[i] - sample_focal_[i - 1];
+	if (span <= 0)
+		return sample_zoom_[i];
+	return clamp(sample_zoom_[i - 1] + (target - sample_focal_[i - 1]) / span * (sample_zoom_[i] - sample_zoom_[i - 1]), 0, 1);
+}
+
+}}}
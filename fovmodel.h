@@ -0,0 +1,73 @@
+#pragma once
+#include <stdint.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+// Field of view of a camera over its zoom range. Without calibration samples
+// the focal length is taken as linear in the zoom position, with samples it is
+// interpolated between them. The image follows a pinhole projection. Angles are
+// in degrees, zoom is 0 (wide) to 1 (tele) and image points are -1 to 1 from
+// the frame center with y downwards. Fixed size, copies never allocate.
+class FovModel {
+public:
+	enum {
+		MaxSamples = 16
+	};
+
+	FovModel(float wide_hfov = 60.0f, float tele_hfov = 3.0f, float aspect = 16.0f / 9.0f);
+
+	void set(float wide_hfov, float tele_hfov, float aspect);
+
+	void set_aspect(float aspect);
+
+	float wide_hfov() const;
+
+	float tele_hfov() const;
+
+	float aspect() const { return aspect_; }
+
+	// Measured horizontal field of view at a zoom position, false when full
+	bool add_sample(float zoom, float hfov);
+
+	void clear_samples() { samples_ = 0; }
+
+	uint32_t samples() const { return samples_; }
+
+	void sample(uint32_t i, float& zoom, float& hfov) const;
+
+	float hfov(float zoom) const;
+
+	float vfov(float zoom) const;
+
+	// Zoom position at which the image is scale times as wide as at zoom,
+	// clamped to the zoom range
+	float zoom_for_scale(float zoom, float scale) const;
+
+	// Pan and tilt change that brings the image point x, y to the center, for
+	// a camera looking tilt degrees above the horizon
+	void center(float x, float y, float zoom, float tilt, float& pan_delta, float& tilt_delta) const;
+
+	// Inverse of center(), image point of the direction pan_delta, tilt +
+	// tilt_delta. False when it is outside the image.
+	bool project(float pan_delta, float tilt_delta, float zoom, float tilt, float& x, float& y) const;
+
+private:
+	// Focal length in units of half the image width
+	float focal(float zoom) const;
+
+	// Zoom position with the given focal length
+	float zoom_for_focal(float focal) const;
+
+	float wide_focal_;
+	float tele_focal_;
+	float aspect_;
+
+	// Sorted by zoom
+	float sample_zoom_[MaxSamples];
+	float sample_focal_[MaxSamples];
+	uint32_t samples_;
+};
+
+}}}
@@ -0,0 +1,102 @@
+#pragma once
+#include <atomic>
+#include <string>
+#include <stdint.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+// Lock free histogram with power of two buckets, bucket i counts values in [2^(i-1), 2^i)
+class Histogram {
+public:
+	enum {
+		Buckets = 32
+	};
+
+	Histogram()
+	{
+		reset();
+	}
+
+	void record(uint64_t value)
+	{
+		counts_[bucket(value)].fetch_add(1, std::memory_order_relaxed);
+		count_.fetch_add(1, std::memory_order_relaxed);
+		sum_.fetch_add(value, std::memory_order_relaxed);
+
+		uint64_t max = max_.load(std::memory_order_relaxed);
+		while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed))
+			;
+	}
+
+	void reset()
+	{
+		for (int i = 0; i < Buckets; i++)
+			counts_[i].store(0, std::memory_order_relaxed);
+		count_.store(0, std::memory_order_relaxed);
+		sum_.store(0, std::memory_order_relaxed);
+		max_.store(0, std::memory_order_relaxed);
+	}
+
+	uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+
+	uint64_t sum() const { return sum_.load(std::memory_order_relaxed); }
+
+	uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+
+	uint64_t bucket_count(int i) const { return counts_[i].load(std::memory_order_relaxed); }
+
+	// Upper bound of the bucket containing the p-th percentile (0 - 100)
+	uint64_t percentile(double p) const
+	{
+		uint64_t total = count();
+		if (!total)
+			return 0;
+
+		uint64_t rank = (uint64_t) (total * p / 100.0);
+		uint64_t seen = 0;
+		for (int i = 0; i < Buckets; i++) {
+			seen += bucket_count(i);
+			if (seen > rank)
+				return upper_bound(i);
+		}
+		return max();
+	}
+
+	static uint64_t upper_bound(int i)
+	{
+		return (i == 0) ? 0 : ((uint64_t) 1 << i) - 1;
+	}
+
+	// e.g. "count = 10 mean = 310 p50 = 511 p90 = 1023 p99 = 1023 max = 700"
+	std::string summary() const
+	{
+		uint64_t total = count();
+		return std::string("count = ") + std::to_string(total)
+			+ " mean = " + std::to_string(total ? sum() / total : 0)
+			+ " p50 = " + std::to_string(percentile(50))
+			+ " p90 = " + std::to_string(percentile(90))
+			+ " p99 = " + std::to_string(percentile(99))
+			+ " max = " + std::to_string(max());
+	}
+
+private:
+
+	static int bucket(uint64_t value)
+	{
+		int i = 0;
+		while (value && i < Buckets - 1) {
+			value >>= 1;
+			i++;
+		}
+		return i;
+	}
+
+	std::atomic<uint64_t> counts_[Buckets];
+	std::atomic<uint64_t> count_;
+	std::atomic<uint64_t> sum_;
+	std::atomic<uint64_t> max_;
+};
+
+}}}
@@ -0,0 +1,114 @@
+#include <streamer/processor/ptz/movetracker.h>
+#include <math.h>
+#include <algorithm>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+MoveTracker::Move::Move(const MoveTracker& tracker, float fraction, float x, float y, float z)
+	: start_(clock_t::now())
+	, eta_ms_(tracker.predict(fraction))
+	, settle_ms_(tracker.settle_ms_)
+	, timeout_ms_(tracker.timeout_ms_)
+	, backoff_(tracker.min_interval_ms_, tracker.max_interval_ms_, 1.5)
+	, first_(true)
+	, moving_(false)
+	, fraction_(fraction)
+	, x_(x)
+	, y_(y)
+	, z_(z)
+{
+}
+
+uint32_t MoveTracker::Move::elapsed_ms() const
+{
+	return (uint32_t) std::chrono::duration_cast<std::chrono::milliseconds>(clock_t::now() - start_).count();
+}
+
+uint32_t MoveTracker::Move::next_delay()
+{
+	uint32_t elapsed = elapsed_ms();
+	if (elapsed >= timeout_ms_)
+		return 0;
+
+	uint32_t delay = backoff_.next();
+	if (first_) {
+		first_ = false;
+		if (eta_ms_ > delay)
+			delay = eta_ms_;
+	}
+
+	if (delay > timeout_ms_ - elapsed)
+		delay = timeout_ms_ - elapsed;
+
+	return delay;
+}
+
+bool MoveTracker::Move::update(bool idle, float x, float y, float z)
+{
+	if (!idle) {
+		moving_ = true;
+		return false;
+	}
+
+	// Some devices still report Idle before the motor starts, accept Idle only
+	// once the camera was seen moving, the position changed or both the ETA
+	// and the settle time passed. The ETA is 0 for moves of unknown size.
+	bool moved = (x != x_) || (y != y_) || (z != z_);
+
+	return (moving_ || moved || elapsed_ms() >= std::max(eta_ms_, settle_ms_));
+}
+
+MoveTracker::MoveTracker(uint32_t min_interval_ms /*= 100*/, uint32_t max_interval_ms /*= 1000*/, uint32_t full_travel_ms /*= 4000*/)
+	: min_interval_ms_(min_interval_ms)
+	, max_interval_ms_(max_interval_ms)
+	, timeout_ms_(6000)
+	, settle_ms_(500)
+	, full_travel_ms_(full_travel_ms)
+	, timeouts_(0)
+{
+}
+
+MoveTracker::Move MoveTracker::start(float fraction, float x, float y, float z) const
+{
+	return Move(*this, fraction, x, y, z);
+}
+
+uint32_t MoveTracker::predict(float fraction) const
+{
+	fraction = fabsf(fraction);
+	if (fraction > 1.0)
+		fraction = 1.0;
+
+	return (uint32_t) (fraction * full_travel_ms_.load());
+}
+
+void MoveTracker::complete(const Move& move)
+{
+	uint32_t elapsed = move.elapsed_ms();
+	time_to_idle_.record(elapsed);
+
+	// Refine the full travel estimate from moves large enough to be meaningful
+	float fraction = fabsf(move.fraction_);
+	if (move.moving_ && fraction > 0.05 && fraction <= 1.0) {
+		uint32_t observed = (uint32_t) (elapsed / fraction);
+		uint32_t current = full_travel_ms_.load();
+		full_travel_ms_.store((uint32_t) (current * 0.8 + observed * 0.2));
+	}
+}
+
+void MoveTracker::timeout(const Move& move)
+{
+	timeouts_++;
+	time_to_idle_.record(move.elapsed_ms());
+}
+
+std::string MoveTracker::report() const
+{
+	return std::string("time to idle (ms) ") + time_to_idle_.summary()
+		+ " timeouts = " + std::to_string(timeouts())
+		+ " full travel (ms) = " + std::to_string(full_travel_ms_.load());
+}
+
+}}}
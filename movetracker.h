@@ -0,0 +1,86 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <streamer/processor/ptz/backoff.h>
+#include <streamer/processor/ptz/histogram.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+// Decides when to poll GetStatus after a move and records how long moves take
+// to report Idle. Polling starts at the predicted ETA and then backs off from
+// min_interval up to max_interval until the timeout expires.
+class MoveTracker {
+public:
+	typedef std::chrono::steady_clock clock_t;
+
+	class Move {
+	public:
+		// Delay in ms before the next status poll, 0 once the move timed out
+		uint32_t next_delay();
+
+		// Feed a status reply, returns true when the move is complete
+		bool update(bool idle, float x, float y, float z);
+
+		uint32_t elapsed_ms() const;
+
+	private:
+		friend class MoveTracker;
+
+		Move(const MoveTracker& tracker, float fraction, float x, float y, float z);
+
+		clock_t::time_point start_;
+		uint32_t eta_ms_;
+		uint32_t settle_ms_;
+		uint32_t timeout_ms_;
+		Backoff backoff_;
+		bool first_;
+		bool moving_;
+		float fraction_;
+		float x_;
+		float y_;
+		float z_;
+	};
+
+	MoveTracker(uint32_t min_interval_ms = 100, uint32_t max_interval_ms = 1000, uint32_t full_travel_ms = 4000);
+
+	void set_timeout(uint32_t timeout_ms) { timeout_ms_ = timeout_ms; }
+
+	// An Idle reply with the position unchanged completes a move only after
+	// this long or the ETA, whichever is later. Covers moves of unknown size
+	// (presets, home, focus) on devices that answer Idle before the motor starts.
+	void set_settle(uint32_t settle_ms) { settle_ms_ = settle_ms; }
+
+	// fraction = share of the full axis range covered by the move, 0 if unknown.
+	// x/y/z = raw position before the move.
+	Move start(float fraction, float x, float y, float z) const;
+
+	void complete(const Move& move);
+
+	void timeout(const Move& move);
+
+	// Predicted time in ms for a move covering fraction of the full axis range
+	uint32_t predict(float fraction) const;
+
+	const Histogram& time_to_idle() const { return time_to_idle_; }
+
+	uint64_t timeouts() const { return timeouts_.load(); }
+
+	std::string report() const;
+
+private:
+	uint32_t min_interval_ms_;
+	uint32_t max_interval_ms_;
+	uint32_t timeout_ms_;
+	uint32_t settle_ms_;
+
+	// Learned time to sweep a full axis range, refined from completed moves
+	std::atomic<uint32_t> full_travel_ms_;
+
+	Histogram time_to_idle_;
+	std::atomic<uint64_t> timeouts_;
+};
+
+}}}
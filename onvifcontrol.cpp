@@ -1,8 +1,15 @@
 #include <streamer/processor/ptz/onvifcontrol.h>
+#include <streamer/processor/ptz/axisconversion.h>
+#include <streamer/processor/ptz/ptztrace.h>
+#include <streamer/processor/ptz/ptzcache.h>
 #include <streamer/core/camera.h>
 #include <streamer/common/utilities.h>
 #include <streamer/common/string.h>
 #include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <future>
 #include <fcntl.h>
 #include <sys/prctl.h>
 #include "wsdd.nsmap"
@@ -16,90 +23,378 @@ common::Buffer::ptr_t common::Utilities::cb_buffer_ = std::make_shared<common::B
 namespace orion {
 namespace streamer {
 namespace processor {
+
+thread_local bool OnvifControl::trace_sampled_ = true;
 	
-OnvifControl::OnvifControl(Camera *camera, const std::string& type, common::Logger::logger_t shared_logger) : status_interval_(2), CameraControl(camera, type, shared_logger)
+OnvifControl::OnvifControl(Camera *camera, const std::string& type, common::Logger::logger_t shared_logger) : CameraControl(camera, type, shared_logger)
+	, validated_(false)
+	, status_interval_(2)
+	, fast_path_(true)
+	, fast_path_rejects_(0)
+	, cont_pan_(0)
+	, cont_tilt_(0)
+	, cont_zoom_(0)
+	, cont_deadline_(std::chrono::steady_clock::time_point())
+	, cont_timeout_ms_(1000)
+	, track_stop_(false)
+	, track_fresh_(false)
+	, track_x_(0)
+	, track_y_(0)
+	, track_zoom_(0)
+	, clock_checked_(std::chrono::steady_clock::time_point())
+	, position_refresh_(false)
+	, init_state_(InitState::Uninitialized)
+	, init_attempts_(0)
+	, next_retry_(std::chrono::steady_clock::time_point())
+	, init_backoff_(1000, 60000, 2.0, 0.2)
+	, init_stop_(false)
+	, status_poll_ms_(0)
+	, status_stop_(false)
+	, trace_every_(0)
+	, trace_count_(0)
 {
-	logger()->trace("OnvifControl::{} entry ", __func__);
+	PTZ_TRACE("OnvifControl::{} entry ", __func__);
+
+	// Same worst case as the former three polls spaced status_interval_ apart
+	move_tracker_.set_timeout(status_interval_ * 3 * 1000);
 	
-	init();
+	start_init();
 
-	logger()->trace("OnvifControl::{} (exit)", __func__);
+	PTZ_TRACE("OnvifControl::{} (exit)", __func__);
 }
 
 void OnvifControl::init()
 {
-	logger()->trace("OnvifControl::{} entry ", __func__);
+	PTZ_TRACE("OnvifControl::{} entry ", __func__);
 
-	if (!ready_ && camera_ && !camera_->ptz_control_ip.empty()) {
-		device_url_ = std::string("http://") + camera_->ptz_control_ip + std::string(":");
-		if (camera_->ptz_control_port > 0)
-			device_url_ += std::to_string(camera_->ptz_control_port);
-		else
-			device_url_ += "80";
-		device_url_ += "/onvif/device_service";
-
-		if (SOAP_OK == get_capabilities(device_url_, camera_->username, camera_->password, media_url_, ptz_url_, imaging_url_)) {
-			// insert port to ptz and media url - usable when accessing via tunnel
-			insert_port(camera_->ptz_control_port);
-			if (!media_url_.empty() && SOAP_OK == get_profiles(media_url_,camera_->username, camera_->password, profiles_) && !profiles_.empty()) {
-				if (select_profile(profile_data_, "")) {
-					std::vector<std::string> ptz_nodes;
-					if (!ptz_url_.empty() && SOAP_OK == get_ptz_nodes(ptz_url_, camera_->username, camera_->password, ptz_nodes) && !ptz_nodes.empty()) {
-						if (SOAP_OK == get_ptz_node(ptz_url_, camera_->username, camera_->password, ptz_nodes[0], ptz_details_)) {
-							debug_ptz_node();
-							img_get_move_options(imaging_url_, profile_data_, camera_->username, camera_->password);
-							this->ready_ = true;
-						}
-					}
-				}
+	if (camera_ && !camera_->ptz_control_ip.empty()) {
+		if (device_url_.empty()) {
+			device_url_ = std::string("http://") + camera_->ptz_control_ip + std::string(":");
+			if (camera_->ptz_control_port > 0)
+				device_url_ += std::to_string(camera_->ptz_control_port);
+			else
+				device_url_ += "80";
+			device_url_ += "/onvif/device_service";
+		}
+
+		// Not every device implements GetDeviceInformation, an empty firmware
+		// simply means the cached configuration is always rediscovered
+		std::string firmware;
+		std::future<int> information = std::async(std::launch::async, [&]() {
+			return get_device_information(device_url_, camera_->username, camera_->password, firmware);
+		});
+
+		// A cached configuration is only rediscovered when the firmware changed,
+		// on a cold start discovery overlaps with GetDeviceInformation
+		if (ready_)
+			information.wait();
+
+		if (ready_ && !firmware.empty() && firmware == firmware_) {
+			logger()->debug("OnvifControl::{} cached configuration valid for firmware = {}", __func__, firmware);
+			validated_ = true;
+		} else {
+			OnvifDeviceConfig config;
+			bool discovered = discover(config);
+			information.wait();
+			if (discovered) {
+				config.firmware_ = firmware;
+				apply(config);
+
+				PtzCache cache;
+				if (!cache.store(cache_key(), config))
+					logger()->debug("OnvifControl::{} failed to store configuration in {}", __func__, PtzCache::default_directory());
+
+				validated_ = true;
+				this->ready_ = true;
 			}
 		}
 	}
 
-	logger()->trace("OnvifControl::{} initialized = {} (exit)", __func__,  ready_ ? "True" : "False");
+	PTZ_TRACE("OnvifControl::{} initialized = {} (exit)", __func__,  ready_ ? "True" : "False");
 }	
 
+bool OnvifControl::discover(OnvifDeviceConfig& config)
+{
+	PTZ_TRACE("OnvifControl::{} entry ", __func__);
+	bool ret = false;
+
+	typedef std::chrono::steady_clock clock;
+	clock::time_point start = clock::now();
+	uint32_t caps_ms = 0, profiles_ms = 0, options_ms = 0, nodes_ms = 0, node_ms = 0;
+
+	if (SOAP_OK == get_capabilities(device_url_, camera_->username, camera_->password, config.media_url_, config.ptz_url_, config.imaging_url_)) {
+		caps_ms = elapsed_ms(start);
+		// insert port to ptz and media url - usable when accessing via tunnel
+		insert_port(camera_->ptz_control_port, config);
+
+		// Media and PTZ services are independent once the urls are known, query
+		// them concurrently: profiles -> imaging move options || nodes -> node
+		std::future<bool> media = std::async(std::launch::async, [&]() {
+			clock::time_point t = clock::now();
+			bool ok = !config.media_url_.empty() && SOAP_OK == get_profiles(config.media_url_,camera_->username, camera_->password, config.profiles_) && !config.profiles_.empty()
+				&& select_profile(config.profiles_, config.profile_data_, "");
+			profiles_ms = elapsed_ms(t);
+			if (ok) {
+				t = clock::now();
+				img_get_move_options(config.imaging_url_, config.profile_data_, camera_->username, camera_->password);
+				options_ms = elapsed_ms(t);
+			}
+			return ok;
+		});
+
+		bool ptz = false;
+		clock::time_point t = clock::now();
+		std::vector<std::string> ptz_nodes;
+		if (!config.ptz_url_.empty() && SOAP_OK == get_ptz_nodes(config.ptz_url_, camera_->username, camera_->password, ptz_nodes) && !ptz_nodes.empty()) {
+			nodes_ms = elapsed_ms(t);
+			t = clock::now();
+			ptz = (SOAP_OK == get_ptz_node(config.ptz_url_, camera_->username, camera_->password, ptz_nodes[0], config.ptz_details_));
+			node_ms = elapsed_ms(t);
+		}
+
+		ret = media.get() && ptz;
+	}
+
+	logger()->debug("OnvifControl::{} ret = {} total = {} ms capabilities = {} ms profiles = {} ms move options = {} ms nodes = {} ms node = {} ms",
+		__func__, ret, elapsed_ms(start), caps_ms, profiles_ms, options_ms, nodes_ms, node_ms);
+
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	return ret;
+}
+
+uint32_t OnvifControl::elapsed_ms(std::chrono::steady_clock::time_point start)
+{
+	return (uint32_t) std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void OnvifControl::apply(const OnvifDeviceConfig& config)
+{
+	// Commands hold config_mutex_ while running, never swap under their feet
+	std::lock_guard<std::mutex> lock(config_mutex_);
+
+	firmware_ = config.firmware_;
+	media_url_ = config.media_url_;
+	ptz_url_ = config.ptz_url_;
+	imaging_url_ = config.imaging_url_;
+	profiles_ = config.profiles_;
+	profile_data_ = config.profile_data_;
+	ptz_details_ = config.ptz_details_;
+	build_axis_table(ptz_details_);
+	templates_.build(profile_data_.token_);
+
+	// A calibration survives rediscovery, otherwise the limits seed the maps
+	PtzCalibration calibration = calibration_.load();
+	PtzCache cache;
+	if (!cache.load_calibration(cache_key(), calibration)) {
+		const AxisScale& pan_tilt = ptz_details_.axis_table_[AxisSpace::AbsPT];
+		const AxisScale& zoom = ptz_details_.axis_table_[AxisSpace::AbsZ];
+		calibration.set_limits(pan_tilt.valid_ ? pan_tilt : ptz_details_.axis_table_[AxisSpace::RelPT],
+			zoom.valid_ ? zoom : ptz_details_.axis_table_[AxisSpace::RelZ]);
+	}
+	calibration_.store(calibration);
+
+	debug_ptz_node();
+}
+
+bool OnvifControl::load_cached_config()
+{
+	bool ret = false;
+
+	if (camera_ && !camera_->ptz_control_ip.empty()) {
+		PtzCache cache;
+		OnvifDeviceConfig config;
+		if (cache.load(cache_key(), config)) {
+			apply(config);
+			this->ready_ = true;
+			ret = true;
+		}
+	}
+
+	logger()->debug("OnvifControl::{} key = {} found = {}", __func__, cache_key(), ret);
+	return ret;
+}
+
+std::string OnvifControl::cache_key() const
+{
+	return camera_ ? camera_->ptz_control_ip + ":" + std::to_string(camera_->ptz_control_port) : std::string();
+}
+
+void OnvifControl::start_init()
+{
+	std::lock_guard<std::mutex> lock(init_mutex_);
+	if (!init_thread_.joinable() && !init_stop_)
+		init_thread_ = std::thread(&OnvifControl::init_loop, this);
+}
+
+void OnvifControl::init_loop()
+{
+	prctl(PR_SET_NAME, "ptz-onvif-init", 0, 0, 0);
+	PTZ_TRACE("OnvifControl::{} (entry)", __func__);
+
+	// Come up from the cached configuration right away, init() revalidates it
+	if (load_cached_config())
+		init_state_ = InitState::Connected;
+
+	while (true) {
+		if (!ready_)
+			init_state_ = InitState::Connecting;
+		init_attempts_++;
+
+		init();
+
+		if (validated_) {
+			init_backoff_.reset();
+			init_state_ = InitState::Connected;
+			break;
+		}
+
+		uint32_t delay = init_backoff_.next();
+		next_retry_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(delay);
+		if (!ready_)
+			init_state_ = InitState::WaitingRetry;
+		logger()->debug("OnvifControl::{} attempt = {} failed, retry in {} ms", __func__, init_attempts_.load(), delay);
+
+		std::unique_lock<std::mutex> lock(init_mutex_);
+		if (init_cv_.wait_for(lock, std::chrono::milliseconds(delay), [this] { return init_stop_; }))
+			break;
+	}
+
+	PTZ_TRACE("OnvifControl::{} state = {} (exit)", __func__, to_str(init_state()));
+}
+
+void OnvifControl::stop_init()
+{
+	{
+		std::lock_guard<std::mutex> lock(init_mutex_);
+		init_stop_ = true;
+	}
+	init_cv_.notify_all();
+
+	if (init_thread_.joinable())
+		init_thread_.join();
+}
+
+void OnvifControl::set_status_polling(uint32_t interval_ms)
+{
+	if (!interval_ms) {
+		stop_status_polling();
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(status_mutex_);
+		status_poll_ms_ = interval_ms;
+		status_stop_ = false;
+		if (!status_thread_.joinable()) {
+			status_thread_ = std::thread(&OnvifControl::status_loop, this);
+			return;
+		}
+	}
+	status_cv_.notify_all();
+}
+
+void OnvifControl::stop_status_polling()
+{
+	{
+		std::lock_guard<std::mutex> lock(status_mutex_);
+		status_stop_ = true;
+	}
+	status_cv_.notify_all();
+
+	if (status_thread_.joinable())
+		status_thread_.join();
+}
+
+void OnvifControl::status_loop()
+{
+	prctl(PR_SET_NAME, "ptz-onvif-status", 0, 0, 0);
+	PTZ_TRACE("OnvifControl::{} (entry)", __func__);
+
+	std::unique_lock<std::mutex> lock(status_mutex_);
+	while (!status_stop_) {
+		uint32_t interval = status_poll_ms_;
+		lock.unlock();
+
+		if (InitState::Connected == init_state()) {
+			std::unique_lock<std::mutex> config_lock(config_mutex_, std::try_to_lock);
+			if (config_lock.owns_lock()) {
+				float x = 0, y = 0, z = 0;
+				int status = 0;
+				if (SOAP_OK == send_get_status(ptz_url_, profile_data_.token_, camera_->username, camera_->password, x, y, z, status))
+					save_position(x, y, z, status);
+			}
+		}
+
+		lock.lock();
+		status_cv_.wait_for(lock, std::chrono::milliseconds(interval), [this] { return status_stop_; });
+	}
+
+	PTZ_TRACE("OnvifControl::{} (exit)", __func__);
+}
+
+uint32_t OnvifControl::init_retry_in() const
+{
+	uint32_t ret = 0;
+
+	if (InitState::WaitingRetry == init_state()) {
+		std::chrono::steady_clock::duration remaining = next_retry_.load() - std::chrono::steady_clock::now();
+		if (remaining.count() > 0)
+			ret = (uint32_t) std::chrono::duration_cast<std::chrono::milliseconds>(remaining).count();
+	}
+
+	return ret;
+}
+
 OnvifControl::~OnvifControl()
 {
-	logger()->trace("OnvifControl::{} entry ", __func__);
+	PTZ_TRACE("OnvifControl::{} entry ", __func__);
+
+	stop_async();
+	stop_tracking();
+	stop_init();
+	stop_status_polling();
+
+	ProxyPoolStats ptz = proxies_.ptz_.stats();
+	logger()->debug("OnvifControl::{} ptz connections hits = {} misses = {} reconnects = {}", __func__, ptz.hits_, ptz.misses_, ptz.reconnects_);
+	logger()->debug("OnvifControl::{} {}", __func__, move_tracker_.report());
+	if (track_latency_us_.count())
+		logger()->debug("OnvifControl::{} tracking latency us {}", __func__, track_latency_us_.summary());
 }
 
-bool OnvifControl::select_profile(ProfileData &data, const std::string& token /*= ""*/)
+bool OnvifControl::select_profile(const std::vector<ProfileData>& profiles, ProfileData &data, const std::string& token /*= ""*/)
 {
-	logger()->trace("OnvifControl::{} token = {} (entry)", __func__, token);
+	PTZ_TRACE("OnvifControl::{} token = {} (entry)", __func__, token);
 
 	bool ret = false;
 
-	if (!profiles_.empty()) {
+	if (!profiles.empty()) {
 		bool found = false;
-		for (uint32_t i =0; i < profiles_.size(); i++) {
-			if (profiles_[i].token_.compare(token)) {
-				data = profiles_[i];
+		for (uint32_t i =0; i < profiles.size(); i++) {
+			if (profiles[i].token_.compare(token)) {
+				data = profiles[i];
 				found = true;
 				break;
 			}
 		}
 
 		if (!found)
-			data = profiles_[0];		
+			data = profiles[0];		
 
 		ret = true;
 	}
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 
 	return ret;
 }
 
 int OnvifControl::set_date_and_time(const std::string& device)
 {
-	logger()->trace("OnvifControl::{} (entry)", __func__, device);
+	PTZ_TRACE("OnvifControl::{} (entry)", __func__, device);
 
 	int ret = SOAP_ERR;
 
-	struct soap soap;
-	soap_init(&soap);
-	DeviceBindingProxy proxy(&soap);
+	ProxyPool<DeviceBindingProxy>::Lease proxy(proxies_.device_);
 
 	_tds__SetSystemDateAndTime tds__SetSystemDateAndTime;
 	_tds__SetSystemDateAndTimeResponse tds__SetSystemDateAndTimeResponse;
@@ -115,54 +410,58 @@ int OnvifControl::set_date_and_time(const std::string& device)
 	tds__SetSystemDateAndTime.UTCDateTime->Time->Minute = dt->tm_min;
 	tds__SetSystemDateAndTime.UTCDateTime->Time->Second = dt->tm_sec;
 
-	ret = proxy.SetSystemDateAndTime(device.c_str(), NULL, &tds__SetSystemDateAndTime, &tds__SetSystemDateAndTimeResponse);
+	ret = invoke(ControlMetrics::SetSystemDateAndTime, proxy, [&](DeviceBindingProxy& p) {
+		return p.SetSystemDateAndTime(device.c_str(), NULL, &tds__SetSystemDateAndTime, &tds__SetSystemDateAndTimeResponse);
+	});
 	if (SOAP_OK == ret)
-		logger()->trace("OnvifControl::{} success", __func__);
+		PTZ_TRACE("OnvifControl::{} success", __func__);
 	else
 		logger()->error("OnvifControl::{} failed", __func__);
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
 int OnvifControl::system_reboot(const std::string& device, const std::string& username, const std::string& password)
 {
-	logger()->trace("OnvifControl::{} device = {} username = {} password = {} (entry)", __func__, device, username, password);
+	PTZ_TRACE("OnvifControl::{} device = {} (entry)", __func__, device);
 	int ret = SOAP_ERR;
 
 	if (!device.empty()) {
-		DeviceBindingProxy proxy(device.c_str());
+		ProxyPool<DeviceBindingProxy>::Lease proxy(proxies_.device_);
 
 		_tds__SystemReboot tds__SystemReboot;
 		_tds__SystemRebootResponse response;
 
-		add_credential(proxy.soap, username, password);
-
-		ret = proxy.SystemReboot(&tds__SystemReboot, &response);
+		ret = invoke(ControlMetrics::SystemReboot, proxy, [&](DeviceBindingProxy& p) {
+			add_credential(p.soap, username, password);
+			return p.SystemReboot(device.c_str(), NULL, &tds__SystemReboot, &response);
+		});
 		if (SOAP_OK == ret)
-			logger()->trace("OnvifControl::{} successfully rebooted device service= {}!", __func__, device);
+			PTZ_TRACE("OnvifControl::{} successfully rebooted device service= {}!", __func__, device);
 		else
 			logger()->error("OnvifControl::{} failed to reboot device service = {}!", __func__, device);
 	}
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
 int OnvifControl::get_capabilities(const std::string& device, const std::string& username, const std::string& password, std::string& media, std::string& ptz, std::string& imaging)
 {
-	logger()->trace("OnvifControl::{} device = {} username = {} password = {} (entry)", __func__, device, username, password);
+	PTZ_TRACE("OnvifControl::{} device = {} (entry)", __func__, device);
 	int ret = SOAP_ERR;
 
 	if (!device.empty()) {
-		DeviceBindingProxy proxy(device.c_str());
+		ProxyPool<DeviceBindingProxy>::Lease proxy(proxies_.device_);
 
 		_tds__GetCapabilities tds__GetCapabilities;
 		_tds__GetCapabilitiesResponse response;
 
-		add_credential(proxy.soap, username, password);
-
-		ret = proxy.GetCapabilities(&tds__GetCapabilities, &response);
+		ret = invoke(ControlMetrics::GetCapabilities, proxy, [&](DeviceBindingProxy& p) {
+			add_credential(p.soap, username, password);
+			return p.GetCapabilities(device.c_str(), NULL, &tds__GetCapabilities, &response);
+		});
 		if (SOAP_OK == ret) {
 			if (response.Capabilities->Media && response.Capabilities->Media->XAddr.length())
 				media = response.Capabilities->Media->XAddr;
@@ -175,36 +474,265 @@ int OnvifControl::get_capabilities(const std::string& device, const std::string&
 		}
 	}
 
-	logger()->trace("OnvifControl::{} ret = {} media = {} ptz = {} imaging = {} (exit)", __func__, ret, media, ptz, imaging);
+	PTZ_TRACE("OnvifControl::{} ret = {} media = {} ptz = {} imaging = {} (exit)", __func__, ret, media, ptz, imaging);
+	return ret;
+}
+
+int OnvifControl::get_device_information(const std::string& device, const std::string& username, const std::string& password, std::string& firmware)
+{
+	PTZ_TRACE("OnvifControl::{} device = {} (entry)", __func__, device);
+	int ret = SOAP_ERR;
+
+	if (!device.empty()) {
+		ProxyPool<DeviceBindingProxy>::Lease proxy(proxies_.device_);
+
+		_tds__GetDeviceInformation tds__GetDeviceInformation;
+		_tds__GetDeviceInformationResponse response;
+
+		ret = invoke(ControlMetrics::GetDeviceInformation, proxy, [&](DeviceBindingProxy& p) {
+			add_credential(p.soap, username, password);
+			return p.GetDeviceInformation(device.c_str(), NULL, &tds__GetDeviceInformation, &response);
+		});
+		if (SOAP_OK == ret)
+			firmware = response.Manufacturer + " " + response.Model + " " + response.FirmwareVersion;
+		else
+			logger()->debug("OnvifControl::{} failed to retrieve device information from device service = {}", __func__, device);
+	}
+
+	PTZ_TRACE("OnvifControl::{} ret = {} firmware = {} (exit)", __func__, ret, firmware);
 	return ret;
 }
 
+bool OnvifControl::fast_path_failed(ControlMetrics::Operation op, int ret, bool sent)
+{
+	if (SOAP_OK == ret) {
+		fast_path_rejects_.store(0, std::memory_order_relaxed);
+		return false;
+	}
+
+	// Never reached the device, any request can go out again
+	if (!sent)
+		return true;
+
+	// gSOAP returns the HTTP status when the reply carries no SOAP body. A 5xx
+	// may come from a device that acted on the request and failed afterwards.
+	bool refused = (ret >= 400 && ret < 500) || (ret >= 500 && ret < 600 && ControlMetrics::idempotent(op));
+	if (!refused)
+		return false;
+
+	fast_path_rejected(ret);
+	return true;
+}
+
+void OnvifControl::fast_path_rejected(int ret)
+{
+	if (fast_path_rejects_.fetch_add(1, std::memory_order_relaxed) + 1 < FastPathRejects)
+		return;
+
+	if (fast_path_.exchange(false))
+		logger()->warn("OnvifControl::{} precompiled requests failed {} times error = {}, using gSOAP serialization", __func__, (uint32_t) FastPathRejects, ret);
+}
+
+bool OnvifControl::auth_fault(struct soap* soap)
+{
+	// ONVIF ter:NotAuthorized and the WS-Security fault codes
+	static const char* codes[] = { "NotAuthorized", "FailedAuthentication", "MessageExpired", "InvalidSecurity" };
+
+	const char* subcode = soap_fault_subcode(soap);
+	const char* reason = soap_fault_string(soap);
+	for (size_t i = 0; i < sizeof(codes) / sizeof(codes[0]); i++) {
+		if ((subcode && strstr(subcode, codes[i])) || (reason && strstr(reason, codes[i])))
+			return true;
+	}
+	return false;
+}
+
+// Read the device clock after an authentication fault and shift the Created
+// time of the following requests by the offset. Checked at most every 30 s so
+// a wrong password does not double the request rate.
+bool OnvifControl::sync_clock()
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	std::chrono::steady_clock::time_point last = clock_checked_.load();
+	if (last != std::chrono::steady_clock::time_point() && now - last < std::chrono::seconds(30))
+		return false;
+	if (!clock_checked_.compare_exchange_strong(last, now))
+		return false;
+	if (InitState::Connected != init_state() || device_url_.empty())
+		return false;
+
+	PTZ_TRACE("OnvifControl::{} (entry)", __func__);
+
+	ProxyPool<DeviceBindingProxy>::Lease proxy(proxies_.device_);
+
+	_tds__GetSystemDateAndTime tds__GetSystemDateAndTime;
+	_tds__GetSystemDateAndTimeResponse response;
+
+	// Devices answer GetSystemDateAndTime without credentials
+	int ret = invoke(ControlMetrics::GetSystemDateAndTime, proxy, [&](DeviceBindingProxy& p) {
+		return p.GetSystemDateAndTime(device_url_.c_str(), NULL, &tds__GetSystemDateAndTime, &response);
+	});
+	if (SOAP_OK != ret || !response.SystemDateAndTime || !response.SystemDateAndTime->UTCDateTime
+		|| !response.SystemDateAndTime->UTCDateTime->Date || !response.SystemDateAndTime->UTCDateTime->Time) {
+		logger()->error("OnvifControl::{} failed to read device time ret = {}", __func__, ret);
+		return false;
+	}
+
+	const tt__DateTime* utc = response.SystemDateAndTime->UTCDateTime;
+	struct tm device_time = {};
+	device_time.tm_year = utc->Date->Year - 1900;
+	device_time.tm_mon = utc->Date->Month - 1;
+	device_time.tm_mday = utc->Date->Day;
+	device_time.tm_hour = utc->Time->Hour;
+	device_time.tm_min = utc->Time->Minute;
+	device_time.tm_sec = utc->Time->Second;
+
+	int32_t skew = (int32_t) (timegm(&device_time) - time(NULL));
+	PTZ_TRACE("OnvifControl::{} device clock offset = {} s current = {} s (exit)", __func__, skew, credential_.skew());
+
+	// Within the rounding of one second the fault had another cause
+	if (abs(skew - credential_.skew()) < 2)
+		return false;
+
+	logger()->warn("OnvifControl::{} device clock is {} s off, adjusting WS-Security timestamps", __func__, skew);
+	credential_.set_skew(skew);
+	return true;
+}
+
+int OnvifControl::send_request(PTZBindingProxy& p, const std::string& endpoint, PtzTemplates::Request request, const float* values, size_t count,
+	const std::string& username, const std::string& password)
+{
+	static thread_local std::string header;
+	static thread_local std::string body;
+	struct soap* soap = p.soap;
+
+	credential_.header(username, password, header);
+	templates_.get(request).render(header, values, count, body);
+
+	soap_begin(soap);
+	soap_set_version(soap, 2);
+	soap->encodingStyle = NULL;
+	if (soap_begin_count(soap))
+		return soap->error;
+	if ((soap->mode & SOAP_IO_LENGTH) && soap_send_raw(soap, body.data(), body.size()))
+		return soap->error;
+	if (soap_end_count(soap))
+		return soap->error;
+	if (soap_connect(soap, endpoint.c_str(), PtzTemplates::action(request))
+		|| soap_send_raw(soap, body.data(), body.size())
+		|| soap_end_send(soap))
+		return soap_closesock(soap);
+
+	return SOAP_OK;
+}
+
+int OnvifControl::send_status_template(PTZBindingProxy& p, const std::string& endpoint, const std::string& username, const std::string& password, PtzStatusReply& reply, bool& sent)
+{
+	struct soap* soap = p.soap;
+
+	int ret = send_request(p, endpoint, PtzTemplates::GetStatus, NULL, 0, username, password);
+	if (SOAP_OK != ret)
+		return ret;
+	sent = true;
+
+	// The body is read into the soap context memory, freed when the lease ends
+	size_t size = 0;
+	const char* body = NULL;
+	if (soap_begin_recv(soap) || !(body = soap_http_get_body(soap, &size)) || soap_end_recv(soap))
+		return soap_closesock(soap);
+	soap_closesock(soap);
+
+	StatusParser::Result result = StatusParser::parse(body, size, reply);
+	if (StatusParser::Ok != result) {
+		logger()->debug("OnvifControl::{} GetStatus reply not parsed result = {} size = {}", __func__, StatusParser::to_str(result), size);
+		// The fault code is kept so auth_fault() sees it as with a deserialized fault
+		if (StatusParser::Fault == result)
+			return soap_set_sender_error(soap, soap_strdup(soap, reply.error_), NULL, SOAP_FAULT);
+		// The body is consumed, a second GetStatus through gSOAP would be
+		// another request. Repeated failures switch the camera over.
+		fast_path_rejected(SOAP_SYNTAX_ERROR);
+		return SOAP_SYNTAX_ERROR;
+	}
+	return SOAP_OK;
+}
+
+void OnvifControl::read_status(const tt__PTZStatus* status, PtzStatusReply& reply)
+{
+	reply.clear();
+	if (!status)
+		return;
+
+	if (status->Position && status->Position->PanTilt) {
+		reply.x_ = status->Position->PanTilt->x;
+		reply.y_ = status->Position->PanTilt->y;
+		reply.fields_ |= PtzStatusReply::PanTilt;
+	}
+	if (status->Position && status->Position->Zoom) {
+		reply.z_ = status->Position->Zoom->x;
+		reply.fields_ |= PtzStatusReply::Zoom;
+	}
+
+	if (status->MoveStatus && status->MoveStatus->PanTilt) {
+		reply.pan_tilt_status_ = (int) *status->MoveStatus->PanTilt;
+		reply.fields_ |= PtzStatusReply::PanTiltStatus;
+	}
+	if (status->MoveStatus && status->MoveStatus->Zoom) {
+		reply.zoom_status_ = (int) *status->MoveStatus->Zoom;
+		reply.fields_ |= PtzStatusReply::ZoomStatus;
+	}
+
+	if (status->Error)
+		reply.set_error(status->Error->data(), status->Error->size());
+}
+
 int OnvifControl::add_credential(struct soap *soap, const std::string& username, const std::string& password)
 {
 	int ret = SOAP_OK;
 
-	// NOTE: soap_wsse_add_UsernameTokenDigest always return SOAP_OK
-	if (!username.empty())
-		ret = soap_wsse_add_UsernameTokenDigest(soap, NULL, username.c_str(), password.c_str());
+	if (!username.empty()) {
+		// The token of the precompiled path, one digest per request and Created
+		// shifted by the device clock offset sync_clock() found
+		WsseCredential::Token token;
+		if (!credential_.token(username, password, token)) {
+			// NOTE: soap_wsse_add_UsernameTokenDigest always return SOAP_OK
+			return soap_wsse_add_UsernameTokenDigest(soap, NULL, username.c_str(), password.c_str());
+		}
+
+		ret = soap_wsse_add_UsernameTokenText(soap, NULL, username.c_str(), soap_strdup(soap, token.digest_));
+		_wsse__UsernameToken* username_token = soap_wsse_UsernameToken(soap, NULL);
+		if (SOAP_OK == ret && username_token && username_token->Password) {
+			wsse__EncodedString* nonce = (wsse__EncodedString*) soap_malloc(soap, sizeof(wsse__EncodedString));
+			if (!nonce)
+				return SOAP_EOM;
+			soap_default_wsse__EncodedString(soap, nonce);
+			nonce->__item = soap_strdup(soap, token.nonce_);
+			nonce->EncodingType = (char*) "http://docs.oasis-open.org/wss/2004/01/oasis-200401-wss-soap-message-security-1.0#Base64Binary";
+
+			username_token->Password->Type = (char*) "http://docs.oasis-open.org/wss/2004/01/oasis-200401-wss-username-token-profile-1.0#PasswordDigest";
+			username_token->Nonce = nonce;
+			username_token->wsu__Created = soap_strdup(soap, token.created_);
+		}
+	}
 
 	return ret;
 }
 
 int OnvifControl::get_ptz_nodes(const std::string& ptz, const std::string& username, const std::string& password, std::vector<std::string>& nodes)
 {
-	logger()->trace("OnvifControl::{} ptz = {} username = {} password = {} (entry)", __func__, ptz, username, password);
+	PTZ_TRACE("OnvifControl::{} ptz = {} (entry)", __func__, ptz);
 
 	int ret = SOAP_ERR;
 
-	PTZBindingProxy proxy(ptz.c_str());
+	ProxyPool<PTZBindingProxy>::Lease proxy(proxies_.ptz_);
 
 	_tptz__GetNodes tptz__GetNodes;
 	_tptz__GetNodesResponse response;
 
-	add_credential(proxy.soap, username, password);
-
 	size_t i;
-	ret = proxy.GetNodes(&tptz__GetNodes, &response);
+	ret = invoke(ControlMetrics::GetNodes, proxy, [&](PTZBindingProxy& p) {
+		add_credential(p.soap, username, password);
+		return p.GetNodes(ptz.c_str(), NULL, &tptz__GetNodes, &response);
+	});
 	if (SOAP_OK == ret) {
 		for (i = 0; i < response.PTZNode.size(); i++)
 			nodes.push_back(response.PTZNode[i]->token);
@@ -212,16 +740,16 @@ int OnvifControl::get_ptz_nodes(const std::string& ptz, const std::string& usern
 		logger()->error("OnvifControl::{} failed to retrieve nodes from ptz = {}!", __func__, ptz);
 	}
 
-	logger()->trace("OnvifControl::{} ret = {} nodes size = {} (exit)", __func__, ret, nodes.size());
+	PTZ_TRACE("OnvifControl::{} ret = {} nodes size = {} (exit)", __func__, ret, nodes.size());
 	return ret;
 }
 
 int OnvifControl::get_ptz_node(const std::string& ptz, const std::string& username, const std::string& password, const std::string& node, PTZDetails& details)
 {
-	logger()->trace("OnvifControl::{} ptz = {} username = {} password = {} node = {} (entry)", __func__, ptz, username, password, node);
+	PTZ_TRACE("OnvifControl::{} ptz = {} node = {} (entry)", __func__, ptz, node);
 	int ret = SOAP_ERR;
 
-	PTZBindingProxy proxy(ptz.c_str());
+	ProxyPool<PTZBindingProxy>::Lease proxy(proxies_.ptz_);
 
 	_tptz__GetNode tptz__GetNode;
 	_tptz__GetNodeResponse response;
@@ -230,10 +758,11 @@ int OnvifControl::get_ptz_node(const std::string& ptz, const std::string& userna
 	if (!node.empty())
 		tptz__GetNode.NodeToken = node;
 
-	add_credential(proxy.soap, username, password);
-
 	size_t i;
-	ret = proxy.GetNode(&tptz__GetNode, &response);
+	ret = invoke(ControlMetrics::GetNode, proxy, [&](PTZBindingProxy& p) {
+		add_credential(p.soap, username, password);
+		return p.GetNode(ptz.c_str(), NULL, &tptz__GetNode, &response);
+	});
 	if (ret == SOAP_OK) {
 		if (response.PTZNode) {
 
@@ -325,379 +854,207 @@ int OnvifControl::get_ptz_node(const std::string& ptz, const std::string& userna
 		}
 	}
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
-void OnvifControl::scale_values(const std::string& panval, const std::string& tiltval, const std::string& zoomval, float& x, float& y, float& z, float fx_min, float fx_max, float fy_min, float fy_max)
+void OnvifControl::scale_values(float pan, float tilt, float zoom, bool zoom_axis, float& x, float& y, float& z, float fx_min, float fx_max, float fy_min, float fy_max)
 {
-	float xrange = fx_max - fx_min;
-	float yrange = fy_max - fy_min;
-	float xmid = (fx_max + fx_min) / 2;
-	float ymid = (fy_max + fy_min) / 2;
-	if (!zoomval.empty()) {
+	if (zoom_axis) {
 		x = 0;
 		y = 0;
-		float zval = (float) atof(zoomval.c_str());
-		float zr = zval / 100;
-		z = xmid + (zr * xrange / 2);
+		z = AxisConversion::from_percent(zoom, fx_min, fx_max);
 	} else {
 		z = 0;
-		float xval = (float) atof(panval.c_str());
-		float yval = (float) atof(tiltval.c_str());
-
-		float xr = xval / 100;
-		x = xmid + (xr * xrange / 2);
-		float yr = yval / 100;
-		y = ymid + (yr * yrange / 2);
+		x = AxisConversion::from_percent(pan, fx_min, fx_max);
+		y = AxisConversion::from_percent(tilt, fy_min, fy_max);
 	}
 }
 
-void OnvifControl::scale_abs_camera_values(const std::string& panval, const std::string& tiltval, const std::string& zoomval, float& x, float& y, float& z, float fx_min, float fx_max, float fy_min, float fy_max)
+void OnvifControl::scale_abs_camera_values(float pan, float tilt, float zoom, bool zoom_axis, float& x, float& y, float& z, float fx_min, float fx_max, float fy_min, float fy_max)
 {
-	logger()->trace("OnvifControl::{} pan = {} tilt = {}  zoom = {} (entry)", __func__, panval, tiltval, zoomval);
+	PTZ_TRACE("OnvifControl::{} pan = {} tilt = {}  zoom = {} (entry)", __func__, pan, tilt, zoom);
 
-	if (!zoomval.empty()) {
-		z = convert_to_raw(zoomval, fx_min, fx_max, true);
+	if (zoom_axis) {
+		z = AxisConversion::to_raw(zoom, fx_min, fx_max, true);
 	} else {
-		x = convert_to_raw(panval, fx_min, fx_max, false);
-		y = convert_to_raw(tiltval, fy_min, fy_max, false);
+		x = AxisConversion::to_raw(pan, fx_min, fx_max, false);
+		y = AxisConversion::to_raw(tilt, fy_min, fy_max, false);
 	}
        
-	logger()->trace("OnvifControl::{} pan = {} tilt = {} zoom = {} (exit)", __func__, x, y, z);
-}
-// convert degree to value
-float OnvifControl::convert_to_raw(const std::string& degree, float min, float max, bool zoom)
-{
-	float fctr = 1.0;     /* factor */
-	float v = (float)atof(degree.c_str());
-	float r = v/fctr;
-
-           
-	if (zoom) {
-		if (min > max) {
-			float pv = (float)(r / 100.00);
-			r = min - (pv * (min - max));
-		} else {
-			if (v != 0) {
-				float pv = (float)(r / 100.00);
-				r = min + (pv * (max - min));
-			}
-		}
-	} else	{
-		//-180 should equal camera min
-		//+180 should equal camera max
-		//changed 2012-03025  used to be
-		//int mid = (iMax - iMin) / 2;
-		float mid = 0;
-		float frange;
-
-		if (max < 0) {
-			if (min < 0) {
-				frange = min + max;
-				mid = min + frange/2;
-			} else {
-				frange = min - max;
-				//mid = (min - max) / (float)2.0;
-				mid = min - frange/2;
-			}
-		} else {
-			if (min > 0) {
-				frange = max + min;
-				mid = min - frange/2;
-			} else {
-				frange = max - min;
-				//mid = (max + min) / (float)2.0;
-				mid = min + frange/2;
-			}
-		}
-
-//		if (v > 0) {
-//			float pv = (float)(r / 180.00);
-//			if (mid != 0)
-//				r = mid - (pv * frange/2.0);
-//			else
-//				r = mid + (pv * (max - mid));
-//		} else {
-//			float pv = (float)(r / -180.00);
-//			if (mid != 0)
-//				r = mid + (pv * frange/2.0);
-//			else
-//				r = mid - (pv * (mid - min));
-//		}
-
-		float pv = (float)(r / 180.0);
-		if (v > 0)
-			r = mid + (pv * frange/2.0);
-		else
-			r = mid + (pv * frange/2.0);
-	}
-
-	float f = r;
-//	float f = (float)floor(r + 0.5);
-
-	if (min > max) {
-		if (f < max)
-			f = max;
-		if (f > min)
-			f = min;
-	} else {
-		if (f < min)
-			f = min;
-		if (f > max)
-			f = max;
-	}
-
-	return f;
+	PTZ_TRACE("OnvifControl::{} pan = {} tilt = {} zoom = {} (exit)", __func__, x, y, z);
 }
 
-void OnvifControl::scale_abs_nvr_values(std::string& panval, std::string& tiltval, std::string& zoomval, float& x, float& y, float& z, float fx_min, float fx_max, float fy_min, float fy_max, bool zoom)
+void OnvifControl::scale_abs_nvr_values(float& pan, float& tilt, float& zoom, float x, float y, float z, float fx_min, float fx_max, float fy_min, float fy_max, bool zoom_axis)
 {
-	if (zoom) {
-		zoomval = convert_to_degree(z, fx_min, fx_max, zoom);
-	} else {
-		panval = convert_to_degree(x, fx_min, fx_max, zoom); 
-		tiltval = convert_to_degree(y, fy_min, fy_max, zoom); 
-	}
-}
-
-// convert camera value to degree
-std::string OnvifControl::convert_to_degree(float value, float min, float max, bool zoom)
-{
-	float factor = 1.0;
-	float r = value * factor;
-
-	if (zoom) {
-		if ((max-min) != 0) {
-			float pv = (r-min) / (max - min);
-			pv *= 100;
-			float iv = (float)floor(pv + 0.5);
-			r = (float)iv;
-			if (r > 100)
-				r = 100.0;
-			if (r < 0)
-				r = 0.0;
-		}
+	if (zoom_axis) {
+		zoom = AxisConversion::to_degree(z, fx_min, fx_max, true);
 	} else {
-
-		float mid = 0;
-		float frange;
-
-		if (max < 0) {
-			if (min < 0) {
-				frange = min + max;
-				mid = min + frange/2;
-			} else {
-				frange = min - max;
-				//mid = (min - max) / (float)2.0;
-				mid = min - frange/2;
-			}
-		} else {
-			if (min > 0) {
-				frange = max + min;
-				mid = min - frange/2;
-			} else {
-				frange = max - min;
-				//mid = (max + min) / (float)2.0;
-				mid = min + frange/2;
-			}
-		}
-
-		if (frange != 0) {
-			float pv = (r-min) / (frange);
-			r = pv;
-			r *= 360;
-			float test = value * factor;
-			if (test < mid) {
-				r = (float)180.0 - r;
-				r = -r;
-			} else {
-				r -= (float)180.0;
-			}
-		}
+		pan = AxisConversion::to_degree(x, fx_min, fx_max, false); 
+		tilt = AxisConversion::to_degree(y, fy_min, fy_max, false); 
 	}
-
-	return std::to_string(r);
 }
 
-void OnvifControl::come_up_with_nvr_values(const char *axis, const PTZDetails& details, std::string& panval, std::string& tiltval, std::string& zoomval, float x, float y, float z, bool zoom)
+void OnvifControl::come_up_with_nvr_values(AxisSpace space, const PTZDetails& details, float& pan, float& tilt, float& zoom, float x, float y, float z, bool zoom_axis)
 {
-	size_t i;
-	for (i = 0; i < details.ptz_axis_.size(); i++) {
-		if (!common::Utilities::case_insensitive_compare(details.ptz_axis_[i].name_.c_str(), axis)) {
-			float fx_min = 0, fx_max = 0, fy_min = 0, fy_max = 0;
-			fx_min = details.ptz_axis_[i].fx_min_;
-			fx_max = details.ptz_axis_[i].fx_max_;
-			fy_min = details.ptz_axis_[i].fy_min_;
-			fy_max = details.ptz_axis_[i].fy_max_;
-			scale_abs_nvr_values(panval, tiltval, zoomval, x, y, z, fx_min, fx_max, fy_min, fy_max, zoom);
-			break;
-		}
-	}        
+	const AxisScale& scale = details.axis_table_[space];
+	if (scale.valid_)
+		scale_abs_nvr_values(pan, tilt, zoom, x, y, z, scale.fx_min_, scale.fx_max_, scale.fy_min_, scale.fy_max_, zoom_axis);
 }
 
-void OnvifControl::come_up_with_camera_values(const char *axis, const PTZDetails& details, const std::string& panval, const std::string& tiltval, std::string& zoomval, float& x, float& y, float& z)
+void OnvifControl::come_up_with_camera_values(AxisSpace space, const PTZDetails& details, float pan, float tilt, float zoom, float& x, float& y, float& z)
 {
-	size_t i;
-	for (i = 0; i < details.ptz_axis_.size(); i++) {
-		if (!common::Utilities::case_insensitive_compare(details.ptz_axis_[i].name_.c_str(), axis)) {
-			float fx_min = 0, fx_max = 0, fy_min = 0, fy_max = 0;
-			fx_min = details.ptz_axis_[i].fx_min_;
-			fx_max = details.ptz_axis_[i].fx_max_;
-			fy_min = details.ptz_axis_[i].fy_min_;
-			fy_max = details.ptz_axis_[i].fy_max_;
-			scale_values(panval, tiltval, zoomval, x, y, z, fx_min, fx_max, fy_min, fy_max);
-			break;
-		}
-	}
+	const AxisScale& scale = details.axis_table_[space];
+	if (scale.valid_)
+		scale_values(pan, tilt, zoom, zoom_space(space), x, y, z, scale.fx_min_, scale.fx_max_, scale.fy_min_, scale.fy_max_);
 }
 
-bool  OnvifControl::come_up_with_camera_abs_values(const char *axis, const PTZDetails& details, const std::string& panval, const std::string& tiltval, const std::string& zoomval, float& x, float& y, float& z)
+bool  OnvifControl::come_up_with_camera_abs_values(AxisSpace space, const PTZDetails& details, float pan, float tilt, float zoom, float& x, float& y, float& z)
 {
-	logger()->trace("OnvifControl::{} pan = {} tilt = {}  zoom = {} (entry)", __func__, x, y, z);
+	PTZ_TRACE("OnvifControl::{} pan = {} tilt = {}  zoom = {} (entry)", __func__, pan, tilt, zoom);
 	bool ret = true;
 
-	size_t i;
-	for (i = 0; i < details.ptz_axis_.size(); i++) {
-		if (!common::Utilities::case_insensitive_compare(details.ptz_axis_[i].name_.c_str(), axis)) {
-			float fx_min = 0, fx_max = 0, fy_min = 0, fy_max = 0;
-			fx_min = details.ptz_axis_[i].fx_min_;
-			fx_max = details.ptz_axis_[i].fx_max_;
-			fy_min = details.ptz_axis_[i].fy_min_;
-			fy_max = details.ptz_axis_[i].fy_max_;
-			logger()->trace("OnvifControl::{} {} axis details x_min = {} x_max = {}  y_min = {} y_max = {}", __func__, axis, fx_min, fx_max, fy_min, fy_max);
-			scale_abs_camera_values(panval, tiltval, zoomval, x, y, z, fx_min, fx_max, fy_min, fy_max);
-			break;
-		}
+	const AxisScale& scale = details.axis_table_[space];
+	if (scale.valid_) {
+		PTZ_TRACE("OnvifControl::{} {} axis details x_min = {} x_max = {}  y_min = {} y_max = {}", __func__, (int) space, scale.fx_min_, scale.fx_max_, scale.fy_min_, scale.fy_max_);
+		scale_abs_camera_values(pan, tilt, zoom, zoom_space(space), x, y, z, scale.fx_min_, scale.fx_max_, scale.fy_min_, scale.fy_max_);
 	}
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
-bool OnvifControl::axis_detail(const std::string& name, const PTZDetails& ptz_details, AxisDetails& axis_details)
+bool OnvifControl::zoom_space(AxisSpace space)
 {
-	logger()->trace("OnvifControl::{} name = {} ptz detail size = {}", __func__, name, ptz_details.ptz_axis_.size());
-	bool ret = false;
+	return (AxisSpace::AbsZ == space || AxisSpace::RelZ == space || AxisSpace::ContZ == space);
+}
 
-	size_t i;
-	for (i = 0; i < ptz_details.ptz_axis_.size(); i++) {
-		if (!common::Utilities::case_insensitive_compare(ptz_details.ptz_axis_[i].name_.c_str(), name.c_str())) {
-			axis_details = ptz_details.ptz_axis_[i];
-			logger()->trace("OnvifControl::{} axis = {} x_min = {} x_max = {}  y_min = {} y_max = {} found",
-				__func__, name, axis_details.fx_min_, axis_details.fx_max_, axis_details.fy_min_, axis_details.fy_max_);
-			ret = true;
-			break;
+void OnvifControl::build_axis_table(PTZDetails& details)
+{
+	static const char* names[AxisSpaceCount] = { "AbsPT", "RelPT", "AbsZ", "RelZ", "ContPT", "ContZ" };
+
+	for (int space = 0; space < AxisSpaceCount; space++) {
+		AxisScale& scale = details.axis_table_[space];
+		scale = AxisScale();
+
+		// First matching space wins, as the former linear lookup did
+		for (size_t i = 0; i < details.ptz_axis_.size(); i++) {
+			const AxisDetails& axis = details.ptz_axis_[i];
+			if (!common::Utilities::case_insensitive_compare(axis.name_.c_str(), names[space])) {
+				scale.valid_ = true;
+				scale.fx_min_ = axis.fx_min_;
+				scale.fx_max_ = axis.fx_max_;
+				scale.fy_min_ = axis.fy_min_;
+				scale.fy_max_ = axis.fy_max_;
+				scale.x_range_ = AxisConversion::range(axis.fx_min_, axis.fx_max_);
+				scale.y_range_ = AxisConversion::range(axis.fy_min_, axis.fy_max_);
+				break;
+			}
 		}
-	}    
-
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
-	return ret;
+	}
 }
 
-bool OnvifControl::scale_cam_rel_values(Axis axis, const PTZDetails& ptz_details, float degrees, float& value, AxisDetails& axis_details)
+bool OnvifControl::scale_cam_rel_values(Axis axis, const PTZDetails& ptz_details, float degrees, float& value)
 {
-	logger()->trace("OnvifControl::{} degrees = {} (entry)", __func__, degrees);
-	
+	PTZ_TRACE("OnvifControl::{} degrees = {} (entry)", __func__, degrees);
+
 	//todo : check correct space used for scaling
-	switch(axis) {
-		case Axis::Zoom:
-		{
-			if (axis_detail("AbsZ", ptz_details, axis_details) || (axis_detail("RelZ", ptz_details, axis_details)))
-				value = calculate_range(axis_details.fx_min_, axis_details.fx_max_) * (degrees/100.0);
-			break;
-		}
-		case Axis::Pan:
-		{
-			if (axis_detail("AbsPT", ptz_details, axis_details) || (axis_detail("RelPT", ptz_details, axis_details)))
-				value = calculate_range(axis_details.fx_min_, axis_details.fx_max_) * (degrees/360.0);
-			break;
-		}
-		case Axis::Tilt:
-		{
-			if (axis_detail("AbsPT", ptz_details, axis_details) || (axis_detail("RelPT", ptz_details, axis_details)))
-				value = calculate_range(axis_details.fy_min_, axis_details.fy_max_) * (degrees/360.0);
-			break;
+	bool zoom = (Axis::Zoom == axis);
+	const AxisScale& abs = ptz_details.axis_table_[zoom ? AxisSpace::AbsZ : AxisSpace::AbsPT];
+	const AxisScale& scale = abs.valid_ ? abs : ptz_details.axis_table_[zoom ? AxisSpace::RelZ : AxisSpace::RelPT];
+
+	if (scale.valid_) {
+		switch(axis) {
+			case Axis::Zoom:
+				value = AxisConversion::relative(degrees, scale.x_range_, true);
+				break;
+			case Axis::Pan:
+				value = AxisConversion::relative(degrees, scale.x_range_, false);
+				break;
+			case Axis::Tilt:
+				value = AxisConversion::relative(degrees, scale.y_range_, false);
+				break;
+			default:
+				break;
 		}
-		default:
-			break;
 	}
             
-	logger()->trace("OnvifControl::{} value = {} (exit)", __func__, value);
+	PTZ_TRACE("OnvifControl::{} value = {} (exit)", __func__, value);
 	return (value != 0.0);
 }
 
-float OnvifControl::calculate_range(float min, float max)
+float OnvifControl::move_fraction(Axis axis, float delta)
 {
-	logger()->trace("OnvifControl::{} min = {} max = {} (entry)", __func__, min, max);
-	float range = 0.0;
+	float ret = 0.0;
 
-	if (max < 0) {
-		if (min < 0)
-			range = min + max;
-		else
-			range = min - max;
-	} else {
-		if (min > 0)
-			range = max + min;
-		else
-			range = max - min;
-	}
+	const AxisScale& scale = ptz_details_.axis_table_[(Axis::Zoom == axis) ? AxisSpace::AbsZ : AxisSpace::AbsPT];
+	if (scale.valid_)
+		ret = delta / ((Axis::Tilt == axis) ? scale.y_range_ : scale.x_range_);
 
-	logger()->trace("OnvifControl::{} range = {} (exit)", __func__, range);
-	return range;
+	return std::isfinite(ret) ? fabsf(ret) : 0.0;
 }
 
 int OnvifControl::send_get_status(const std::string& ptz, const std::string& token, const std::string& username, const std::string& password, float& x, float& y, float& z, int& status)
 {
-	logger()->trace("OnvifControl::{} ptz = {} token = {}  username = {} password = {} (entry)", __func__, ptz, token, username, password);
+	PTZ_TRACE("OnvifControl::{} ptz = {} token = {} (entry)", __func__, ptz, token);
 	int ret = SOAP_ERR;
 
-	PTZBindingProxy proxy(ptz.c_str());
+	ProxyPool<PTZBindingProxy>::Lease proxy(proxies_.ptz_);
 
 	_tptz__GetStatus tptz__GetStatus;
 	_tptz__GetStatusResponse response;
+	PtzStatusReply reply;
 
 	tptz__GetStatus.ProfileToken = token;
 
-	add_credential(proxy.soap, username, password);
-
-	ret = proxy.GetStatus(&tptz__GetStatus, &response);
-	if (SOAP_OK == ret) {
-		
-		x = response.PTZStatus->Position->PanTilt->x;
-		y = response.PTZStatus->Position->PanTilt->y;
-		z = response.PTZStatus->Position->Zoom->x;
-
-		// IDLE = 0, MOVING = 1, UNKNOWN = 2 
-		if (response.PTZStatus->MoveStatus) {
-			if ((response.PTZStatus->MoveStatus->PanTilt && (Status::Moving == (Status)*response.PTZStatus->MoveStatus->PanTilt)) ||
-				(response.PTZStatus->MoveStatus->Zoom && (Status::Moving == (Status)*response.PTZStatus->MoveStatus->Zoom)))
-				status = Status::Moving;
-			else if ((response.PTZStatus->MoveStatus->PanTilt && (Status::Unknown == (Status)*response.PTZStatus->MoveStatus->PanTilt)) ||
-				(response.PTZStatus->MoveStatus->Zoom && (Status::Unknown == (Status)*response.PTZStatus->MoveStatus->Zoom)))
-				status = Status::Unknown;
-			else
-				status = Status::Idle;
+	ret = invoke(ControlMetrics::GetStatus, proxy, [&](PTZBindingProxy& p) {
+		if (fast_path(token)) {
+			bool sent = false;
+			int fast = send_status_template(p, ptz, username, password, reply, sent);
+			if (!fast_path_failed(ControlMetrics::GetStatus, fast, sent))
+				return fast;
 		}
-
-		logger()->trace("OnvifControl::{} success pan = {} tilt = {} zoom = {} status = {} error = ",
-			__func__, x, y, z, to_str((Status) status), (response.PTZStatus->Error ? *response.PTZStatus->Error : "None"));
+		add_credential(p.soap, username, password);
+		int status_ret = p.GetStatus(ptz.c_str(), NULL, &tptz__GetStatus, &response);
+		if (SOAP_OK == status_ret)
+			read_status(response.PTZStatus, reply);
+		return status_ret;
+	});
+	if (SOAP_OK == ret && !reply.has_position()) {
+		logger()->error("OnvifControl::{} reply has no Position", __func__);
+		ret = SOAP_NO_TAG;
+	} else if (SOAP_OK == ret) {
+		// An axis the device left out keeps its last known value
+		if (!reply.has(PtzStatusReply::PanTilt))
+			PTZ_TRACE("OnvifControl::{} reply has no PanTilt position", __func__);
+		if (!reply.has(PtzStatusReply::Zoom))
+			PTZ_TRACE("OnvifControl::{} reply has no Zoom position", __func__);
+
+		x = reply.has(PtzStatusReply::PanTilt) ? reply.x_ : pan_raw_;
+		y = reply.has(PtzStatusReply::PanTilt) ? reply.y_ : tilt_raw_;
+		z = reply.has(PtzStatusReply::Zoom) ? reply.z_ : zoom_raw_;
+
+		// IDLE = 0, MOVING = 1, UNKNOWN = 2
+		if (reply.has_move_status())
+			status = reply.status();
+
+		PTZ_TRACE("OnvifControl::{} success pan = {} tilt = {} zoom = {} status = {} error = {}",
+			__func__, x, y, z, to_str((Status) status), (reply.has(PtzStatusReply::Error) ? reply.error_ : "None"));
 	} else {
 		std::string error = (response.soap && response.soap->fault && response.soap->fault->faultstring) ? response.soap->fault->faultstring : "unknown";
 		logger()->error("OnvifControl::{} failed error = {}", __func__, error);
 	}
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
 int OnvifControl::send_stop(const std::string& ptz, const std::string& token, const std::string& username, const std::string& password, bool zoom)
 {
-	logger()->trace("OnvifControl::{} ptz = {} token = {}  username = {} password = {} (entry)", __func__, ptz, token, username, password);
+	PTZ_TRACE("OnvifControl::{} ptz = {} token = {} (entry)", __func__, ptz, token);
 	int ret = SOAP_ERR;
 
-	PTZBindingProxy proxy(ptz.c_str());
+	ProxyPool<PTZBindingProxy>::Lease proxy(proxies_.ptz_);
 
 	_tptz__Stop tptz__Stop;
 	_tptz__StopResponse response;
@@ -714,25 +1071,32 @@ int OnvifControl::send_stop(const std::string& ptz, const std::string& token, co
 		tptz__Stop.PanTilt = &bt;
 	}
 
-	add_credential(proxy.soap, username, password);
-
-	ret = proxy.Stop(&tptz__Stop, &response);
+	ret = invoke(ControlMetrics::Stop, proxy, [&](PTZBindingProxy& p) {
+		if (fast_path(token)) {
+			bool sent = false;
+			int fast = send_template(p, ptz, zoom ? PtzTemplates::StopZoom : PtzTemplates::StopPanTilt, NULL, 0, username, password, response, sent);
+			if (!fast_path_failed(ControlMetrics::Stop, fast, sent))
+				return fast;
+		}
+		add_credential(p.soap, username, password);
+		return p.Stop(ptz.c_str(), NULL, &tptz__Stop, &response);
+	});
 
 	if (SOAP_OK == ret)
-		logger()->trace("OnvifControl::{} success zoom = {}", __func__, zoom ? "true" : "false");
+		PTZ_TRACE("OnvifControl::{} success zoom = {}", __func__, zoom ? "true" : "false");
 	else
 		logger()->error("OnvifControl::{} failed zoom = {}", __func__, zoom ? "true" : "false");
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__);
 	return ret;
 }
 
 int OnvifControl::send_abs_move_pt(const std::string& ptz, const std::string& token, const std::string& username, const std::string& password, float x, float y, float z)
 {
-	logger()->trace("OnvifControl::{} ptz = {} token = {}  username = {} password = {} pan = {} tilt = {} (entry)", __func__, ptz, token, username, password, x, y);
+	PTZ_TRACE("OnvifControl::{} ptz = {} token = {} pan = {} tilt = {} (entry)", __func__, ptz, token, x, y);
 	int ret = SOAP_ERR;
 
-	PTZBindingProxy proxy(ptz.c_str());
+	ProxyPool<PTZBindingProxy>::Lease proxy(proxies_.ptz_);
 
 	_tptz__AbsoluteMove tptz__AbsoluteMove;
 	_tptz__AbsoluteMoveResponse response;
@@ -745,24 +1109,32 @@ int OnvifControl::send_abs_move_pt(const std::string& ptz, const std::string& to
 	tptz__AbsoluteMove.Position = &v;
 	tptz__AbsoluteMove.ProfileToken = token;
 
-	add_credential(proxy.soap, username, password);
-
-	ret = proxy.AbsoluteMove(&tptz__AbsoluteMove, &response);
+	ret = invoke(ControlMetrics::AbsoluteMove, proxy, [&](PTZBindingProxy& p) {
+		if (fast_path(token)) {
+			float values[] = { vpt.x, vpt.y };
+			bool sent = false;
+			int fast = send_template(p, ptz, PtzTemplates::AbsoluteMovePanTilt, values, 2, username, password, response, sent);
+			if (!fast_path_failed(ControlMetrics::AbsoluteMove, fast, sent))
+				return fast;
+		}
+		add_credential(p.soap, username, password);
+		return p.AbsoluteMove(ptz.c_str(), NULL, &tptz__AbsoluteMove, &response);
+	});
 	if (SOAP_OK == ret)
-		logger()->trace("OnvifControl::{} success pan = {} tilt = {}", __func__, x, y);
+		PTZ_TRACE("OnvifControl::{} success pan = {} tilt = {}", __func__, x, y);
 	else
 		logger()->error("OnvifControl::{} failed pan = {} tilt = {} error = {}", __func__, x, y, (response.soap && response.soap->fault && response.soap->fault->faultstring) ? response.soap->fault->faultstring : "unknown");
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
 int OnvifControl::send_abs_move_z(const std::string& ptz, const std::string& token, const std::string& username, const std::string& password, float x, float y, float z)
 {
-	logger()->trace("OnvifControl::{} ptz = {} token = {}  username = {} password = {} (entry)", __func__, ptz, token, username, password);
+	PTZ_TRACE("OnvifControl::{} ptz = {} token = {} (entry)", __func__, ptz, token);
 	int ret = SOAP_ERR;
 
-	PTZBindingProxy proxy(ptz.c_str());
+	ProxyPool<PTZBindingProxy>::Lease proxy(proxies_.ptz_);
 
 	_tptz__AbsoluteMove tptz__AbsoluteMove;
 	_tptz__AbsoluteMoveResponse response;
@@ -774,24 +1146,73 @@ int OnvifControl::send_abs_move_z(const std::string& ptz, const std::string& tok
 	tptz__AbsoluteMove.Position = &v;
 	tptz__AbsoluteMove.ProfileToken = token;
 
-	add_credential(proxy.soap, username, password);
-
-	ret = proxy.AbsoluteMove(&tptz__AbsoluteMove, &response);
+	ret = invoke(ControlMetrics::AbsoluteMove, proxy, [&](PTZBindingProxy& p) {
+		if (fast_path(token)) {
+			float values[] = { vz.x };
+			bool sent = false;
+			int fast = send_template(p, ptz, PtzTemplates::AbsoluteMoveZoom, values, 1, username, password, response, sent);
+			if (!fast_path_failed(ControlMetrics::AbsoluteMove, fast, sent))
+				return fast;
+		}
+		add_credential(p.soap, username, password);
+		return p.AbsoluteMove(ptz.c_str(), NULL, &tptz__AbsoluteMove, &response);
+	});
 	if (SOAP_OK == ret)
-		logger()->trace("OnvifControl::{} success zval = {}", __func__, z);
+		PTZ_TRACE("OnvifControl::{} success zval = {}", __func__, z);
 	else
 		logger()->error("OnvifControl::{} failed zval = {} result = {}", __func__, z, ret);
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
-int OnvifControl::send_cont_move_pt(const std::string& ptz, const std::string& token, const std::string& username, const std::string& password, float x, float y, float z)
+int OnvifControl::send_abs_move_ptz(const std::string& ptz, const std::string& token, const std::string& username, const std::string& password, float x, float y, float z)
 {
-	logger()->trace("OnvifControl::{} ptz = {} token = {}  username = {} password = {} (entry)", __func__, ptz, token, username, password);
+	PTZ_TRACE("OnvifControl::{} ptz = {} token = {} pan = {} tilt = {} zoom = {} (entry)", __func__, ptz, token, x, y, z);
 	int ret = SOAP_ERR;
 
-	PTZBindingProxy proxy(ptz.c_str());
+	ProxyPool<PTZBindingProxy>::Lease proxy(proxies_.ptz_);
+
+	_tptz__AbsoluteMove tptz__AbsoluteMove;
+	_tptz__AbsoluteMoveResponse response;
+
+	tt__PTZVector v;
+	tt__Vector2D vpt;
+	tt__Vector1D vz;
+	vpt.x = x;
+	vpt.y = y;
+	vz.x = z;
+	v.PanTilt = &vpt;
+	v.Zoom = &vz;
+	tptz__AbsoluteMove.Position = &v;
+	tptz__AbsoluteMove.ProfileToken = token;
+
+	ret = invoke(ControlMetrics::AbsoluteMove, proxy, [&](PTZBindingProxy& p) {
+		if (fast_path(token)) {
+			float values[] = { vpt.x, vpt.y, vz.x };
+			bool sent = false;
+			int fast = send_template(p, ptz, PtzTemplates::AbsoluteMovePanTiltZoom, values, 3, username, password, response, sent);
+			if (!fast_path_failed(ControlMetrics::AbsoluteMove, fast, sent))
+				return fast;
+		}
+		add_credential(p.soap, username, password);
+		return p.AbsoluteMove(ptz.c_str(), NULL, &tptz__AbsoluteMove, &response);
+	});
+	if (SOAP_OK == ret)
+		PTZ_TRACE("OnvifControl::{} success pan = {} tilt = {} zoom = {}", __func__, x, y, z);
+	else
+		logger()->error("OnvifControl::{} failed pan = {} tilt = {} zoom = {} error = {}", __func__, x, y, z, (response.soap && response.soap->fault && response.soap->fault->faultstring) ? response.soap->fault->faultstring : "unknown");
+
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	return ret;
+}
+
+int OnvifControl::send_cont_move_pt(const std::string& ptz, const std::string& token, const std::string& username, const std::string& password, float x, float y, float z, uint32_t timeout_ms)
+{
+	PTZ_TRACE("OnvifControl::{} ptz = {} token = {} timeout = {} ms (entry)", __func__, ptz, token, timeout_ms);
+	int ret = SOAP_ERR;
+
+	ProxyPool<PTZBindingProxy>::Lease proxy(proxies_.ptz_);
 
 	_tptz__ContinuousMove tptz__ContinuousMove;
 	_tptz__ContinuousMoveResponse response;
@@ -819,24 +1240,37 @@ int OnvifControl::send_cont_move_pt(const std::string& ptz, const std::string& t
 	tptz__ContinuousMove.Velocity = &v;
 	tptz__ContinuousMove.ProfileToken = token;
 
-	add_credential(proxy.soap, username, password);
-
-	ret = proxy.ContinuousMove(&tptz__ContinuousMove, &response);
+	LONG64 timeout = timeout_ms;
+	if (timeout_ms)
+		tptz__ContinuousMove.Timeout = &timeout;
+
+	ret = invoke(ControlMetrics::ContinuousMove, proxy, [&](PTZBindingProxy& p) {
+		if (fast_path(token)) {
+			float values[] = { vpt.x, vpt.y, timeout_ms / 1000.0f };
+			bool sent = false;
+			int fast = send_template(p, ptz, timeout_ms ? PtzTemplates::ContinuousMovePanTiltTimeout : PtzTemplates::ContinuousMovePanTilt,
+				values, timeout_ms ? 3 : 2, username, password, response, sent);
+			if (!fast_path_failed(ControlMetrics::ContinuousMove, fast, sent))
+				return fast;
+		}
+		add_credential(p.soap, username, password);
+		return p.ContinuousMove(ptz.c_str(), NULL, &tptz__ContinuousMove, &response);
+	});
 	if (SOAP_OK == ret)
-		logger()->trace("OnvifControl::{} success  xval = {} yval = {}", __func__, x, y);
+		PTZ_TRACE("OnvifControl::{} success  xval = {} yval = {}", __func__, x, y);
 	else
 		logger()->error("OnvifControl::{} failed  xval = {} yval = {}", __func__, x, y);
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
-int OnvifControl::send_cont_move_z(const std::string& ptz, const std::string& token, const std::string& username, const std::string& password, float x, float y, float z)
+int OnvifControl::send_cont_move_z(const std::string& ptz, const std::string& token, const std::string& username, const std::string& password, float x, float y, float z, uint32_t timeout_ms)
 {
-	logger()->trace("OnvifControl::{} ptz = {} token = {}  username = {} password = {} (entry)", __func__, ptz, token, username, password);
+	PTZ_TRACE("OnvifControl::{} ptz = {} token = {} timeout = {} ms (entry)", __func__, ptz, token, timeout_ms);
 	int ret = SOAP_ERR;
 
-	PTZBindingProxy proxy(ptz.c_str());
+	ProxyPool<PTZBindingProxy>::Lease proxy(proxies_.ptz_);
 
 	_tptz__ContinuousMove tptz__ContinuousMove;
 	_tptz__ContinuousMoveResponse response;
@@ -848,70 +1282,87 @@ int OnvifControl::send_cont_move_z(const std::string& ptz, const std::string& to
 	tptz__ContinuousMove.Velocity = &v;
 	tptz__ContinuousMove.ProfileToken = token;
 
-	add_credential(proxy.soap, username, password);
-
-	ret = proxy.ContinuousMove(&tptz__ContinuousMove, &response);
+	LONG64 timeout = timeout_ms;
+	if (timeout_ms)
+		tptz__ContinuousMove.Timeout = &timeout;
+
+	ret = invoke(ControlMetrics::ContinuousMove, proxy, [&](PTZBindingProxy& p) {
+		if (fast_path(token)) {
+			float values[] = { vz.x, timeout_ms / 1000.0f };
+			bool sent = false;
+			int fast = send_template(p, ptz, timeout_ms ? PtzTemplates::ContinuousMoveZoomTimeout : PtzTemplates::ContinuousMoveZoom,
+				values, timeout_ms ? 2 : 1, username, password, response, sent);
+			if (!fast_path_failed(ControlMetrics::ContinuousMove, fast, sent))
+				return fast;
+		}
+		add_credential(p.soap, username, password);
+		return p.ContinuousMove(ptz.c_str(), NULL, &tptz__ContinuousMove, &response);
+	});
 	if (SOAP_OK == ret)
-		logger()->trace("OnvifControl::{} success  zval = {}", __func__, z);
+		PTZ_TRACE("OnvifControl::{} success  zval = {}", __func__, z);
 	else
 		logger()->error("OnvifControl::{} failed  zval = {}", __func__, z);
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__);
 	return ret;
 }
 
 void OnvifControl::get_position(data_ptr_t& data)
 {
-	logger()->trace("OnvifControl::{} (entry)", __func__);
+	PTZ_TRACE("OnvifControl::{} (entry)", __func__);
 
-	// Update PTZ position when needed
-	if (update_position()) {
+	PtzPosition pos = position_.load();
+
+	// Refresh in the background, at most one request in flight
+	if (pos.stale_ && (InitState::Connected == init_state()) && !position_refresh_.exchange(true)) {
 		data_ptr_t pos_data = std::make_shared<Data>(*data);
 		pos_data->type = (uint8_t) PtzControl::Type::GetPanTiltZoomPos;
-		control(pos_data);
+		control_async(pos_data, [this](const data_ptr_t&, const ControlResult&) {
+			position_refresh_ = false;
+		});
 	}
 
-	logger()->trace("OnvifControl::{} RAW camera values pan = {} tilt = {} zoom = {}", __func__, pan_raw_, tilt_raw_, zoom_raw_);
-	logger()->trace("OnvifControl::{} NVR values pan = {} tilt = {} zoom = {}", __func__, pan_degrees_, tilt_degrees_, zoom_degrees_);
+	PTZ_TRACE("OnvifControl::{} RAW camera values pan = {} tilt = {} zoom = {}", __func__, pos.pan_raw_, pos.tilt_raw_, pos.zoom_raw_);
+	PTZ_TRACE("OnvifControl::{} NVR values pan = {} tilt = {} zoom = {} age = {} ms", __func__, pos.pan_, pos.tilt_, pos.zoom_, pos.age_ms());
 
-	data->pan = (int16_t) pan_degrees_;
-	data->tilt = (int16_t) tilt_degrees_;
-	data->zoom = (int16_t) zoom_degrees_;
+	data->pan = (int16_t) pos.pan_;
+	data->tilt = (int16_t) pos.tilt_;
+	data->zoom = (int16_t) pos.zoom_;
 	
-	logger()->trace("OnvifControl::{} (exit)", __func__);
+	PTZ_TRACE("OnvifControl::{} (exit)", __func__);
 }
 
-void OnvifControl::insert_port(const uint32_t& port)
+void OnvifControl::insert_port(const uint32_t& port, OnvifDeviceConfig& config)
 {
-	logger()->trace("OnvifControl::{} port = {} (entry)", __func__, port);
+	PTZ_TRACE("OnvifControl::{} port = {} (entry)", __func__, port);
 
 	if (port > 0) {
 		std::string insert = std::string(":") + std::to_string(port);
-		std::size_t pos_media = media_url_.find("/onvif");
+		std::size_t pos_media = config.media_url_.find("/onvif");
 
 		if (std::string::npos != pos_media)
-			media_url_.insert(pos_media, insert);
+			config.media_url_.insert(pos_media, insert);
 
-		std::size_t pos_ptz = ptz_url_.find("/onvif");
+		std::size_t pos_ptz = config.ptz_url_.find("/onvif");
 		if (std::string::npos != pos_ptz)
-			ptz_url_.insert(pos_ptz, insert);
+			config.ptz_url_.insert(pos_ptz, insert);
 
-		std::size_t pos_imaging = imaging_url_.find("/onvif");
+		std::size_t pos_imaging = config.imaging_url_.find("/onvif");
 		if (std::string::npos != pos_imaging)
-			imaging_url_.insert(pos_imaging, insert);
+			config.imaging_url_.insert(pos_imaging, insert);
 
-		logger()->trace("OnvifControl::{} updated media url = {} ptz url = {} imaging url = {} (entry)", __func__, media_url_, ptz_url_, imaging_url_);
+		PTZ_TRACE("OnvifControl::{} updated media url = {} ptz url = {} imaging url = {} (entry)", __func__, config.media_url_, config.ptz_url_, config.imaging_url_);
 	}
 
-	logger()->trace("OnvifControl::{} (exit)", __func__);
+	PTZ_TRACE("OnvifControl::{} (exit)", __func__);
 }
 
 int OnvifControl::send_relative_move_ptz(const std::string& ptz, const std::string& token, const std::string& username, const std::string& password, float x, float y, float z)
 {
-	logger()->trace("OnvifControl::{} ptz = {} token = {}  username = {} password = {} pan = {} tilt = {} zoom = {} (entry)", __func__, ptz, token, username, password, x, y, z);
+	PTZ_TRACE("OnvifControl::{} ptz = {} token = {} pan = {} tilt = {} zoom = {} (entry)", __func__, ptz, token, x, y, z);
 	int ret = SOAP_ERR;
 
-	PTZBindingProxy proxy(ptz.c_str());
+	ProxyPool<PTZBindingProxy>::Lease proxy(proxies_.ptz_);
 
 	_tptz__RelativeMove tptz__RelativeMove;
 	_tptz__RelativeMoveResponse response;
@@ -928,35 +1379,44 @@ int OnvifControl::send_relative_move_ptz(const std::string& ptz, const std::stri
 	tptz__RelativeMove.Translation = &v;
 	tptz__RelativeMove.ProfileToken = token;
 
-	add_credential(proxy.soap, username, password);
-
-	ret = proxy.RelativeMove(&tptz__RelativeMove, &response);
+	ret = invoke(ControlMetrics::RelativeMove, proxy, [&](PTZBindingProxy& p) {
+		if (fast_path(token)) {
+			float values[] = { vpt.x, vpt.y, vz.x };
+			bool sent = false;
+			int fast = send_template(p, ptz, PtzTemplates::RelativeMove, values, 3, username, password, response, sent);
+			if (!fast_path_failed(ControlMetrics::RelativeMove, fast, sent))
+				return fast;
+		}
+		add_credential(p.soap, username, password);
+		return p.RelativeMove(ptz.c_str(), NULL, &tptz__RelativeMove, &response);
+	});
 	if (SOAP_OK == ret)
-		logger()->trace("OnvifControl::{} success pan = {} tilt = {} zoom = {}", __func__, x, y, z);
+		PTZ_TRACE("OnvifControl::{} success pan = {} tilt = {} zoom = {}", __func__, x, y, z);
 	else
 		logger()->error("OnvifControl::{} failed pan = {} tilt = {} zoom = {} error = {}", __func__, x, y, z, 
 			(response.soap && response.soap->fault && response.soap->fault->faultstring) ? response.soap->fault->faultstring : "unknown");
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
 int OnvifControl::get_profiles(const std::string& media, const std::string& username, const std::string& password, std::vector<ProfileData> &vpd)
 {
-	logger()->trace("OnvifControl::{} media = {} username = {} password = {} (entry)", __func__, media, username, password);
+	PTZ_TRACE("OnvifControl::{} media = {} (entry)", __func__, media);
 
 	int ret = SOAP_ERR;
 
 	std::map<std::string, std::string> profiles;
 
-	MediaBindingProxy proxy(media.c_str());
+	ProxyPool<MediaBindingProxy>::Lease proxy(proxies_.media_);
 
 	_trt__GetProfiles trt__GetProfiles;
 	_trt__GetProfilesResponse trt__GetProfilesResponse;
 
-	add_credential(proxy.soap, username, password);
-
-	ret = proxy.GetProfiles(&trt__GetProfiles, &trt__GetProfilesResponse);
+	ret = invoke(ControlMetrics::GetProfiles, proxy, [&](MediaBindingProxy& p) {
+		add_credential(p.soap, username, password);
+		return p.GetProfiles(media.c_str(), NULL, &trt__GetProfiles, &trt__GetProfilesResponse);
+	});
 	if (SOAP_OK == ret) {
 		for (std::vector<tt__Profile * >::const_iterator it = trt__GetProfilesResponse.Profiles.begin(); it != trt__GetProfilesResponse.Profiles.end(); ++it) {
 			tt__Profile* profile = *it;
@@ -966,11 +1426,11 @@ int OnvifControl::get_profiles(const std::string& media, const std::string& user
 			profile_data.name_ = profile->Name;
 			profile_data.token_ = profile->token;
 
-			logger()->trace("OnvifControl::{} profile {}: {} - fixed: {}", __func__, profile->token.c_str(), profile->Name.c_str(), *(profile->fixed));
+			PTZ_TRACE("OnvifControl::{} profile {}: {} - fixed: {}", __func__, profile->token.c_str(), profile->Name.c_str(), *(profile->fixed));
 
 			if (profile->VideoSourceConfiguration) {
 				profile_data.video_src_token_ = profile->VideoSourceConfiguration->SourceToken;
-				logger()->trace("OnvifControl::{} video source token = {}", __func__, profile_data.video_src_token_);
+				PTZ_TRACE("OnvifControl::{} video source token = {}", __func__, profile_data.video_src_token_);
 			}
 
 			if (profile->VideoEncoderConfiguration) {
@@ -989,51 +1449,56 @@ int OnvifControl::get_profiles(const std::string& media, const std::string& user
 				profile_data.x_ = profile->VideoEncoderConfiguration->Resolution->Width;
 				profile_data.y_ = profile->VideoEncoderConfiguration->Resolution->Height;
 
-				logger()->trace("OnvifControl::{} codec = {} resolution = {}x{}", __func__, encoding, profile_data.x_, profile_data.y_);
+				PTZ_TRACE("OnvifControl::{} codec = {} resolution = {}x{}", __func__, encoding, profile_data.x_, profile_data.y_);
 
 				if (profile->VideoEncoderConfiguration->RateControl) {
 					profile_data.rate_limit_ = profile->VideoEncoderConfiguration->RateControl->FrameRateLimit;
 					profile_data.encoding_interval_ = profile->VideoEncoderConfiguration->RateControl->EncodingInterval;
 					profile_data.bitrate_limit_ = profile->VideoEncoderConfiguration->RateControl->BitrateLimit;
-					logger()->trace("OnvifControl::{} FPS limit = {} encoding interval = {} bitrate limit = {}", __func__, profile_data.rate_limit_, profile_data.encoding_interval_, profile_data.bitrate_limit_);
+					PTZ_TRACE("OnvifControl::{} FPS limit = {} encoding interval = {} bitrate limit = {}", __func__, profile_data.rate_limit_, profile_data.encoding_interval_, profile_data.bitrate_limit_);
 				}
 
 				// Todo add loading of optional configuratio ptz limits 
 				if (profile->PTZConfiguration) {
+					// A default timeout is what tells that ContinuousMove honours Timeout
+					if (profile->PTZConfiguration->DefaultPTZTimeout && *profile->PTZConfiguration->DefaultPTZTimeout > 0)
+						profile_data.ptz_timeout_ms_ = (uint32_t) *profile->PTZConfiguration->DefaultPTZTimeout;
+					PTZ_TRACE("OnvifControl::{} default PTZ timeout = {} ms", __func__, profile_data.ptz_timeout_ms_);
 				}
                                 
 				vpd.push_back(profile_data);
 			}
 		}
 	} else {
-		logger()->error("OnvifControl::{} failed  error = {}", __func__, proxy.soap_fault_detail());
+		logger()->error("OnvifControl::{} failed  error = {}", __func__, proxy->soap_fault_detail());
 	}
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
 
 int OnvifControl::get_presets(const std::string& ptz, const std::string& profile_token, const std::string& username, const std::string& password, CameraControl::presets_t& presets)
 {
-	logger()->trace("OnvifControl::{} ptz = {} profile token = {} username = {} password = {} (entry)", __func__, ptz, profile_token, username, password);
+	PTZ_TRACE("OnvifControl::{} ptz = {} profile token = {} (entry)", __func__, ptz, profile_token);
 	int ret = SOAP_ERR;
 
-	PTZBindingProxy proxy(ptz.c_str());
+	ProxyPool<PTZBindingProxy>::Lease proxy(proxies_.ptz_);
 
 	_tptz__GetPresets tptz__GetPresets;
 	_tptz__GetPresetsResponse response;
 
 	tptz__GetPresets.ProfileToken = profile_token;
 
-	add_credential(proxy.soap, username, password);
-
-	ret = proxy.GetPresets(&tptz__GetPresets, &response);
+	ret = invoke(ControlMetrics::GetPresets, proxy, [&](PTZBindingProxy& p) {
+		add_credential(p.soap, username, password);
+		return p.GetPresets(ptz.c_str(), NULL, &tptz__GetPresets, &response);
+	});
 	if (SOAP_OK == ret) {
-		logger()->trace("OnvifControl::{} success", __func__);
+		PTZ_TRACE("OnvifControl::{} success", __func__);
 		presets.clear();
 		for (uint32_t i = 0; i < response.Preset.size(); i++) {
-			logger()->trace("OnvifControl::{} Adding preset = {}", __func__, *response.Preset[i]->token  );
+			PTZ_TRACE("OnvifControl::{} Adding preset = {}", __func__, *response.Preset[i]->token  );
 			CameraPreset preset(i,
 				response.Preset[i]->Name->c_str(),
 				response.Preset[i]->token->c_str(),
@@ -1043,23 +1508,24 @@ int OnvifControl::get_presets(const std::string& ptz, const std::string& profile
 			presets[*response.Preset[i]->token] = preset;
 			preset_list_.push_back(*response.Preset[i]->token);
 		}
+		shared_state_.publish(presets);
 			
 	} else {
 		logger()->error("OnvifControl::{} failed error = {}!", __func__,  
 			(response.soap && response.soap->fault && response.soap->fault->faultstring) ? response.soap->fault->faultstring : "unknown");
 	}
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
 int OnvifControl::set_preset(const std::string& ptz, const std::string& profile_token,
 	std::string preset_token, std::string preset_name, const std::string& username, const std::string& password)
 {
-	logger()->trace("OnvifControl::{} ptz = {} profile token = {}  preset token = {}  preset name = {} username = {} password = {} (entry)", __func__, ptz, profile_token, preset_token, preset_name, username, password);
+	PTZ_TRACE("OnvifControl::{} ptz = {} profile token = {}  preset token = {}  preset name = {} (entry)", __func__, ptz, profile_token, preset_token, preset_name);
 	int ret = SOAP_ERR;
 
-	PTZBindingProxy proxy(ptz.c_str());
+	ProxyPool<PTZBindingProxy>::Lease proxy(proxies_.ptz_);
 
 	_tptz__SetPreset tptz__SetPreset;
 	_tptz__SetPresetResponse response;
@@ -1068,26 +1534,27 @@ int OnvifControl::set_preset(const std::string& ptz, const std::string& profile_
 	tptz__SetPreset.PresetToken = &preset_token;
 	tptz__SetPreset.PresetName = &preset_name;
 
-	add_credential(proxy.soap, username, password);
-
-	ret = proxy.SetPreset(&tptz__SetPreset, &response);
+	ret = invoke(ControlMetrics::SetPreset, proxy, [&](PTZBindingProxy& p) {
+		add_credential(p.soap, username, password);
+		return p.SetPreset(ptz.c_str(), NULL, &tptz__SetPreset, &response);
+	});
 	if (SOAP_OK == ret)
-		logger()->trace("OnvifControl::{} successfully created preset token = {} name = {} in profile = {}", __func__, preset_token, preset_name, profile_token);
+		PTZ_TRACE("OnvifControl::{} successfully created preset token = {} name = {} in profile = {}", __func__, preset_token, preset_name, profile_token);
 	else
 		logger()->error("OnvifControl::{} failed error = {}!", __func__,  
 			(response.soap && response.soap->fault && response.soap->fault->faultstring) ? response.soap->fault->faultstring : "unknown");
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
 int OnvifControl::goto_preset(const std::string& ptz, const std::string& profile_token,
 	const std::string& preset_token, const std::string& username, const std::string& password)
 {
-	logger()->trace("OnvifControl::{} ptz = {} profile token = {} preset token = {}  username = {} password = {} (entry)", __func__, ptz, profile_token, preset_token, username, password);
+	PTZ_TRACE("OnvifControl::{} ptz = {} profile token = {} preset token = {} (entry)", __func__, ptz, profile_token, preset_token);
 	int ret = SOAP_ERR;
 
-	PTZBindingProxy proxy(ptz.c_str());
+	ProxyPool<PTZBindingProxy>::Lease proxy(proxies_.ptz_);
 
 	_tptz__GotoPreset tptz__GotoPreset;
 	_tptz__GotoPresetResponse response;
@@ -1095,26 +1562,27 @@ int OnvifControl::goto_preset(const std::string& ptz, const std::string& profile
 	tptz__GotoPreset.ProfileToken = profile_token;
 	tptz__GotoPreset.PresetToken = preset_token;
 
-	add_credential(proxy.soap, username, password);
-
-	ret = proxy.GotoPreset(&tptz__GotoPreset, &response);
+	ret = invoke(ControlMetrics::GotoPreset, proxy, [&](PTZBindingProxy& p) {
+		add_credential(p.soap, username, password);
+		return p.GotoPreset(ptz.c_str(), NULL, &tptz__GotoPreset, &response);
+	});
 	if (SOAP_OK == ret)
-		logger()->trace("OnvifControl::{} success", __func__);
+		PTZ_TRACE("OnvifControl::{} success", __func__);
 	else
 		logger()->error("OnvifControl::{} failed error = {}!", __func__,  
 			(response.soap && response.soap->fault && response.soap->fault->faultstring) ? response.soap->fault->faultstring : "unknown");
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
 int OnvifControl::remove_preset(const std::string& ptz, const std::string& profile_token,
 	const std::string& preset_token, const std::string& username, const std::string& password)
 {
-	logger()->trace("OnvifControl::{} ptz = {} profile token = {}  preset token = {}  username = {} password = {} (entry)", __func__, ptz, profile_token, preset_token, username, password);
+	PTZ_TRACE("OnvifControl::{} ptz = {} profile token = {}  preset token = {} (entry)", __func__, ptz, profile_token, preset_token);
 	int ret = SOAP_ERR;
 
-	PTZBindingProxy proxy(ptz.c_str());
+	ProxyPool<PTZBindingProxy>::Lease proxy(proxies_.ptz_);
 
 	_tptz__RemovePreset tptz__RemovePreset;
 	_tptz__RemovePresetResponse response;
@@ -1122,72 +1590,75 @@ int OnvifControl::remove_preset(const std::string& ptz, const std::string& profi
 	tptz__RemovePreset.ProfileToken = profile_token;
 	tptz__RemovePreset.PresetToken = preset_token;
 
-	add_credential(proxy.soap, username, password);
-
-	ret = proxy.RemovePreset(&tptz__RemovePreset, &response);
+	ret = invoke(ControlMetrics::RemovePreset, proxy, [&](PTZBindingProxy& p) {
+		add_credential(p.soap, username, password);
+		return p.RemovePreset(ptz.c_str(), NULL, &tptz__RemovePreset, &response);
+	});
 	if (SOAP_OK == ret)
-		logger()->trace("OnvifControl::{} success", __func__);
+		PTZ_TRACE("OnvifControl::{} success", __func__);
 	else
 		logger()->error("OnvifControl::{} failed error = {}!", __func__,  
 			(response.soap && response.soap->fault && response.soap->fault->faultstring) ? response.soap->fault->faultstring : "unknown");
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
 int OnvifControl::set_home_position(const std::string& ptz, const std::string& profile_token, const std::string& username, const std::string& password)
 {
-	logger()->trace("OnvifControl::{} ptz = {} profile token = {} username = {} password = {} (entry)", __func__, ptz, profile_token, username, password);
+	PTZ_TRACE("OnvifControl::{} ptz = {} profile token = {} (entry)", __func__, ptz, profile_token);
 	int ret = SOAP_ERR;
 
-	PTZBindingProxy proxy(ptz.c_str());
+	ProxyPool<PTZBindingProxy>::Lease proxy(proxies_.ptz_);
 
 	_tptz__SetHomePosition tptz__SetHomePosition;
 	_tptz__SetHomePositionResponse response;
 
 	tptz__SetHomePosition.ProfileToken = profile_token;
 
-	add_credential(proxy.soap, username, password);
-
-	ret = proxy.SetHomePosition(&tptz__SetHomePosition, &response);
+	ret = invoke(ControlMetrics::SetHomePosition, proxy, [&](PTZBindingProxy& p) {
+		add_credential(p.soap, username, password);
+		return p.SetHomePosition(ptz.c_str(), NULL, &tptz__SetHomePosition, &response);
+	});
 	if (SOAP_OK == ret)
-		logger()->trace("OnvifControl::{} success", __func__);
+		PTZ_TRACE("OnvifControl::{} success", __func__);
 	else
 		logger()->error("OnvifControl::{} failed error = {}!", __func__,  
 			(response.soap && response.soap->fault && response.soap->fault->faultstring) ? response.soap->fault->faultstring : "unknown");
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
 int OnvifControl::goto_home_position(const std::string& ptz, const std::string& profile_token, const std::string& username, const std::string& password)
 {
-	logger()->trace("OnvifControl::{} ptz = {} profile token = {} username = {} password = {} (entry)", __func__, ptz, profile_token, username, password);
+	PTZ_TRACE("OnvifControl::{} ptz = {} profile token = {} (entry)", __func__, ptz, profile_token);
 	int ret = SOAP_ERR;
 
-	PTZBindingProxy proxy(ptz.c_str());
+	ProxyPool<PTZBindingProxy>::Lease proxy(proxies_.ptz_);
 
 	_tptz__GotoHomePosition tptz__GotoHomePosition;
 	_tptz__GotoHomePositionResponse response;
 
 	tptz__GotoHomePosition.ProfileToken = profile_token;
 
-	add_credential(proxy.soap, username, password);
-
-	ret = proxy.GotoHomePosition(&tptz__GotoHomePosition, &response);
+	ret = invoke(ControlMetrics::GotoHomePosition, proxy, [&](PTZBindingProxy& p) {
+		add_credential(p.soap, username, password);
+		return p.GotoHomePosition(ptz.c_str(), NULL, &tptz__GotoHomePosition, &response);
+	});
 	if (SOAP_OK == ret)
-		logger()->trace("OnvifControl::{} success", __func__);
+		PTZ_TRACE("OnvifControl::{} success", __func__);
 	else
 		logger()->error("OnvifControl::{} failed error = {}!", __func__,  
 			(response.soap && response.soap->fault && response.soap->fault->faultstring) ? response.soap->fault->faultstring : "unknown");
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
 bool OnvifControl::locate_preset(std::map<std::string, CameraPreset> presets, const std::string& token, CameraPreset& preset)
 {
-	logger()->trace("OnvifControl::{} token = {} (entry)", __func__, token);
+	PTZ_TRACE("OnvifControl::{} token = {} (entry)", __func__, token);
 	bool ret = false;
 
 	if (!token.empty()) {
@@ -1198,33 +1669,56 @@ bool OnvifControl::locate_preset(std::map<std::string, CameraPreset> presets, co
 		}
 	}
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
-void OnvifControl::save_position(float x, float y, float z)
+void OnvifControl::save_position(float x, float y, float z, int status)
 {
-	std::string pan, tilt, zoom;
+	float pan = 0, tilt = 0, zoom = 0;
 
-	come_up_with_nvr_values("AbsPT", ptz_details_, pan, tilt, zoom, x, y, z, false);
-	come_up_with_nvr_values("AbsZ", ptz_details_, pan, tilt, zoom, x, y, z, true);
+	come_up_with_nvr_values(AxisSpace::AbsPT, ptz_details_, pan, tilt, zoom, x, y, z, false);
+	come_up_with_nvr_values(AxisSpace::AbsZ, ptz_details_, pan, tilt, zoom, x, y, z, true);
 
 	// NVR values in degrees
 	
-	pan_degrees_ = std::stof(pan);
-	tilt_degrees_ = std::stof(tilt);
-	zoom_degrees_ = std::stof(zoom);
+	pan_degrees_ = pan;
+	tilt_degrees_ = tilt;
+	zoom_degrees_ = zoom;
 	
 	// RAW camera values
 	pan_raw_ = x;
 	tilt_raw_ = y;
 	zoom_raw_ = z;
 
+	PtzPosition pos;
+	pos.pan_ = pan;
+	pos.tilt_ = tilt;
+	pos.zoom_ = zoom;
+	pos.pan_raw_ = x;
+	pos.tilt_raw_ = y;
+	pos.zoom_raw_ = z;
+	pos.status_ = status;
+	pos.stale_ = false;
+	pos.timestamp_us_ = PtzPosition::now_us();
+	position_.store(pos);
+	trajectory_.push(pos);
+	shared_state_.publish(pos);
+}
+
+void OnvifControl::mark_position_stale()
+{
+	PtzPosition pos = position_.load();
+	if (!pos.stale_) {
+		pos.stale_ = true;
+		position_.store(pos);
+		shared_state_.publish(pos);
+	}
 }
 
-bool OnvifControl::poll_status(int command, int16_t token /*= 0*/)
+bool OnvifControl::poll_status(int command, int16_t token /*= 0*/, float fraction /*= 0*/)
 {
-	logger()->trace("OnvifControl::{} (entry)", __func__);
+	PTZ_TRACE("OnvifControl::{} (entry)", __func__);
 	bool ret = false;	
 
 	switch((PtzControl::Type) command) {
@@ -1249,26 +1743,42 @@ bool OnvifControl::poll_status(int command, int16_t token /*= 0*/)
 		case PtzControl::Type::GotoHomePosition:
 		case PtzControl::Type::SelectiveZoom:
 		{
-			bool loop = true;
-			int ctr = 0;
-			do{
+			// The move was just sent, readers must not take the last position
+			// for the current one while it runs
+			mark_position_stale();
+
+			// It also replaced any continuous move, the next continuous_move()
+			// is sent even with the velocities of the old one
+			cont_pan_ = cont_tilt_ = cont_zoom_ = 0;
+			cont_deadline_ = std::chrono::steady_clock::time_point();
+
+			MoveTracker::Move move = move_tracker_.start(fraction, pan_raw_, tilt_raw_, zoom_raw_);
+			uint32_t delay = 0;
+			while ((delay = move.next_delay()) > 0) {
 				int status = 0;
 				float x = 0, y = 0, z = 0;
-				sleep(status_interval_);
-				if (SOAP_OK == send_get_status(ptz_url_, profile_data_.token_, camera_->username, camera_->password, x, y, z, status)) {
-					if (Status::Idle == status) {
-						save_position(x, y, z);
-						loop = false;
-						ret = true;
-					} else {
-						logger()->trace("OnvifControl::{} device status = {}, checking again after 2 seconds", __func__, to_str((Status) status));
-					}
-				} else {
-					loop = false;
+				usleep(delay * 1000);
+				if (SOAP_OK != send_get_status(ptz_url_, profile_data_.token_, camera_->username, camera_->password, x, y, z, status))
+					break;
+
+				// status_loop() skips its ticks while the command holds
+				// config_mutex_, every reading of the move goes to the trajectory
+				save_position(x, y, z, status);
+
+				if (move.update(Status::Idle == status, x, y, z)) {
+					move_tracker_.complete(move);
+					ret = true;
+					break;
 				}
 
-				ctr++;
-			} while (loop && ctr < 3);
+				PTZ_TRACE("OnvifControl::{} device status = {} after {} ms", __func__, to_str((Status) status), move.elapsed_ms());
+			}
+
+			if (!ret) {
+				mark_position_stale();
+				move_tracker_.timeout(move);
+				logger()->debug("OnvifControl::{} move not idle after {} ms", __func__, move.elapsed_ms());
+			}
 
 			break;
 		}
@@ -1296,72 +1806,110 @@ bool OnvifControl::poll_status(int command, int16_t token /*= 0*/)
 			break;
 	}
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
-bool OnvifControl::control(const data_ptr_t& data)
+bool OnvifControl::sample_trace()
+{
+	uint32_t every = trace_every_.load(std::memory_order_relaxed);
+	if (every <= 1 || !logger()->should_log(spdlog::level::trace))
+		return true;
+
+	return (trace_count_.fetch_add(1, std::memory_order_relaxed) % every) == 0;
+}
+
+ControlResult OnvifControl::execute(const data_ptr_t& data)
 {
-	logger()->trace("OnvifControl::{} initialized = {} (entry)", __func__, ready_ ? "True" : "False");
+	TraceSample trace_sample(sample_trace());
+	PTZ_TRACE("OnvifControl::{} initialized = {} (entry)", __func__, ready_ ? "True" : "False");
+	ControlResult result;
 	int ret = SOAP_ERR;	
 
-	if (!ready_)
-		init();
+	// Initialization runs in the background, fail fast while the camera is unreachable
+	if (InitState::Connected != init_state()) {
+		logger()->debug("OnvifControl::{} not connected, state = {} retry in {} ms", __func__, to_str(init_state()), init_retry_in());
+		result.success_ = false;
+		return result;
+	}
 
-	if (ready_ && data.get()) {
-		logger()->trace("OnvifControl::{} processing command type = {} ", __func__, PtzControl::to_str((PtzControl::Type) data->type));
+	std::lock_guard<std::mutex> lock(config_mutex_);
 
-		send_response_ = false;
-		update_position_ = false;
+	if (data.get()) {
+		PTZ_TRACE("OnvifControl::{} processing command type = {} ", __func__, PtzControl::to_str((PtzControl::Type) data->type));
 
 		float x = 0, y = 0, z = 0;
-		std::string pan, tilt, zoom;
 		int status = 0;
 		switch((PtzControl::Type) data->type) {
 			case PtzControl::Type::GetPanTiltZoomPos:
 			{
 				ret = send_get_status(ptz_url_, profile_data_.token_, camera_->username, camera_->password, x, y, z, status);
 				if (SOAP_OK == ret) {
-					save_position(x, y, z);
-					update_position_ = false;
-					send_response_ = true;
-					logger()->trace("OnvifControl::{} command = {} pan = {} tilt = {} zoom = {}", __func__,
+					save_position(x, y, z, status);
+					result.update_position_ = false;
+					result.send_response_ = true;
+					PTZ_TRACE("OnvifControl::{} command = {} pan = {} tilt = {} zoom = {}", __func__,
 						PtzControl::commands_[PtzControl::Type::GetPanTiltZoomPos], pan_degrees_, tilt_degrees_, zoom_degrees_);
 				}
 				break;
 			}
 			case PtzControl::Type::PanAbs:
 			{
-				pan = std::to_string(data->pan);
-				if (come_up_with_camera_abs_values("AbsPT", ptz_details_, pan, tilt, zoom, x, y, z)) {
+				if (come_up_with_camera_abs_values(AxisSpace::AbsPT, ptz_details_, data->pan, 0, 0, x, y, z)) {
 					ret = send_abs_move_pt(ptz_url_, profile_data_.token_, camera_->username, camera_->password, x, tilt_raw_, 0);
 					if (SOAP_OK == ret) {
-						send_response_ = true;
-						update_position_ = poll_status(PtzControl::Type::PanAbs) ? false : true;
+						result.send_response_ = true;
+						result.update_position_ = poll_status(PtzControl::Type::PanAbs, 0, move_fraction(Axis::Pan, x - pan_raw_)) ? false : true;
 					}
 				} 
 				break;
 			}
 			case PtzControl::Type::TiltAbs:
 			{
-				tilt = std::to_string(data->tilt);
-				if (come_up_with_camera_abs_values("AbsPT", ptz_details_, pan, tilt, zoom, x, y, z)) {
+				if (come_up_with_camera_abs_values(AxisSpace::AbsPT, ptz_details_, 0, data->tilt, 0, x, y, z)) {
 					ret = send_abs_move_pt(ptz_url_, profile_data_.token_, camera_->username, camera_->password, pan_raw_, y, 0);
 					if (SOAP_OK == ret) {
-						send_response_ = true;
-						update_position_ = poll_status(PtzControl::Type::TiltAbs) ? false : true;
+						result.send_response_ = true;
+						result.update_position_ = poll_status(PtzControl::Type::TiltAbs, 0, move_fraction(Axis::Tilt, y - tilt_raw_)) ? false : true;
 					}
 				}  
 				break;
 			}
 			case PtzControl::Type::ZoomAbs:
 			{
-				zoom = std::to_string(data->zoom);
-				if (come_up_with_camera_abs_values("AbsZ", ptz_details_, pan, tilt, zoom, x, y, z)) {
+				if (come_up_with_camera_abs_values(AxisSpace::AbsZ, ptz_details_, 0, 0, data->zoom, x, y, z)) {
 					ret = send_abs_move_z(ptz_url_, profile_data_.token_, camera_->username, camera_->password, 0, 0, z);
 					if (SOAP_OK == ret) {
-						send_response_ = true;
-						update_position_ = poll_status(PtzControl::Type::ZoomAbs) ? false : true;
+						result.send_response_ = true;
+						result.update_position_ = poll_status(PtzControl::Type::ZoomAbs, 0, move_fraction(Axis::Zoom, z - zoom_raw_)) ? false : true;
+					}
+				}
+				break;
+			}
+			case PtzControl::Type::PanTiltAbs:
+			{
+				// Both axes in one AbsoluteMove, the move completes when the slower one arrives
+				if (come_up_with_camera_abs_values(AxisSpace::AbsPT, ptz_details_, data->pan, data->tilt, 0, x, y, z)) {
+					ret = send_abs_move_pt(ptz_url_, profile_data_.token_, camera_->username, camera_->password, x, y, 0);
+					if (SOAP_OK == ret) {
+						float fraction = std::max(move_fraction(Axis::Pan, x - pan_raw_), move_fraction(Axis::Tilt, y - tilt_raw_));
+						result.send_response_ = true;
+						result.update_position_ = poll_status(PtzControl::Type::PanTiltAbs, 0, fraction) ? false : true;
+					}
+				}
+				break;
+			}
+			case PtzControl::Type::PanTiltZoomAbs:
+			{
+				// Pan/tilt and zoom have separate spaces, converted apart and sent together
+				if (come_up_with_camera_abs_values(AxisSpace::AbsPT, ptz_details_, data->pan, data->tilt, 0, x, y, z)
+					&& come_up_with_camera_abs_values(AxisSpace::AbsZ, ptz_details_, 0, 0, data->zoom, x, y, z)) {
+					ret = send_abs_move_ptz(ptz_url_, profile_data_.token_, camera_->username, camera_->password, x, y, z);
+					if (SOAP_OK == ret) {
+						float fraction = std::max(std::max(move_fraction(Axis::Pan, x - pan_raw_), move_fraction(Axis::Tilt, y - tilt_raw_)),
+							move_fraction(Axis::Zoom, z - zoom_raw_));
+						result.send_response_ = true;
+						result.update_position_ = poll_status(PtzControl::Type::PanTiltZoomAbs, 0, fraction) ? false : true;
 					}
 				}
 				break;
@@ -1369,12 +1917,11 @@ bool OnvifControl::control(const data_ptr_t& data)
 			case PtzControl::Type::Pan:
 			{
 				float pan_scaled = 0.0; 
-				AxisDetails axis_details;
-				if ((data->pan != 0.0) && scale_cam_rel_values(Axis::Pan, ptz_details_, data->pan, pan_scaled, axis_details)) {
+				if ((data->pan != 0.0) && scale_cam_rel_values(Axis::Pan, ptz_details_, data->pan, pan_scaled)) {
 					ret = send_relative_move_ptz(ptz_url_, profile_data_.token_, camera_->username, camera_->password, pan_scaled, 0, 0);
 					if (SOAP_OK == ret) {
-						send_response_ = true;
-						update_position_ = poll_status(PtzControl::Type::Pan) ? false : true;
+						result.send_response_ = true;
+						result.update_position_ = poll_status(PtzControl::Type::Pan, 0, move_fraction(Axis::Pan, pan_scaled)) ? false : true;
 					}
 				}				
 				break;
@@ -1383,12 +1930,11 @@ bool OnvifControl::control(const data_ptr_t& data)
 			{
 				float pan_scaled = 0.0; 
 				float pan_degree = 10.0;
-				AxisDetails axis_details;
-				if (scale_cam_rel_values(Axis::Pan, ptz_details_, pan_degree, pan_scaled, axis_details)) {
+				if (scale_cam_rel_values(Axis::Pan, ptz_details_, pan_degree, pan_scaled)) {
 					ret = send_relative_move_ptz(ptz_url_, profile_data_.token_, camera_->username, camera_->password, pan_scaled, 0, 0);
 					if (SOAP_OK == ret) {
-						send_response_ = true;
-						update_position_ = poll_status(PtzControl::Type::PanPlus) ? false : true;
+						result.send_response_ = true;
+						result.update_position_ = poll_status(PtzControl::Type::PanPlus, 0, move_fraction(Axis::Pan, pan_scaled)) ? false : true;
 					}
 				}
 				break;
@@ -1397,12 +1943,11 @@ bool OnvifControl::control(const data_ptr_t& data)
 			{
 				float pan_scaled = 0.0; 
 				float pan_degree = -10.0;
-				AxisDetails axis_details;
-				if (scale_cam_rel_values(Axis::Pan, ptz_details_, pan_degree, pan_scaled, axis_details)) {
+				if (scale_cam_rel_values(Axis::Pan, ptz_details_, pan_degree, pan_scaled)) {
 					ret = send_relative_move_ptz(ptz_url_, profile_data_.token_, camera_->username, camera_->password, pan_scaled, 0, 0);
 					if (SOAP_OK == ret) {
-						send_response_ = true;
-						update_position_ = poll_status(PtzControl::Type::PanMinus) ? false : true;
+						result.send_response_ = true;
+						result.update_position_ = poll_status(PtzControl::Type::PanMinus, 0, move_fraction(Axis::Pan, pan_scaled)) ? false : true;
 					}
 				}	
 				break;
@@ -1410,12 +1955,11 @@ bool OnvifControl::control(const data_ptr_t& data)
 			case PtzControl::Type::Tilt:
 			{
 				float tilt_scaled = 0.0; 
-				AxisDetails axis_details;
-				if ((data->tilt != 0.0) && scale_cam_rel_values(Axis::Tilt, ptz_details_, data->tilt, tilt_scaled, axis_details) ) {
+				if ((data->tilt != 0.0) && scale_cam_rel_values(Axis::Tilt, ptz_details_, data->tilt, tilt_scaled) ) {
 					ret = send_relative_move_ptz(ptz_url_, profile_data_.token_, camera_->username, camera_->password, 0, tilt_scaled, 0);
 					if (SOAP_OK == ret) {
-						send_response_ = true;
-						update_position_ = poll_status(PtzControl::Type::Tilt) ? false : true;
+						result.send_response_ = true;
+						result.update_position_ = poll_status(PtzControl::Type::Tilt, 0, move_fraction(Axis::Tilt, tilt_scaled)) ? false : true;
 					}
 				}				
 				break;
@@ -1424,12 +1968,11 @@ bool OnvifControl::control(const data_ptr_t& data)
 			{
 				float tilt_scaled = 0.0; 
 				float tilt_degree = 10.0;
-				AxisDetails axis_details;
-				if (scale_cam_rel_values(Axis::Tilt, ptz_details_, tilt_degree, tilt_scaled, axis_details)) {
+				if (scale_cam_rel_values(Axis::Tilt, ptz_details_, tilt_degree, tilt_scaled)) {
 					ret = send_relative_move_ptz(ptz_url_, profile_data_.token_, camera_->username, camera_->password, 0, tilt_scaled, 0);
 					if (SOAP_OK == ret) {
-						send_response_ = true;
-						update_position_ = poll_status(PtzControl::Type::TiltPlus) ? false : true;
+						result.send_response_ = true;
+						result.update_position_ = poll_status(PtzControl::Type::TiltPlus, 0, move_fraction(Axis::Tilt, tilt_scaled)) ? false : true;
 					}
 				}
 				break;
@@ -1438,12 +1981,11 @@ bool OnvifControl::control(const data_ptr_t& data)
 			{
 				float tilt_scaled = 0.0; 
 				float tilt_degree = -10.0;
-				AxisDetails axis_details;
-				if (scale_cam_rel_values(Axis::Tilt, ptz_details_, tilt_degree, tilt_scaled, axis_details)) {
+				if (scale_cam_rel_values(Axis::Tilt, ptz_details_, tilt_degree, tilt_scaled)) {
 					ret = send_relative_move_ptz(ptz_url_, profile_data_.token_, camera_->username, camera_->password, 0, tilt_scaled, 0);
 					if (SOAP_OK == ret) {
-						send_response_ = true;
-						update_position_ = poll_status(PtzControl::Type::TiltMinus) ? false : true;
+						result.send_response_ = true;
+						result.update_position_ = poll_status(PtzControl::Type::TiltMinus, 0, move_fraction(Axis::Tilt, tilt_scaled)) ? false : true;
 					}
 				}
 				break;
@@ -1451,12 +1993,11 @@ bool OnvifControl::control(const data_ptr_t& data)
 			case PtzControl::Type::Zoom:
 			{
 				float zoom_scaled = 0.0; 
-				AxisDetails axis_details;
-				if ((data->zoom != 0.0) && scale_cam_rel_values(Axis::Zoom, ptz_details_, data->zoom, zoom_scaled, axis_details)) {
+				if ((data->zoom != 0.0) && scale_cam_rel_values(Axis::Zoom, ptz_details_, data->zoom, zoom_scaled)) {
 					ret = send_relative_move_ptz(ptz_url_, profile_data_.token_, camera_->username, camera_->password, 0, 0, zoom_scaled);
 					if (SOAP_OK == ret) {
-						send_response_ = true;
-						update_position_ = poll_status(PtzControl::Type::Zoom) ? false : true;
+						result.send_response_ = true;
+						result.update_position_ = poll_status(PtzControl::Type::Zoom, 0, move_fraction(Axis::Zoom, zoom_scaled)) ? false : true;
 					}
 				}
 				break;
@@ -1465,12 +2006,11 @@ bool OnvifControl::control(const data_ptr_t& data)
 			{
 				float zoom_scaled = 0.0; 
 				float zoom_degree = 0.4; 
-				AxisDetails axis_details;
-				if (scale_cam_rel_values(Axis::Zoom, ptz_details_, zoom_degree, zoom_scaled, axis_details)) {
+				if (scale_cam_rel_values(Axis::Zoom, ptz_details_, zoom_degree, zoom_scaled)) {
 					ret = send_relative_move_ptz(ptz_url_, profile_data_.token_, camera_->username, camera_->password, 0, 0, zoom_scaled);
 					if (SOAP_OK == ret) {
-						send_response_ = true;
-						update_position_ = poll_status(PtzControl::Type::ZoomPlus) ? false : true;
+						result.send_response_ = true;
+						result.update_position_ = poll_status(PtzControl::Type::ZoomPlus, 0, move_fraction(Axis::Zoom, zoom_scaled)) ? false : true;
 					}
 				}				
 				break;
@@ -1479,12 +2019,30 @@ bool OnvifControl::control(const data_ptr_t& data)
 			{
 				float zoom_scaled = 0.0; 
 				float zoom_degree = -0.4; 
-				AxisDetails axis_details;
-				if (scale_cam_rel_values(Axis::Zoom, ptz_details_, zoom_degree, zoom_scaled, axis_details)) {
+				if (scale_cam_rel_values(Axis::Zoom, ptz_details_, zoom_degree, zoom_scaled)) {
 					ret = send_relative_move_ptz(ptz_url_, profile_data_.token_, camera_->username, camera_->password, 0, 0, zoom_scaled);
 					if (SOAP_OK == ret){
-						send_response_ = true;
-						update_position_ = poll_status(PtzControl::Type::ZoomMinus) ? false : true;
+						result.send_response_ = true;
+						result.update_position_ = poll_status(PtzControl::Type::ZoomMinus, 0, move_fraction(Axis::Zoom, zoom_scaled)) ? false : true;
+					}
+				}
+				break;
+			}
+			case PtzControl::Type::PanTilt:
+			case PtzControl::Type::PanTiltZoom:
+			{
+				// Relative move on several axes at once, e.g. coalesced joystick moves
+				float pan_scaled = 0.0, tilt_scaled = 0.0, zoom_scaled = 0.0;
+				bool zoom = (PtzControl::Type::PanTiltZoom == (PtzControl::Type) data->type);
+				bool pan_ok = (data->pan != 0) && scale_cam_rel_values(Axis::Pan, ptz_details_, data->pan, pan_scaled);
+				bool tilt_ok = (data->tilt != 0) && scale_cam_rel_values(Axis::Tilt, ptz_details_, data->tilt, tilt_scaled);
+				bool zoom_ok = zoom && (data->zoom != 0) && scale_cam_rel_values(Axis::Zoom, ptz_details_, data->zoom, zoom_scaled);
+				if (pan_ok || tilt_ok || zoom_ok) {
+					ret = send_relative_move_ptz(ptz_url_, profile_data_.token_, camera_->username, camera_->password, pan_scaled, tilt_scaled, zoom_scaled);
+					if (SOAP_OK == ret) {
+						float fraction = std::max(move_fraction(Axis::Pan, pan_scaled), std::max(move_fraction(Axis::Tilt, tilt_scaled), move_fraction(Axis::Zoom, zoom_scaled)));
+						result.send_response_ = true;
+						result.update_position_ = poll_status(data->type, 0, fraction) ? false : true;
 					}
 				}
 				break;
@@ -1493,15 +2051,15 @@ bool OnvifControl::control(const data_ptr_t& data)
 			{
 				// Caveat - this command will reset the camera
 				ret = system_reboot(device_url_, camera_->username, camera_->password);
-				send_response_ = false;
-				update_position_ = false;
+				result.send_response_ = false;
+				result.update_position_ = false;
 				break;
 			}
 			case PtzControl::Type::GetPresets:
 			{
 				ret = get_presets(ptz_url_, profile_data_.token_, camera_->username, camera_->password, presets_);
-				send_response_ = false;
-				update_position_ = false;				
+				result.send_response_ = false;
+				result.update_position_ = false;				
 				break;
 			}			
 			case PtzControl::Type::SetPreset:
@@ -1520,8 +2078,8 @@ bool OnvifControl::control(const data_ptr_t& data)
 					if (SOAP_OK == ret)
 						ret = poll_status(PtzControl::Type::SetPreset, data->token) ? SOAP_OK : SOAP_ERR;
 				}
-				send_response_ = true;
-				update_position_ = false;				
+				result.send_response_ = true;
+				result.update_position_ = false;				
 				break;
 			}
 			case PtzControl::Type::GotoPreset:
@@ -1529,16 +2087,16 @@ bool OnvifControl::control(const data_ptr_t& data)
 				std::string token = std::to_string(data->token);
 				ret = goto_preset(ptz_url_, profile_data_.token_, token, camera_->username, camera_->password);
 				if (SOAP_OK == ret) {
-					send_response_ = true;
-					update_position_ = poll_status(PtzControl::Type::GotoPreset) ? false : true;
+					result.send_response_ = true;
+					result.update_position_ = poll_status(PtzControl::Type::GotoPreset) ? false : true;
 				}
 				break;
 			}
 			case PtzControl::Type::SetHomePosition:
 			{
 				ret = set_home_position(ptz_url_, profile_data_.token_, camera_->username, camera_->password);
-				send_response_ = true;
-				update_position_ = false;
+				result.send_response_ = true;
+				result.update_position_ = false;
 				break;
 			}
 			case PtzControl::Type::GotoHomePosition:
@@ -1546,19 +2104,22 @@ bool OnvifControl::control(const data_ptr_t& data)
 			{
 				ret = goto_home_position(ptz_url_, profile_data_.token_, camera_->username, camera_->password);
 				if (SOAP_OK == ret) {
-					send_response_ = true;
-					update_position_ = poll_status(PtzControl::Type::GotoHomePosition) ? false : true;
+					result.send_response_ = true;
+					result.update_position_ = poll_status(PtzControl::Type::GotoHomePosition) ? false : true;
 				}
 				break;
 			}
 			case PtzControl::Type::SelectiveZoom:
 			{
-				if (common::Utilities::curl(create_aux_url(data), camera_->auth_type, camera_->username, camera_->password)) {
-					send_response_ = true;
-					ret = SOAP_OK;
-					update_position_ = poll_status(PtzControl::Type::SelectiveZoom) ? false : true;
-				} else {
-					logger()->error("OnvifControl::{} curl error = {}", __func__, common::Utilities::cb_buffer_ ->get_data());
+				float pan_scaled = 0.0, tilt_scaled = 0.0, zoom_scaled = 0.0;
+				if (selective_zoom_values(data, pan_scaled, tilt_scaled, zoom_scaled)) {
+					ret = send_relative_move_ptz(ptz_url_, profile_data_.token_, camera_->username, camera_->password, pan_scaled, tilt_scaled, zoom_scaled);
+					if (SOAP_OK == ret) {
+						float fraction = std::max(std::max(move_fraction(Axis::Pan, pan_scaled), move_fraction(Axis::Tilt, tilt_scaled)),
+							move_fraction(Axis::Zoom, zoom_scaled));
+						result.send_response_ = true;
+						result.update_position_ = poll_status(PtzControl::Type::SelectiveZoom, 0, fraction) ? false : true;
+					}
 				}
 				break;
 			}
@@ -1588,63 +2149,420 @@ bool OnvifControl::control(const data_ptr_t& data)
 				break;
 			}
 			default:
-				send_response_ = false;
-				logger()->trace("OnvifControl::{} Unsupported PTZ command = {} (exit)", __func__, PtzControl::commands_[(PtzControl::Type) data->type]);
+				result.send_response_ = false;
+				PTZ_TRACE("OnvifControl::{} Unsupported PTZ command = {} (exit)", __func__, PtzControl::commands_[(PtzControl::Type) data->type]);
 				break;
 		}
 	}
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
-	return (SOAP_OK == ret);	
+	result.success_ = (SOAP_OK == ret);
+
+	// The camera moved without a confirmed position
+	if (result.update_position_)
+		mark_position_stale();
+
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	return result;
+}
+
+bool OnvifControl::continuous_move(float pan, float tilt, float zoom, uint32_t timeout_ms)
+{
+	bool sent = false;
+	return continuous_move(pan, tilt, zoom, timeout_ms, sent);
 }
 
-std::string OnvifControl::create_aux_url(const data_ptr_t& data)
+bool OnvifControl::continuous_move(float pan, float tilt, float zoom, uint32_t timeout_ms, bool& sent)
 {
-	logger()->trace("OnvifControl::{} (entry)", __func__);
+	TraceSample trace_sample(sample_trace());
+	PTZ_TRACE("OnvifControl::{} pan = {} tilt = {} zoom = {} timeout = {} ms (entry)", __func__, pan, tilt, zoom, timeout_ms);
 
-	std::string url;
-	if (camera_ && !camera_->ptz_control_ip.empty()) {
-		url = std::string("http://") + camera_->ptz_control_ip + std::string(":");
-		if (camera_->ptz_control_port > 0)
-			url += std::to_string(camera_->ptz_control_port);
-		else
-			url += "80";
+	if (InitState::Connected != init_state()) {
+		logger()->debug("OnvifControl::{} not connected, state = {}", __func__, to_str(init_state()));
+		return false;
+	}
 
-		// width/height percentage start/end x/y
-		float wpsx = data->spos_x/(1.0 * data->width);
-		float wpsy = data->spos_y/(1.0 * data->height);
-		float hpsx = data->epos_x/(1.0 * data->width);
-		float hpsy = data->epos_y/(1.0 * data->height);
+	if (!timeout_ms)
+		timeout_ms = cont_timeout_ms_;
 
-		uint16_t scaled_spos_x = ceil(wpsx * profiles_[0].x_);
-		uint16_t scaled_spos_y = ceil(wpsy * profiles_[0].y_);
-		uint16_t scaled_epos_x = ceil(hpsx * profiles_[0].x_);
-		uint16_t scaled_epos_y = ceil(hpsy * profiles_[0].y_);
+	std::lock_guard<std::mutex> lock(config_mutex_);
 
-		url += std::string("/cgi-bin/camctrl?sposition_x=") + std::to_string(scaled_spos_x) \
-			+ std::string("&sposition_y=") + std::to_string(scaled_spos_y) \
-			+ std::string("&eposition_x=") + std::to_string(scaled_epos_x) \
-			+ std::string("&eposition_y=") + std::to_string(scaled_epos_y) \
-			+ std::string("&resolution=") + std::to_string(profiles_[0].x_) \
-			+ std::string("&Language=") + std::to_string(data->language);
+	// Same velocities with more than half of the camera side timeout left
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	if (pan == cont_pan_ && tilt == cont_tilt_ && zoom == cont_zoom_
+		&& cont_deadline_ - now > std::chrono::milliseconds(timeout_ms / 2)) {
+		PTZ_TRACE("OnvifControl::{} still moving (exit)", __func__);
+		return true;
 	}
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, url);
-	return url;
+	// An axis that is still moving is sent even with 0 so it stops. Without
+	// Timeout support the last velocities hold past the deadline.
+	bool moving = cont_deadline_ > now || !profile_data_.ptz_timeout_ms_;
+	int ret = SOAP_OK;
+	if (pan != 0 || tilt != 0 || (moving && (cont_pan_ != 0 || cont_tilt_ != 0))) {
+		ret = send_cont_move_pt(ptz_url_, profile_data_.token_, camera_->username, camera_->password, pan, tilt, 0, timeout_ms);
+		sent = true;
+	}
+	if (SOAP_OK == ret && (zoom != 0 || (moving && cont_zoom_ != 0))) {
+		ret = send_cont_move_z(ptz_url_, profile_data_.token_, camera_->username, camera_->password, 0, 0, zoom, timeout_ms);
+		sent = true;
+	}
+
+	if (SOAP_OK == ret) {
+		cont_pan_ = pan;
+		cont_tilt_ = tilt;
+		cont_zoom_ = zoom;
+		cont_deadline_ = now + std::chrono::milliseconds(timeout_ms);
+	} else {
+		cont_deadline_ = std::chrono::steady_clock::time_point();
+	}
+	mark_position_stale();
+
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	return SOAP_OK == ret;
+}
+
+bool OnvifControl::continuous_stop()
+{
+	TraceSample trace_sample(sample_trace());
+	PTZ_TRACE("OnvifControl::{} (entry)", __func__);
+
+	if (InitState::Connected != init_state())
+		return false;
+
+	std::lock_guard<std::mutex> lock(config_mutex_);
+
+	// Already stopped by the camera, only trusted when the device reported
+	// Timeout support. Tracking relies on Stop actually stopping.
+	if (profile_data_.ptz_timeout_ms_ && cont_deadline_ <= std::chrono::steady_clock::now()) {
+		PTZ_TRACE("OnvifControl::{} timed out already (exit)", __func__);
+		return true;
+	}
+
+	int ret = SOAP_OK;
+	if (cont_pan_ != 0 || cont_tilt_ != 0)
+		ret = send_stop(ptz_url_, profile_data_.token_, camera_->username, camera_->password, false);
+	if (cont_zoom_ != 0) {
+		int zoom_ret = send_stop(ptz_url_, profile_data_.token_, camera_->username, camera_->password, true);
+		if (SOAP_OK == ret)
+			ret = zoom_ret;
+	}
+
+	cont_pan_ = cont_tilt_ = cont_zoom_ = 0;
+	cont_deadline_ = std::chrono::steady_clock::time_point();
+	mark_position_stale();
+
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	return SOAP_OK == ret;
+}
+
+void OnvifControl::start_tracking(const TrackingConfig& config)
+{
+	stop_tracking();
+
+	std::lock_guard<std::mutex> lock(track_mutex_);
+	track_config_ = config;
+	track_stop_ = false;
+	track_fresh_ = false;
+	track_thread_ = std::thread(&OnvifControl::tracking_loop, this);
+}
+
+void OnvifControl::stop_tracking()
+{
+	{
+		std::lock_guard<std::mutex> lock(track_mutex_);
+		track_stop_ = true;
+	}
+	track_cv_.notify_all();
+
+	if (track_thread_.joinable())
+		track_thread_.join();
+}
+
+void OnvifControl::track(float x, float y, float zoom, std::chrono::steady_clock::time_point captured)
+{
+	{
+		std::lock_guard<std::mutex> lock(track_mutex_);
+		track_x_ = x;
+		track_y_ = y;
+		track_zoom_ = zoom;
+		track_captured_ = captured;
+		track_fresh_ = true;
+	}
+	track_cv_.notify_all();
+}
+
+void OnvifControl::tracking_loop()
+{
+	prctl(PR_SET_NAME, "ptz-onvif-track", 0, 0, 0);
+	PTZ_TRACE("OnvifControl::{} (entry)", __func__);
+
+	std::unique_lock<std::mutex> lock(track_mutex_);
+	TrackingConfig config = track_config_;
+	TrackingController controller(config);
+	std::chrono::milliseconds period(1000 / std::max<uint32_t>(config.rate_hz_, 1));
+	std::chrono::steady_clock::time_point previous;
+	bool moving = false;
+
+	while (!track_stop_) {
+		track_cv_.wait_for(lock, std::chrono::milliseconds(config.lost_ms_), [this] { return track_stop_ || track_fresh_; });
+		if (track_stop_)
+			break;
+
+		// Target lost, the camera stops by itself on the move timeout as well
+		if (!track_fresh_) {
+			if (moving) {
+				lock.unlock();
+				logger()->debug("OnvifControl::{} no target for {} ms, stopping", __func__, config.lost_ms_);
+				continuous_stop();
+				lock.lock();
+				controller.reset();
+				previous = std::chrono::steady_clock::time_point();
+				moving = false;
+			}
+			continue;
+		}
+
+		float x = track_x_;
+		float y = track_y_;
+		float zoom = track_zoom_;
+		std::chrono::steady_clock::time_point captured = track_captured_;
+		track_fresh_ = false;
+		lock.unlock();
+
+		// Once calibrated steer by angle, normalized to half the field of view,
+		// so an offset asks for the same turn anywhere in the tilt range
+		PtzCalibration calibration = calibration_.load();
+		if (calibration.calibrated_) {
+			PtzPosition pos = position_.load();
+			float zoom_position = calibration.zoom_.to_value(pos.zoom_raw_);
+			float pan_delta = 0, tilt_delta = 0;
+			calibration.fov_.center(x, y, zoom_position, calibration.tilt_.to_value(pos.tilt_raw_), pan_delta, tilt_delta);
+			x = pan_delta / (calibration.fov_.hfov(zoom_position) / 2);
+			y = -tilt_delta / (calibration.fov_.vfov(zoom_position) / 2);
+		}
+
+		std::chrono::steady_clock::time_point sent = std::chrono::steady_clock::now();
+		float dt = (previous == std::chrono::steady_clock::time_point()) ? 0 : std::chrono::duration<float>(captured - previous).count();
+		previous = captured;
+
+		// Unchanged velocities are absorbed by continuous_move() without a
+		// request, latency is only recorded for frames that reached the camera
+		float pan_velocity = 0, tilt_velocity = 0, zoom_velocity = 0;
+		controller.update(x, y, zoom, dt, pan_velocity, tilt_velocity, zoom_velocity);
+		bool request_sent = false;
+		if (continuous_move(pan_velocity, tilt_velocity, zoom_velocity, config.lost_ms_, request_sent)) {
+			moving = (pan_velocity != 0 || tilt_velocity != 0 || zoom_velocity != 0);
+			if (request_sent) {
+				int64_t latency = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - captured).count();
+				track_latency_us_.record((uint64_t) std::max<int64_t>(latency, 0));
+			}
+		}
+
+		PTZ_TRACE("OnvifControl::{} x = {} y = {} zoom = {} velocity pan = {} tilt = {} zoom = {}", __func__, x, y, zoom, pan_velocity, tilt_velocity, zoom_velocity);
+
+		// Rate limit, targets arriving meanwhile replace each other
+		lock.lock();
+		track_cv_.wait_until(lock, sent + period, [this] { return track_stop_; });
+	}
+	lock.unlock();
+
+	if (moving)
+		continuous_stop();
+
+	PTZ_TRACE("OnvifControl::{} (exit)", __func__);
+}
+
+bool OnvifControl::control(const data_ptr_t& data)
+{
+	ControlResult result = execute(data);
+
+	send_response_ = result.send_response_;
+	update_position_ = result.update_position_;
+
+	return result.success_;
+}
+
+// Pan, tilt and zoom of the RelativeMove that centers the selected rectangle
+// and zooms until it fills the image, in camera relative units
+bool OnvifControl::selective_zoom_values(const data_ptr_t& data, float& x, float& y, float& z)
+{
+	PTZ_TRACE("OnvifControl::{} spos = {},{} epos = {},{} size = {}x{} (entry)", __func__,
+		data->spos_x, data->spos_y, data->epos_x, data->epos_y, data->width, data->height);
+
+	x = y = z = 0;
+	if (!data->width || !data->height) {
+		logger()->error("OnvifControl::{} no image size", __func__);
+		return false;
+	}
+
+	float width = data->width;
+	float height = data->height;
+	float center_x = (data->spos_x + data->epos_x) / width - 1.0f;
+	float center_y = (data->spos_y + data->epos_y) / height - 1.0f;
+
+	// Share of the image the rectangle needs, a click only centers
+	float scale = std::max(fabsf((float) data->epos_x - data->spos_x) / width, fabsf((float) data->epos_y - data->spos_y) / height);
+
+	PtzCalibration calibration = calibration_.load();
+	if (calibration.pan_.points() < 2 || calibration.tilt_.points() < 2) {
+		logger()->error("OnvifControl::{} no pan/tilt limits", __func__);
+		return false;
+	}
+	calibration.fov_.set_aspect(width / height);
+
+	// The deltas are relative to where the camera is, a position never read
+	// or one a move left behind is read once more and refused if that fails
+	PtzPosition pos = position_.load();
+	if (!pos.valid() || pos.stale_) {
+		float raw_x = 0, raw_y = 0, raw_z = 0;
+		int status = 0;
+		if (SOAP_OK != send_get_status(ptz_url_, profile_data_.token_, camera_->username, camera_->password, raw_x, raw_y, raw_z, status)) {
+			logger()->error("OnvifControl::{} no current position", __func__);
+			return false;
+		}
+		save_position(raw_x, raw_y, raw_z, status);
+		pos = position_.load();
+	}
+
+	// Deltas taken through the maps without wrapping, a RelativeMove turns the
+	// short way on its own
+	float pan_degree = calibration.pan_.to_value(pos.pan_raw_);
+	float tilt_degree = calibration.tilt_.to_value(pos.tilt_raw_);
+	float zoom = calibration.zoom_.to_value(pos.zoom_raw_);
+	float pan_delta = 0, tilt_delta = 0;
+	calibration.fov_.center(center_x, center_y, zoom, tilt_degree, pan_delta, tilt_delta);
+
+	x = calibration.pan_.to_raw(pan_degree + pan_delta) - pos.pan_raw_;
+	y = calibration.tilt_.to_raw(tilt_degree + tilt_delta) - pos.tilt_raw_;
+	if (scale > 0.01f && scale < 1.0f && calibration.zoom_.points() >= 2)
+		z = calibration.zoom_.to_raw(calibration.fov_.zoom_for_scale(zoom, scale)) - pos.zoom_raw_;
+
+	PTZ_TRACE("OnvifControl::{} pan = {} tilt = {} degrees, raw x = {} y = {} z = {} (exit)", __func__, pan_delta, tilt_delta, x, y, z);
+	return (x != 0 || y != 0 || z != 0);
+}
+
+bool OnvifControl::pixel_to_ptz(float x, float y, float& pan, float& tilt) const
+{
+	// Mapping from a position never read or one a move left behind points
+	// the camera somewhere else
+	PtzPosition pos = position_.load();
+	if (!pos.valid() || pos.stale_)
+		return false;
+
+	calibration_.load().pixel_to_ptz(x, y, pos.pan_raw_, pos.tilt_raw_, pos.zoom_raw_, pan, tilt);
+	return true;
+}
+
+bool OnvifControl::ptz_to_pixel(float pan, float tilt, float& x, float& y) const
+{
+	PtzPosition pos = position_.load();
+	if (!pos.valid() || pos.stale_)
+		return false;
+
+	return calibration_.load().ptz_to_pixel(pan, tilt, pos.pan_raw_, pos.tilt_raw_, pos.zoom_raw_, x, y);
+}
+
+bool OnvifControl::calibrate(const std::function<bool(float& x, float& y)>& locate, uint32_t zoom_steps /*= 8*/)
+{
+	PTZ_TRACE("OnvifControl::{} zoom steps = {} (entry)", __func__, zoom_steps);
+
+	// Moves with AbsoluteMove and waits for the camera as commands do
+	class Probe : public CalibrationProbe {
+	public:
+		Probe(OnvifControl& control, const std::function<bool(float&, float&)>& locate) : control_(control), locate_(locate) {}
+
+		bool move(float pan, float tilt, float zoom)
+		{
+			OnvifControl& c = control_;
+			if (SOAP_OK != c.send_abs_move_ptz(c.ptz_url_, c.profile_data_.token_, c.camera_->username, c.camera_->password, pan, tilt, zoom))
+				return false;
+
+			float fraction = std::max(std::max(c.move_fraction(Axis::Pan, pan - c.pan_raw_), c.move_fraction(Axis::Tilt, tilt - c.tilt_raw_)),
+				c.move_fraction(Axis::Zoom, zoom - c.zoom_raw_));
+			return c.poll_status(PtzControl::Type::PanTiltZoomAbs, 0, fraction);
+		}
+
+		bool locate(float& x, float& y) { return locate_(x, y); }
+
+	private:
+		OnvifControl& control_;
+		const std::function<bool(float&, float&)>& locate_;
+	};
+
+	std::lock_guard<std::mutex> lock(config_mutex_);
+
+	if (InitState::Connected != init_state() || !ptz_details_.axis_table_[AxisSpace::AbsPT].valid_ || !ptz_details_.axis_table_[AxisSpace::AbsZ].valid_) {
+		logger()->error("OnvifControl::{} needs a connected camera with absolute pan/tilt and zoom", __func__);
+		return false;
+	}
+
+	// Start from where the camera actually is
+	float x = 0, y = 0, z = 0;
+	int status = Status::Unknown;
+	if (SOAP_OK != send_get_status(ptz_url_, profile_data_.token_, camera_->username, camera_->password, x, y, z, status))
+		return false;
+	save_position(x, y, z, status);
+
+	Probe probe(*this, locate);
+	PtzCalibration calibration = calibration_.load();
+	PtzCalibrator calibrator(zoom_steps);
+	bool ret = calibrator.run(probe, pan_raw_, tilt_raw_, calibration);
+	if (ret) {
+		calibration_.store(calibration);
+
+		PtzCache cache;
+		if (!cache.store_calibration(cache_key(), calibration))
+			logger()->debug("OnvifControl::{} failed to store calibration in {}", __func__, PtzCache::default_directory());
+
+		for (uint32_t i = 0; i < calibration.fov_.samples(); i++) {
+			float zoom = 0, hfov = 0;
+			calibration.fov_.sample(i, zoom, hfov);
+			logger()->debug("OnvifControl::{} zoom = {} hfov = {} degrees", __func__, zoom, hfov);
+		}
+	}
+
+	logger()->debug("OnvifControl::{} ret = {} degrees per unit pan = {} tilt = {}", __func__, ret,
+		calibration.pan_.to_value(1) - calibration.pan_.to_value(0), calibration.tilt_.to_value(1) - calibration.tilt_.to_value(0));
+
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	return ret;
 }
 
 void OnvifControl::debug_ptz_node()
 {
-	logger()->trace("OnvifControl::{} home position supported = {} fixed home = {} maximum no. of presets = {}",
+	PTZ_TRACE("OnvifControl::{} home position supported = {} fixed home = {} maximum no. of presets = {}",
 		__func__, ptz_details_.home_support_, ptz_details_.fixed_home_pos_, ptz_details_.max_preset_);
 
 	for (uint32_t i = 0; i < ptz_details_.ptz_axis_.size(); i++) {
-		logger()->trace("OnvifControl::{} axis = {} min x = {} max x = {} min y = {} max y = {}",
+		PTZ_TRACE("OnvifControl::{} axis = {} min x = {} max x = {} min y = {} max y = {}",
 			__func__, ptz_details_.ptz_axis_[i].name_, ptz_details_.ptz_axis_[i].fx_min_,
 			ptz_details_.ptz_axis_[i].fx_max_, ptz_details_.ptz_axis_[i].fy_min_, ptz_details_.ptz_axis_[i].fy_max_);
 	}
 }
 
+std::string OnvifControl::to_str(InitState state)
+{
+	std::string ret;
+
+	switch(state) {
+		case InitState::Connecting:
+			ret = "Connecting";
+			break;
+		case InitState::Connected:
+			ret = "Connected";
+			break;
+		case InitState::WaitingRetry:
+			ret = "WaitingRetry";
+			break;
+		case InitState::Uninitialized:
+		default:
+			ret = "Uninitialized";
+			break;
+	}
+
+	return ret;
+}
+
 std::string OnvifControl::to_str(Status status)
 {
 	std::string ret;
@@ -1668,42 +2586,43 @@ std::string OnvifControl::to_str(Status status)
 // Image related 
 int OnvifControl::img_get_move_options(const std::string& imaging, ProfileData& data, const std::string& username, const std::string& password)
 {
-	logger()->trace("OnvifControl::{} imaging = {} token = {}  username = {} password = {} (entry)", __func__, imaging, data.video_src_token_, username, password);
+	PTZ_TRACE("OnvifControl::{} imaging = {} token = {} (entry)", __func__, imaging, data.video_src_token_);
 	int ret = SOAP_ERR;
 
-	ImagingBindingProxy proxy(imaging.c_str());
+	ProxyPool<ImagingBindingProxy>::Lease proxy(proxies_.imaging_);
 
 	_timg__GetMoveOptions timg__GetMoveOptions;
 	_timg__GetMoveOptionsResponse response;
 
 	timg__GetMoveOptions.VideoSourceToken = data.video_src_token_;
 
-	add_credential(proxy.soap, username, password);
-
-	ret = proxy.GetMoveOptions(&timg__GetMoveOptions, &response);
+	ret = invoke(ControlMetrics::GetMoveOptions, proxy, [&](ImagingBindingProxy& p) {
+		add_credential(p.soap, username, password);
+		return p.GetMoveOptions(imaging.c_str(), NULL, &timg__GetMoveOptions, &response);
+	});
 	if (SOAP_OK == ret) {
-		logger()->trace("OnvifControl::{} success", __func__);
+		PTZ_TRACE("OnvifControl::{} success", __func__);
 		if (response.MoveOptions) {
 			data.abs_focus_ = (response.MoveOptions->Absolute) ? true : false;
 			data.rel_focus_ = (response.MoveOptions->Relative) ? true : false;
 			data.cont_focus_ = (response.MoveOptions->Continuous) ? true : false;
-			logger()->trace("OnvifControl::{}  focus, absolute = {} relative = {} continuous = {}", __func__,
+			PTZ_TRACE("OnvifControl::{}  focus, absolute = {} relative = {} continuous = {}", __func__,
 				(data.abs_focus_ ? "enabled" : "disabled"), (data.rel_focus_ ? "enabled" : "disabled"), (data.cont_focus_ ? "enabled" : "disabled"));
 		}
 	} else {
 		logger()->error("OnvifControl::{} failed error = {}", __func__, (response.soap && response.soap->fault && response.soap->fault->faultstring) ? response.soap->fault->faultstring : "unknown");
 	}
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
 int OnvifControl::img_cont_move_focus(const std::string& imaging, const std::string& token, const std::string& username, const std::string& password, float speed)
 {
-	logger()->trace("OnvifControl::{} imaging = {} token = {}  username = {} password = {} speed = {} (entry)", __func__, imaging, token, username, password, speed);
+	PTZ_TRACE("OnvifControl::{} imaging = {} token = {} speed = {} (entry)", __func__, imaging, token, speed);
 	int ret = SOAP_ERR;
 
-	ImagingBindingProxy proxy(imaging.c_str());
+	ProxyPool<ImagingBindingProxy>::Lease proxy(proxies_.imaging_);
 
 	_timg__Move timg__Move;
 	_timg__MoveResponse response;
@@ -1716,63 +2635,66 @@ int OnvifControl::img_cont_move_focus(const std::string& imaging, const std::str
 	timg__Move.VideoSourceToken = token;
 	timg__Move.Focus = &focus;
 	
-	add_credential(proxy.soap, username, password);
-
-	ret = proxy.Move(&timg__Move, &response);
+	ret = invoke(ControlMetrics::ImagingMove, proxy, [&](ImagingBindingProxy& p) {
+		add_credential(p.soap, username, password);
+		return p.Move(imaging.c_str(), NULL, &timg__Move, &response);
+	});
 	if (SOAP_OK == ret)
-		logger()->trace("OnvifControl::{} success continuous focus speed = {}", __func__, speed);
+		PTZ_TRACE("OnvifControl::{} success continuous focus speed = {}", __func__, speed);
 	else
 		logger()->error("OnvifControl::{} failed continuous focus speed = {} error = {}", __func__, speed, (response.soap && response.soap->fault && response.soap->fault->faultstring) ? response.soap->fault->faultstring : "unknown");
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
 int OnvifControl::img_move_stop(const std::string& imaging, const std::string& token, const std::string& username, const std::string& password)
 {
-	logger()->trace("OnvifControl::{} ptz = {} token = {}  username = {} password = {} (entry)", __func__, token, username, password);
+	PTZ_TRACE("OnvifControl::{} token = {} (entry)", __func__, token);
 	int ret = SOAP_ERR;
 
-	ImagingBindingProxy proxy(imaging.c_str());
+	ProxyPool<ImagingBindingProxy>::Lease proxy(proxies_.imaging_);
 
 	_timg__Stop timg__Stop;
 	_timg__StopResponse response;
 
 	timg__Stop.VideoSourceToken = token;
 
-	add_credential(proxy.soap, username, password);
-
-	ret = proxy.Stop(&timg__Stop, &response);
+	ret = invoke(ControlMetrics::ImagingStop, proxy, [&](ImagingBindingProxy& p) {
+		add_credential(p.soap, username, password);
+		return p.Stop(imaging.c_str(), NULL, &timg__Stop, &response);
+	});
 	if (SOAP_OK == ret)
-		logger()->trace("OnvifControl::{} success stop", __func__);
+		PTZ_TRACE("OnvifControl::{} success stop", __func__);
 	else
 		logger()->error("OnvifControl::{} failed stop error = {}", __func__, (response.soap && response.soap->fault && response.soap->fault->faultstring) ? response.soap->fault->faultstring : "unknown");
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
 int OnvifControl::get_img_setting(const std::string& imaging, const std::string& token, const std::string& username, const std::string& password)
 {
-	logger()->trace("OnvifControl::{} imaging = {} token = {}  username = {} password = {} (entry)", __func__, imaging, token, username, password);
+	PTZ_TRACE("OnvifControl::{} imaging = {} token = {} (entry)", __func__, imaging, token);
 	int ret = SOAP_ERR;
 
-	ImagingBindingProxy proxy(imaging.c_str());
+	ProxyPool<ImagingBindingProxy>::Lease proxy(proxies_.imaging_);
 
 	_timg__GetImagingSettings timg__GetImagingSettings;
 	_timg__GetImagingSettingsResponse response;
 
 	timg__GetImagingSettings.VideoSourceToken = token;
 
-	add_credential(proxy.soap, username, password);
-
-	ret = proxy.GetImagingSettings(&timg__GetImagingSettings, &response);
+	ret = invoke(ControlMetrics::GetImagingSettings, proxy, [&](ImagingBindingProxy& p) {
+		add_credential(p.soap, username, password);
+		return p.GetImagingSettings(imaging.c_str(), NULL, &timg__GetImagingSettings, &response);
+	});
 	if (SOAP_OK == ret)
-		logger()->trace("OnvifControl::{} success {}", __func__);
+		PTZ_TRACE("OnvifControl::{} success {}", __func__);
 	else
 		logger()->error("OnvifControl::{} failed error = {}", __func__, (response.soap && response.soap->fault && response.soap->fault->faultstring) ? response.soap->fault->faultstring : "unknown");
 
-	logger()->trace("OnvifControl::{} ret = {} (exit)", __func__, ret);
+	PTZ_TRACE("OnvifControl::{} ret = {} (exit)", __func__, ret);
 	return ret;
 }
 
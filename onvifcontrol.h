@@ -3,11 +3,29 @@
 #include <streamer/processor/ptz/cameracontrol.h>
 #include <streamer/processor/ptz/ptzcontrol.h>
 #include <streamer/processor/ptz/preset.h>
+#include <streamer/processor/ptz/ptzdetails.h>
+#include <streamer/processor/ptz/proxypool.h>
+#include <streamer/processor/ptz/movetracker.h>
+#include <streamer/processor/ptz/ptzposition.h>
+#include <streamer/processor/ptz/seqlock.h>
+#include <streamer/processor/ptz/broadcastring.h>
+#include <streamer/processor/ptz/soaptemplate.h>
+#include <streamer/processor/ptz/statusparser.h>
+#include <streamer/processor/ptz/wssecredential.h>
+#include <streamer/processor/ptz/trackingcontroller.h>
+#include <streamer/processor/ptz/histogram.h>
+#include <streamer/processor/ptz/ptzcalibration.h>
 #include "soapDeviceBindingProxy.h"
 #include "soapMediaBindingProxy.h"
 #include "soapPTZBindingProxy.h"
 #include "soapImagingBindingProxy.h"
 #include <map>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
 
 namespace orion {
 namespace streamer {
@@ -15,36 +33,6 @@ namespace processor {
 
 class PtzControl;
 
-class ProfileData {
-public:
-	int x_;
-	int y_;
-	int rate_limit_;
-	int encoding_interval_;
-	int bitrate_limit_;
-
-	std::string codec_;
-	std::string name_;
-	std::string token_;
-	std::string video_src_token_;
-
-	bool abs_focus_;
-	bool rel_focus_;
-	bool cont_focus_;
-
-	ProfileData()
-		:x_(0)
-		,y_(0)
-		,rate_limit_(0)
-		,encoding_interval_(0)
-		,bitrate_limit_(0)
-		,abs_focus_(false)
-		,rel_focus_(false)
-		,cont_focus_(false)
-		{
-		}
-};
-
 //class CameraPreset {
 //public:
 //	int		id_;
@@ -75,41 +63,6 @@ public:
 //	}
 //};
 
-class AxisDetails {
-public:
-	std::string name_;
-	std::string uri_;
-
-	float fx_min_;
-	float fx_max_;
-	float fy_min_;
-	float fy_max_;
-
-        AxisDetails() {}
-
-	AxisDetails(const char* name, const char* uri, float fx_min, float fx_max, float fy_min, float fy_max)
-		: name_(name ? name : "")
-		, uri_(uri ? uri : "")
-		, fx_min_(fx_min)
-		, fx_max_(fx_max)
-		, fy_min_(fy_min)
-		, fy_max_(fy_max)
-	{
-	}
-};
-
-class PTZDetails {
-public:
-	std::vector<AxisDetails> ptz_axis_;
-	bool home_support_;
-	bool fixed_home_pos_;
-	int max_preset_;
-
-	PTZDetails(): home_support_(false), fixed_home_pos_(false), max_preset_(0)
-	{
-	}
-};
-
 class OnvifControl : public CameraControl{
 public:
 	enum Axis {
@@ -124,46 +77,254 @@ public:
 		Unknown
 	};
 
+	enum InitState {
+		Uninitialized = 0,
+		Connecting,
+		Connected,
+		WaitingRetry
+	};
+
 	OnvifControl(Camera *camera, const std::string& type, common::Logger::logger_t shared_logger);
 
 	virtual ~OnvifControl();
 
 	bool control(const data_ptr_t& data);
+
+	ControlResult execute(const data_ptr_t& data);
 	
+	// Never waits for the camera, an outdated position only queues a refresh
 	void get_position(data_ptr_t& data);
+
+	// Consistent snapshot of the last known position, safe from any thread
+	PtzPosition position() const { return position_.load(); }
+
+	typedef BroadcastRing<PtzPosition, 256> trajectory_t;
+
+	// Every position read from the camera, by commands and by the status poller
+	const trajectory_t& trajectory() const { return trajectory_; }
+
+	// Poll GetStatus every interval_ms in the background, skipped while a command
+	// is running since commands publish positions themselves. 0 stops polling.
+	void set_status_polling(uint32_t interval_ms);
+
+	// Connection reuse counters of the device/media/ptz/imaging services
+	const OnvifProxyPool& proxy_pool() const { return proxies_; }
+
+	// Render GetStatus, Stop and the move requests from precompiled templates
+	// instead of gSOAP serialization, on by default
+	void set_fast_path(bool enable) { fast_path_rejects_ = 0; fast_path_ = enable; }
+
+	// Background initialization progress, retried with jittered exponential backoff
+	InitState init_state() const { return (InitState) init_state_.load(); }
+
+	uint32_t init_attempts() const { return init_attempts_.load(); }
+
+	// Milliseconds until the next initialization attempt, 0 if none is scheduled
+	uint32_t init_retry_in() const;
+
+	// Time to idle distribution of completed moves
+	const MoveTracker& move_tracker() const { return move_tracker_; }
+
+	// Move at the given velocities (-1 to 1, 0 leaves the axis alone) and let the
+	// camera stop after timeout_ms, 0 uses set_continuous_timeout(). Calling
+	// again with the same velocities only extends the deadline, the request is
+	// resent once less than half of the timeout is left. Any other move sent
+	// by control() ends it. Called directly, PtzControl::Type has no
+	// continuous move or stop for control() to route here.
+	bool continuous_move(float pan, float tilt, float zoom, uint32_t timeout_ms = 0);
+
+	// Stop a continuous move before its timeout. Stop is always sent unless the
+	// PTZ configuration reports a default timeout and the deadline passed.
+	bool continuous_stop();
+
+	// Default timeout of continuous_move() in milliseconds, 1000 unless set
+	void set_continuous_timeout(uint32_t timeout_ms) { cont_timeout_ms_ = timeout_ms; }
+
+	// Follow a target with timed continuous moves driven by a TrackingController.
+	// Requests go out at most config.rate_hz_ times per second and one at a time,
+	// so never faster than the camera answers. Speed follows the zoom as with
+	// other continuous moves, enable status polling to keep the zoom current.
+	void start_tracking(const TrackingConfig& config = TrackingConfig());
+
+	void stop_tracking();
+
+	// Latest target offset, see TrackingController. An offset not acted on yet
+	// is replaced. captured is when the analysed frame was taken.
+	void track(float x, float y, float zoom, std::chrono::steady_clock::time_point captured = std::chrono::steady_clock::now());
+
+	// Microseconds from the capture of a target to the answer of the
+	// ContinuousMove that acted on it
+	const Histogram& tracking_latency() const { return track_latency_us_; }
+
+	// Field of view used to turn SelectiveZoom rectangles into a RelativeMove,
+	// replaced by calibrate()
+	void set_fov_model(const FovModel& fov)
+	{
+		std::lock_guard<std::mutex> lock(config_mutex_);
+		PtzCalibration calibration = calibration_.load();
+		calibration.fov_ = fov;
+		calibration_.store(calibration);
+	}
+
+	PtzCalibration calibration() const { return calibration_.load(); }
+
+	// Measure the field of view over the zoom range and the pan/tilt scale with
+	// a PtzCalibrator. locate returns the image point of a fixed feature, which
+	// must be near the image center when called. Commands wait meanwhile. The
+	// result is used from then on and kept in the PtzCache.
+	bool calibrate(const std::function<bool(float& x, float& y)>& locate, uint32_t zoom_steps = 8);
+
+	// Camera pan/tilt that centers image point x, y (-1 to 1 from the center, y
+	// downwards), and the image point of a camera pan/tilt. Both work from the
+	// last known position, never block and never allocate. False while that
+	// position is unknown or stale (a move is running), and ptz_to_pixel also
+	// when the direction is outside the image.
+	bool pixel_to_ptz(float x, float y, float& pan, float& tilt) const;
+
+	bool ptz_to_pixel(float pan, float tilt, float& x, float& y) const;
+
+	// Trace only one of every n commands of this camera, 0 or 1 traces all
+	void set_trace_sampling(uint32_t n) { trace_every_.store(n, std::memory_order_relaxed); }
+
+	bool trace_enabled() { return trace_sampled_ && logger()->should_log(spdlog::level::trace); }
 protected:
 
 private:
 
+	// Marks the commands of the current thread as sampled or not for its lifetime
+	class TraceSample {
+	public:
+		TraceSample(bool sampled) : saved_(trace_sampled_) { trace_sampled_ = sampled; }
+
+		~TraceSample() { trace_sampled_ = saved_; }
+
+	private:
+		bool saved_;
+	};
+
+	bool sample_trace();
+
+	void status_loop();
+
+	void stop_status_polling();
+
+	void tracking_loop();
+
 	void init();
 
-	bool select_profile(ProfileData &data, const std::string& token = "");
+	bool discover(OnvifDeviceConfig& config);
+
+	static uint32_t elapsed_ms(std::chrono::steady_clock::time_point start);
+
+	void apply(const OnvifDeviceConfig& config);
+
+	bool load_cached_config();
+
+	std::string cache_key() const;
+
+	void start_init();
+
+	void init_loop();
+
+	void stop_init();
+
+	bool select_profile(const std::vector<ProfileData>& profiles, ProfileData &data, const std::string& token = "");
 
 	int set_date_and_time(const std::string& device);
 
 	int get_capabilities(const std::string& device, const std::string& username, const std::string& password, std::string& media, std::string& ptz, std::string& imaging);
 
+	int get_device_information(const std::string& device, const std::string& username, const std::string& password, std::string& firmware);
+
 	int system_reboot(const std::string& device, const std::string& username, const std::string& password);
 
 	int add_credential(struct soap *soap, const std::string& username, const std::string& password);
 
+	bool fast_path(const std::string& token) const { return fast_path_ && !templates_.empty() && templates_.token() == token; }
+
+	// True when a request that failed on the fast path is sent again through
+	// gSOAP. That only happens when the device provably did not process it:
+	// nothing was sent, or the HTTP layer refused it before any SOAP body
+	// (4xx, and 5xx for idempotent operations). FastPathRejects refusals or
+	// unreadable replies in a row switch the camera to gSOAP serialization.
+	bool fast_path_failed(ControlMetrics::Operation op, int ret, bool sent);
+
+	// A reply of the fast path could not be read, counted towards FastPathRejects
+	void fast_path_rejected(int ret);
+
+	static bool auth_fault(struct soap* soap);
+
+	bool sync_clock();
+
+	// Send a precompiled request on the leased connection, the reply is read by
+	// the caller
+	int send_request(PTZBindingProxy& p, const std::string& endpoint, PtzTemplates::Request request, const float* values, size_t count,
+		const std::string& username, const std::string& password);
+
+	// Send a precompiled request and read the reply with the generated
+	// deserializer, following the same steps as the proxy methods. sent is set
+	// once the request was written to the connection.
+	template<typename Response>
+	int send_template(PTZBindingProxy& p, const std::string& endpoint, PtzTemplates::Request request, const float* values, size_t count,
+		const std::string& username, const std::string& password, Response& response, bool& sent)
+	{
+		struct soap* soap = p.soap;
+
+		int ret = send_request(p, endpoint, request, values, count, username, password);
+		if (SOAP_OK != ret)
+			return ret;
+		sent = true;
+
+		response.soap_default(soap);
+		if (soap_begin_recv(soap) || soap_envelope_begin_in(soap) || soap_recv_header(soap) || soap_body_begin_in(soap))
+			return soap_closesock(soap);
+		response.soap_get(soap, PtzTemplates::response(request), NULL);
+		if (soap->error)
+			return soap_recv_fault(soap, 0);
+		if (soap_body_end_in(soap) || soap_envelope_end_in(soap) || soap_end_recv(soap))
+			return soap_closesock(soap);
+		return soap_closesock(soap);
+	}
+
+	// GetStatus on the fast path, the reply body is scanned by StatusParser
+	// instead of being deserialized. There is no fallback to the deserializer
+	// for the same reply, a reply the parser does not read fails the request.
+	int send_status_template(PTZBindingProxy& p, const std::string& endpoint, const std::string& username, const std::string& password, PtzStatusReply& reply, bool& sent);
+
+	static void read_status(const tt__PTZStatus* status, PtzStatusReply& reply);
+
+	// Run one request on a leased proxy and record it in metrics_. A request the
+	// device rejected because of its clock is sent again once the offset is known,
+	// both the fast path and add_credential() apply it to the UsernameToken.
+	template<typename Lease, typename Call>
+	int invoke(ControlMetrics::Operation op, Lease& proxy, Call call)
+	{
+		bool idempotent = ControlMetrics::idempotent(op);
+		int ret = metrics_.measure(op, [&]() { return proxy.invoke(call, idempotent); });
+		if (SOAP_FAULT == ret && auth_fault(proxy->soap) && sync_clock())
+			ret = metrics_.measure(op, [&]() { return proxy.invoke(call, idempotent); });
+		return ret;
+	}
+
 	int get_ptz_nodes(const std::string& ptz, const std::string& username, const std::string& password, std::vector<std::string>& nodes);
 
 	int get_ptz_node(const std::string& ptz, const std::string& username, const std::string& password, const std::string& node, PTZDetails& details);
 
-	void scale_values(const std::string& panval, const std::string& tiltval, const std::string& zoomval, float& x, float& y, float& z, float fx_min, float fx_max, float fy_min, float fy_max);
+	void scale_values(float pan, float tilt, float zoom, bool zoom_axis, float& x, float& y, float& z, float fx_min, float fx_max, float fy_min, float fy_max);
+
+	void scale_abs_camera_values(float pan, float tilt, float zoom, bool zoom_axis, float& x, float& y, float& z, float fx_min, float fx_max, float fy_min, float fy_max);
 
-	void scale_abs_camera_values(const std::string& panval, const std::string& tiltval, const std::string& zoomval, float& x, float& y, float& z, float fx_min, float fx_max, float fy_min, float fy_max);
+	void scale_abs_nvr_values(float& pan, float& tilt, float& zoom, float x, float y, float z, float fx_min, float fx_max, float fy_min, float fy_max, bool zoom_axis);
 
-	void scale_abs_nvr_values(std::string& panval, std::string& tiltval, std::string& zoomval, float& x, float& y, float& z, float fx_min, float fx_max, float fy_min, float fy_max, bool zoom);
+	void come_up_with_nvr_values(AxisSpace space, const PTZDetails& details, float& pan, float& tilt, float& zoom, float x, float y, float z, bool zoom_axis);
 
-	void come_up_with_nvr_values(const char *axis, const PTZDetails& details, std::string& panval, std::string& tiltval, std::string& zoomval, float x, float y, float z, bool zoom);
+	void come_up_with_camera_values(AxisSpace space, const PTZDetails& details, float pan, float tilt, float zoom, float& x, float& y, float& z);
 
-	void come_up_with_camera_values(const char *axis, const PTZDetails& details, const std::string& panval, const std::string& tiltval, std::string& zoomval, float& x, float& y, float& z);
+	bool come_up_with_camera_abs_values(AxisSpace space, const PTZDetails& details, float pan, float tilt, float zoom, float& x, float& y, float& z);
 
-	bool come_up_with_camera_abs_values(const char *axis, const PTZDetails& details, const std::string& panval, const std::string& tiltval, const std::string& zoomval, float& x, float& y, float& z);
+	static bool zoom_space(AxisSpace space);
 
-	bool scale_cam_rel_values(Axis axis, const PTZDetails& ptz_details, float degrees, float& value, AxisDetails& axis_details);
+	bool scale_cam_rel_values(Axis axis, const PTZDetails& ptz_details, float degrees, float& value);
         
 	// PTZ Commands
 	int send_get_status(const std::string& ptz, const std::string& token, const std::string& username, const std::string& password, float& x, float& y, float& z, int& status);
@@ -174,9 +335,12 @@ private:
 
 	int send_abs_move_z(const std::string& ptz, const std::string& token, const std::string& username, const std::string& password, float x, float y, float z);
 
-	int send_cont_move_pt(const std::string& ptz, const std::string& token, const std::string& username, const std::string& password, float x, float y, float z);
+	int send_abs_move_ptz(const std::string& ptz, const std::string& token, const std::string& username, const std::string& password, float x, float y, float z);
 
-	int send_cont_move_z(const std::string& ptz, const std::string& token, const std::string& username, const std::string& password, float x, float y, float z);
+	// timeout_ms > 0 lets the camera stop by itself after that time
+	int send_cont_move_pt(const std::string& ptz, const std::string& token, const std::string& username, const std::string& password, float x, float y, float z, uint32_t timeout_ms);
+
+	int send_cont_move_z(const std::string& ptz, const std::string& token, const std::string& username, const std::string& password, float x, float y, float z, uint32_t timeout_ms);
 
 	int send_relative_move_ptz(const std::string& ptz, const std::string& token, const std::string& username, const std::string& password, float x, float y, float z);
 
@@ -202,35 +366,45 @@ private:
 	
 	int get_img_setting(const std::string& imaging, const std::string& token, const std::string& username, const std::string& password);
 
-	void insert_port(const uint32_t& port);
-
-	std::string convert_to_degree(float value, float min, float max, bool zoom);
+	void insert_port(const uint32_t& port, OnvifDeviceConfig& config);
 
-	float convert_to_raw(const std::string& degree, float min, float max, bool zoom);
+	void build_axis_table(PTZDetails& details);
 
-	bool axis_detail(const std::string& name, const PTZDetails& ptz_details, AxisDetails& axis_details);
-
-	float calculate_range(float min, float max);
+	float move_fraction(Axis axis, float delta);
 
 //	void update_position(Axis axis, const AxisDetails& axis_details, float addend_scaled, float addend_degree);
 
 	bool locate_preset(std::map<std::string, CameraPreset> presets, const std::string& token, CameraPreset& preset);
 
-	bool poll_status(int command, int16_t token = 0);
+	bool poll_status(int command, int16_t token = 0, float fraction = 0);
 	
-	void save_position(float x, float y, float z);
+	void save_position(float x, float y, float z, int status);
+
+	void mark_position_stale();
+
+	// continuous_move(), sent tells whether a request went to the camera
+	bool continuous_move(float pan, float tilt, float zoom, uint32_t timeout_ms, bool& sent);
 
 	void debug_ptz_node();
 
-	std::string create_aux_url(const data_ptr_t& data);
+	bool selective_zoom_values(const data_ptr_t& data, float& x, float& y, float& z);
 
 	std::string to_str(Status status);
 
+	std::string to_str(InitState state);
+
 	std::string device_url_;
 	std::string media_url_;
 	std::string ptz_url_;
 	std::string imaging_url_;
 
+	OnvifProxyPool proxies_;
+
+	std::string firmware_;
+
+	// Set once the configuration was discovered or confirmed by the device
+	bool validated_;
+
 	float pan_raw_;
 	float pan_degrees_;
 
@@ -248,6 +422,64 @@ private:
 
 	uint32_t status_interval_;
 
+	MoveTracker move_tracker_;
+
+	PtzTemplates templates_;
+	enum {
+		FastPathRejects = 3
+	};
+
+	std::atomic<bool> fast_path_;
+	std::atomic<uint32_t> fast_path_rejects_;
+
+	WsseCredential credential_;
+
+	// Last timed ContinuousMove, guarded by config_mutex_
+	float cont_pan_;
+	float cont_tilt_;
+	float cont_zoom_;
+	std::chrono::steady_clock::time_point cont_deadline_;
+	std::atomic<uint32_t> cont_timeout_ms_;
+
+	// Written under config_mutex_
+	SeqLock<PtzCalibration> calibration_;
+
+	TrackingConfig track_config_;
+	bool track_stop_;
+	bool track_fresh_;
+	float track_x_;
+	float track_y_;
+	float track_zoom_;
+	std::chrono::steady_clock::time_point track_captured_;
+	std::mutex track_mutex_;
+	std::condition_variable track_cv_;
+	std::thread track_thread_;
+	Histogram track_latency_us_;
+	std::atomic<std::chrono::steady_clock::time_point> clock_checked_;
+
+	SeqLock<PtzPosition> position_;
+	trajectory_t trajectory_;
+	std::atomic<bool> position_refresh_;
+
+	std::atomic<int> init_state_;
+	std::atomic<uint32_t> init_attempts_;
+	std::atomic<std::chrono::steady_clock::time_point> next_retry_;
+	Backoff init_backoff_;
+	bool init_stop_;
+	std::mutex init_mutex_;
+	std::condition_variable init_cv_;
+	std::thread init_thread_;
+
+	uint32_t status_poll_ms_;
+	bool status_stop_;
+	std::mutex status_mutex_;
+	std::condition_variable status_cv_;
+	std::thread status_thread_;
+
+	std::atomic<uint32_t> trace_every_;
+	std::atomic<uint64_t> trace_count_;
+	static thread_local bool trace_sampled_;
+
 	std::vector<ProfileData> profiles_;
 	ProfileData profile_data_;
 
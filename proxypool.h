@@ -0,0 +1,208 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include "soapDeviceBindingProxy.h"
+#include "soapMediaBindingProxy.h"
+#include "soapPTZBindingProxy.h"
+#include "soapImagingBindingProxy.h"
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+class ProxyPoolStats {
+public:
+	uint64_t hits_;
+	uint64_t misses_;
+	uint64_t reconnects_;
+	uint32_t idle_;
+
+	ProxyPoolStats()
+		: hits_(0)
+		, misses_(0)
+		, reconnects_(0)
+		, idle_(0)
+	{
+	}
+};
+
+// Pool of long-lived gSOAP proxies for one ONVIF service. Proxies are created
+// with SOAP_IO_KEEPALIVE so consecutive calls reuse the same TCP connection.
+template<typename Proxy>
+class ProxyPool {
+public:
+	typedef std::unique_ptr<Proxy> proxy_ptr_t;
+
+	// Exclusive use of one pooled proxy for the duration of a request, including
+	// reading the deserialized response which lives in the proxy soap context.
+	class Lease {
+	public:
+		Lease(ProxyPool& pool) : pool_(pool), proxy_(pool.acquire())
+		{
+		}
+
+		~Lease()
+		{
+			pool_.release(std::move(proxy_));
+		}
+
+		Proxy* operator->() { return proxy_.get(); }
+
+		Proxy& operator*() { return *proxy_; }
+
+		// Run call(proxy) once; when a kept-alive socket turns out to be closed by
+		// the device, reconnect and run it a second time. The device may have
+		// acted on the request before the connection broke, so only idempotent
+		// calls are repeated. Idle sockets the device already closed are
+		// replaced before sending by acquire().
+		template<typename Call>
+		int invoke(Call call, bool idempotent)
+		{
+			bool reused = soap_valid_socket(proxy_->soap->socket);
+			int ret = call(*proxy_);
+			if (reused && idempotent && ProxyPool::broken(ret)) {
+				pool_.reconnects_++;
+				proxy_->destroy();
+				proxy_->soap_close_socket();
+				ret = call(*proxy_);
+			}
+			return ret;
+		}
+
+	private:
+		Lease(const Lease&);
+		Lease& operator=(const Lease&);
+
+		ProxyPool& pool_;
+		proxy_ptr_t proxy_;
+	};
+
+	ProxyPool(size_t max_idle = 2)
+		: max_idle_(max_idle)
+		, hits_(0)
+		, misses_(0)
+		, reconnects_(0)
+	{
+	}
+
+	ProxyPoolStats stats() const
+	{
+		ProxyPoolStats stats;
+		stats.hits_ = hits_.load();
+		stats.misses_ = misses_.load();
+		stats.reconnects_ = reconnects_.load();
+		std::lock_guard<std::mutex> lock(mutex_);
+		stats.idle_ = (uint32_t) idle_.size();
+		return stats;
+	}
+
+	// Close all idle connections, e.g. after the device address changed
+	void clear()
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		idle_.clear();
+	}
+
+	static bool broken(int ret)
+	{
+		return (SOAP_EOF == ret || SOAP_TCP_ERROR == ret);
+	}
+
+	// True when the device closed or reset an idle keep-alive connection
+	static bool closed(SOAP_SOCKET socket)
+	{
+		struct pollfd pfd;
+		pfd.fd = socket;
+		pfd.events = POLLIN;
+		pfd.revents = 0;
+		if (poll(&pfd, 1, 0) <= 0)
+			return false;
+		if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL))
+			return true;
+
+		// Readable while idle means end of stream, or stray data that would
+		// corrupt the next reply
+		char c;
+		ssize_t n = recv(socket, &c, 1, MSG_PEEK | MSG_DONTWAIT);
+		return n >= 0 || (errno != EAGAIN && errno != EWOULDBLOCK);
+	}
+
+private:
+
+	proxy_ptr_t acquire()
+	{
+		proxy_ptr_t proxy;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (!idle_.empty()) {
+				proxy = std::move(idle_.back());
+				idle_.pop_back();
+			}
+		}
+
+		// A connection the device dropped while idle is replaced before the
+		// request is sent, so the call never has to be repeated for it
+		if (proxy.get() && soap_valid_socket(proxy->soap->socket) && closed(proxy->soap->socket)) {
+			reconnects_++;
+			proxy->soap_close_socket();
+		}
+
+		if (proxy.get() && soap_valid_socket(proxy->soap->socket)) {
+			hits_++;
+		} else {
+			misses_++;
+			if (!proxy.get()) {
+				proxy.reset(new Proxy(SOAP_IO_KEEPALIVE));
+				proxy->soap->tcp_keep_alive = 1;
+			}
+		}
+
+		return proxy;
+	}
+
+	void release(proxy_ptr_t proxy)
+	{
+		if (!proxy.get())
+			return;
+
+		// Free the deserialized response, the socket stays open for the next call
+		proxy->destroy();
+
+		std::lock_guard<std::mutex> lock(mutex_);
+		if (idle_.size() < max_idle_)
+			idle_.push_back(std::move(proxy));
+	}
+
+	size_t max_idle_;
+
+	mutable std::mutex mutex_;
+	std::vector<proxy_ptr_t> idle_;
+
+	std::atomic<uint64_t> hits_;
+	std::atomic<uint64_t> misses_;
+	std::atomic<uint64_t> reconnects_;
+};
+
+// Per camera set of pools, one for each ONVIF service url
+class OnvifProxyPool {
+public:
+	ProxyPool<DeviceBindingProxy> device_;
+	ProxyPool<MediaBindingProxy> media_;
+	ProxyPool<PTZBindingProxy> ptz_;
+	ProxyPool<ImagingBindingProxy> imaging_;
+
+	void clear()
+	{
+		device_.clear();
+		media_.clear();
+		ptz_.clear();
+		imaging_.clear();
+	}
+};
+
+}}}
@@ -0,0 +1,400 @@
+#include <streamer/processor/ptz/ptzcache.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+namespace {
+
+class CacheHeader {
+public:
+	uint32_t magic_;
+	uint32_t version_;
+	uint32_t size_;
+	uint32_t checksum_;
+};
+
+class Writer {
+public:
+	Writer(std::string& out) : out_(out) {}
+
+	template<typename T>
+	void value(T v)
+	{
+		out_.append((const char*) &v, sizeof(v));
+	}
+
+	void string(const std::string& s)
+	{
+		value<uint32_t>((uint32_t) s.size());
+		out_.append(s);
+	}
+
+private:
+	std::string& out_;
+};
+
+class Reader {
+public:
+	Reader(const char* data, size_t size) : data_(data), size_(size), pos_(0), ok_(true) {}
+
+	template<typename T>
+	T value()
+	{
+		T v = T();
+		if (ok_ && pos_ + sizeof(T) <= size_) {
+			memcpy(&v, data_ + pos_, sizeof(T));
+			pos_ += sizeof(T);
+		} else {
+			ok_ = false;
+		}
+		return v;
+	}
+
+	std::string string()
+	{
+		uint32_t len = value<uint32_t>();
+		if (ok_ && pos_ + len <= size_) {
+			std::string s(data_ + pos_, len);
+			pos_ += len;
+			return s;
+		}
+		ok_ = false;
+		return std::string();
+	}
+
+	// True once every byte was consumed without running past the end
+	bool ok() const { return ok_ && pos_ == size_; }
+
+	bool failed() const { return !ok_; }
+
+private:
+	const char* data_;
+	size_t size_;
+	size_t pos_;
+	bool ok_;
+};
+
+void write_profile(Writer& w, const ProfileData& p)
+{
+	w.value<int32_t>(p.x_);
+	w.value<int32_t>(p.y_);
+	w.value<int32_t>(p.rate_limit_);
+	w.value<int32_t>(p.encoding_interval_);
+	w.value<int32_t>(p.bitrate_limit_);
+	w.string(p.codec_);
+	w.string(p.name_);
+	w.string(p.token_);
+	w.string(p.video_src_token_);
+	w.value<uint8_t>(p.abs_focus_);
+	w.value<uint8_t>(p.rel_focus_);
+	w.value<uint8_t>(p.cont_focus_);
+	w.value<uint32_t>(p.ptz_timeout_ms_);
+}
+
+void read_profile(Reader& r, ProfileData& p)
+{
+	p.x_ = r.value<int32_t>();
+	p.y_ = r.value<int32_t>();
+	p.rate_limit_ = r.value<int32_t>();
+	p.encoding_interval_ = r.value<int32_t>();
+	p.bitrate_limit_ = r.value<int32_t>();
+	p.codec_ = r.string();
+	p.name_ = r.string();
+	p.token_ = r.string();
+	p.video_src_token_ = r.string();
+	p.abs_focus_ = r.value<uint8_t>() != 0;
+	p.rel_focus_ = r.value<uint8_t>() != 0;
+	p.cont_focus_ = r.value<uint8_t>() != 0;
+	p.ptz_timeout_ms_ = r.value<uint32_t>();
+}
+
+void write_axis_map(Writer& w, const AxisMap& map)
+{
+	w.value<uint32_t>(map.points());
+	for (uint32_t i = 0; i < map.points(); i++) {
+		float raw = 0, value = 0;
+		map.point(i, raw, value);
+		w.value<float>(raw);
+		w.value<float>(value);
+	}
+}
+
+bool read_axis_map(Reader& r, AxisMap& map)
+{
+	map.clear();
+	uint32_t points = r.value<uint32_t>();
+	for (uint32_t i = 0; i < points && !r.failed(); i++) {
+		float raw = r.value<float>();
+		float value = r.value<float>();
+		if (!map.add(raw, value))
+			return false;
+	}
+	return !r.failed();
+}
+
+}
+
+PtzCache::PtzCache(const std::string& directory /*= default_directory()*/)
+	: directory_(directory)
+{
+}
+
+std::string PtzCache::default_directory()
+{
+	const char* dir = getenv("ORION_PTZ_CACHE_DIR");
+	return (dir && *dir) ? dir : "/var/cache/orion/ptz";
+}
+
+std::string PtzCache::path(const std::string& key, const char* extension /*= ".ptzc"*/) const
+{
+	std::string name;
+	for (size_t i = 0; i < key.size(); i++) {
+		char c = key[i];
+		name += (isalnum((unsigned char) c) || c == '-' || c == '.') ? c : '_';
+	}
+
+	return directory_ + "/" + name + extension;
+}
+
+bool PtzCache::load(const std::string& key, OnvifDeviceConfig& config) const
+{
+	return read_file(path(key), [&](const char* payload, size_t size) {
+		OnvifDeviceConfig cached;
+		if (!deserialize(payload, size, cached))
+			return false;
+		config = cached;
+		return true;
+	});
+}
+
+bool PtzCache::store(const std::string& key, const OnvifDeviceConfig& config) const
+{
+	std::string payload;
+	serialize(config, payload);
+	return write_file(path(key), payload);
+}
+
+bool PtzCache::load_calibration(const std::string& key, PtzCalibration& calibration) const
+{
+	return read_file(path(key, ".ptzcal"), [&](const char* payload, size_t size) {
+		PtzCalibration cached;
+		if (!deserialize(payload, size, cached))
+			return false;
+		calibration = cached;
+		return true;
+	});
+}
+
+bool PtzCache::store_calibration(const std::string& key, const PtzCalibration& calibration) const
+{
+	std::string payload;
+	serialize(calibration, payload);
+	return write_file(path(key, ".ptzcal"), payload);
+}
+
+bool PtzCache::remove_calibration(const std::string& key) const
+{
+	return (unlink(path(key, ".ptzcal").c_str()) == 0);
+}
+
+bool PtzCache::read_file(const std::string& file, const std::function<bool(const char*, size_t)>& parse) const
+{
+	bool ret = false;
+
+	int fd = open(file.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) == 0 && (size_t) st.st_size >= sizeof(CacheHeader)) {
+		void* map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (map != MAP_FAILED) {
+			const char* data = (const char*) map;
+			CacheHeader header;
+			memcpy(&header, data, sizeof(header));
+
+			const char* payload = data + sizeof(header);
+			size_t size = st.st_size - sizeof(header);
+			if (header.magic_ == Magic && header.version_ == Version && header.size_ == size
+				&& header.checksum_ == checksum(payload, size))
+				ret = parse(payload, size);
+
+			munmap(map, st.st_size);
+		}
+	}
+
+	close(fd);
+	return ret;
+}
+
+bool PtzCache::write_file(const std::string& file, const std::string& payload) const
+{
+	CacheHeader header;
+	header.magic_ = Magic;
+	header.version_ = Version;
+	header.size_ = (uint32_t) payload.size();
+	header.checksum_ = checksum(payload.data(), payload.size());
+
+	// Create missing parent directories
+	for (size_t pos = directory_.find('/', 1); ; pos = directory_.find('/', pos + 1)) {
+		std::string dir = directory_.substr(0, pos);
+		if (mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+			return false;
+		if (std::string::npos == pos)
+			break;
+	}
+
+	std::string tmp = file + ".tmp." + std::to_string(getpid());
+
+	int fd = open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+	if (fd < 0)
+		return false;
+
+	bool ret = (write(fd, &header, sizeof(header)) == (ssize_t) sizeof(header))
+		&& (write(fd, payload.data(), payload.size()) == (ssize_t) payload.size());
+	ret = (close(fd) == 0) && ret;
+
+	if (ret)
+		ret = (rename(tmp.c_str(), file.c_str()) == 0);
+	if (!ret)
+		unlink(tmp.c_str());
+
+	return ret;
+}
+
+bool PtzCache::remove(const std::string& key) const
+{
+	return (unlink(path(key).c_str()) == 0);
+}
+
+void PtzCache::serialize(const OnvifDeviceConfig& config, std::string& out)
+{
+	Writer w(out);
+
+	w.string(config.firmware_);
+	w.string(config.media_url_);
+	w.string(config.ptz_url_);
+	w.string(config.imaging_url_);
+
+	w.value<uint32_t>((uint32_t) config.profiles_.size());
+	for (size_t i = 0; i < config.profiles_.size(); i++)
+		write_profile(w, config.profiles_[i]);
+	write_profile(w, config.profile_data_);
+
+	const PTZDetails& details = config.ptz_details_;
+	w.value<uint8_t>(details.home_support_);
+	w.value<uint8_t>(details.fixed_home_pos_);
+	w.value<int32_t>(details.max_preset_);
+	w.value<uint32_t>((uint32_t) details.ptz_axis_.size());
+	for (size_t i = 0; i < details.ptz_axis_.size(); i++) {
+		const AxisDetails& axis = details.ptz_axis_[i];
+		w.string(axis.name_);
+		w.string(axis.uri_);
+		w.value<float>(axis.fx_min_);
+		w.value<float>(axis.fx_max_);
+		w.value<float>(axis.fy_min_);
+		w.value<float>(axis.fy_max_);
+	}
+}
+
+bool PtzCache::deserialize(const char* data, size_t size, OnvifDeviceConfig& config)
+{
+	Reader r(data, size);
+
+	config.firmware_ = r.string();
+	config.media_url_ = r.string();
+	config.ptz_url_ = r.string();
+	config.imaging_url_ = r.string();
+
+	uint32_t profiles = r.value<uint32_t>();
+	for (uint32_t i = 0; i < profiles && !r.failed(); i++) {
+		ProfileData profile;
+		read_profile(r, profile);
+		config.profiles_.push_back(profile);
+	}
+	read_profile(r, config.profile_data_);
+
+	PTZDetails& details = config.ptz_details_;
+	details.home_support_ = r.value<uint8_t>() != 0;
+	details.fixed_home_pos_ = r.value<uint8_t>() != 0;
+	details.max_preset_ = r.value<int32_t>();
+	uint32_t axes = r.value<uint32_t>();
+	for (uint32_t i = 0; i < axes && !r.failed(); i++) {
+		std::string name = r.string();
+		std::string uri = r.string();
+		float fx_min = r.value<float>();
+		float fx_max = r.value<float>();
+		float fy_min = r.value<float>();
+		float fy_max = r.value<float>();
+		details.ptz_axis_.push_back(AxisDetails(name.c_str(), uri.c_str(), fx_min, fx_max, fy_min, fy_max));
+	}
+
+	return r.ok() && !config.profiles_.empty();
+}
+
+void PtzCache::serialize(const PtzCalibration& calibration, std::string& out)
+{
+	Writer w(out);
+
+	const FovModel& fov = calibration.fov_;
+	w.value<float>(fov.wide_hfov());
+	w.value<float>(fov.tele_hfov());
+	w.value<float>(fov.aspect());
+	w.value<uint32_t>(fov.samples());
+	for (uint32_t i = 0; i < fov.samples(); i++) {
+		float zoom = 0, hfov = 0;
+		fov.sample(i, zoom, hfov);
+		w.value<float>(zoom);
+		w.value<float>(hfov);
+	}
+
+	write_axis_map(w, calibration.pan_);
+	write_axis_map(w, calibration.tilt_);
+	write_axis_map(w, calibration.zoom_);
+	w.value<uint8_t>(calibration.calibrated_);
+}
+
+bool PtzCache::deserialize(const char* data, size_t size, PtzCalibration& calibration)
+{
+	Reader r(data, size);
+
+	float wide = r.value<float>();
+	float tele = r.value<float>();
+	float aspect = r.value<float>();
+	calibration.fov_.set(wide, tele, aspect);
+	calibration.fov_.clear_samples();
+	uint32_t samples = r.value<uint32_t>();
+	for (uint32_t i = 0; i < samples && !r.failed(); i++) {
+		float zoom = r.value<float>();
+		float hfov = r.value<float>();
+		if (!calibration.fov_.add_sample(zoom, hfov))
+			return false;
+	}
+
+	bool ok = read_axis_map(r, calibration.pan_) && read_axis_map(r, calibration.tilt_) && read_axis_map(r, calibration.zoom_);
+	calibration.calibrated_ = r.value<uint8_t>() != 0;
+
+	return ok && r.ok();
+}
+
+uint32_t PtzCache::checksum(const char* data, size_t size)
+{
+	// FNV-1a
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < size; i++) {
+		hash ^= (uint8_t) data[i];
+		hash *= 16777619u;
+	}
+	return hash;
+}
+
+}}}
@@ -0,0 +1,62 @@
+#pragma once
+#include <string>
+#include <functional>
+#include <streamer/processor/ptz/ptzdetails.h>
+#include <streamer/processor/ptz/ptzcalibration.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+// On-disk cache of OnvifDeviceConfig, one file per camera. Files are versioned
+// and checksummed binary images read through mmap, written atomically through
+// a temporary file and rename. Entries carry the firmware they were discovered
+// with so a firmware update invalidates them. Calibrations are kept in files of
+// their own since they outlive firmware updates.
+class PtzCache {
+public:
+	enum {
+		Magic = 0x5a54504f,	// "OPTZ"
+		Version = 2
+	};
+
+	PtzCache(const std::string& directory = default_directory());
+
+	bool load(const std::string& key, OnvifDeviceConfig& config) const;
+
+	bool store(const std::string& key, const OnvifDeviceConfig& config) const;
+
+	bool remove(const std::string& key) const;
+
+	bool load_calibration(const std::string& key, PtzCalibration& calibration) const;
+
+	bool store_calibration(const std::string& key, const PtzCalibration& calibration) const;
+
+	bool remove_calibration(const std::string& key) const;
+
+	// $ORION_PTZ_CACHE_DIR or /var/cache/orion/ptz
+	static std::string default_directory();
+
+private:
+
+	std::string path(const std::string& key, const char* extension = ".ptzc") const;
+
+	// Maps file and hands a verified payload to parse
+	bool read_file(const std::string& file, const std::function<bool(const char*, size_t)>& parse) const;
+
+	bool write_file(const std::string& file, const std::string& payload) const;
+
+	static void serialize(const OnvifDeviceConfig& config, std::string& out);
+
+	static bool deserialize(const char* data, size_t size, OnvifDeviceConfig& config);
+
+	static void serialize(const PtzCalibration& calibration, std::string& out);
+
+	static bool deserialize(const char* data, size_t size, PtzCalibration& calibration);
+
+	static uint32_t checksum(const char* data, size_t size);
+
+	std::string directory_;
+};
+
+}}}
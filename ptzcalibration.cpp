@@ -0,0 +1,272 @@
+#include <streamer/processor/ptz/ptzcalibration.h>
+#include <math.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+AxisMap::AxisMap()
+	: points_(0)
+{
+}
+
+void AxisMap::linear(float raw0, float value0, float raw1, float value1)
+{
+	clear();
+	add(raw0, value0);
+	add(raw1, value1);
+}
+
+bool AxisMap::add(float raw, float value)
+{
+	if (points_ >= MaxPoints || !isfinite(raw) || !isfinite(value))
+		return false;
+
+	uint32_t i = points_;
+	while (i > 0 && raw_[i - 1] > raw) {
+		raw_[i] = raw_[i - 1];
+		value_[i] = value_[i - 1];
+		i--;
+	}
+	raw_[i] = raw;
+	value_[i] = value;
+	points_++;
+	return true;
+}
+
+void AxisMap::point(uint32_t i, float& raw, float& value) const
+{
+	raw = raw_[i];
+	value = value_[i];
+}
+
+float AxisMap::to_value(float raw) const
+{
+	if (points_ < 2)
+		return points_ ? value_[0] : raw;
+
+	// The outer segments extend past the first and last point
+	uint32_t i = 1;
+	while (i < points_ - 1 && raw > raw_[i])
+		i++;
+
+	float span = raw_[i] - raw_[i - 1];
+	if (span == 0)
+		return value_[i];
+	return value_[i - 1] + (raw - raw_[i - 1]) / span * (value_[i] - value_[i - 1]);
+}
+
+float AxisMap::to_raw(float value) const
+{
+	if (points_ < 2)
+		return points_ ? raw_[0] : value;
+
+	bool increasing = value_[points_ - 1] >= value_[0];
+	uint32_t i = 1;
+	while (i < points_ - 1 && (increasing ? value > value_[i] : value < value_[i]))
+		i++;
+
+	float span = value_[i] - value_[i - 1];
+	if (span == 0)
+		return raw_[i];
+	return raw_[i - 1] + (value - value_[i - 1]) / span * (raw_[i] - raw_[i - 1]);
+}
+
+void AxisMap::scale(float factor)
+{
+	for (uint32_t i = 0; i < points_; i++)
+		value_[i] *= factor;
+}
+
+void AxisMap::limits(float& low, float& high) const
+{
+	low = high = 0;
+	if (points_) {
+		low = fminf(value_[0], value_[points_ - 1]);
+		high = fmaxf(value_[0], value_[points_ - 1]);
+	}
+}
+
+PtzCalibration::PtzCalibration()
+	: calibrated_(false)
+{
+}
+
+void PtzCalibration::set_limits(const AxisScale& pan_tilt, const AxisScale& zoom)
+{
+	// -180 at the camera minimum and +180 at its maximum, as AxisConversion
+	if (pan_tilt.valid_ && pan_tilt.fx_min_ != pan_tilt.fx_max_)
+		pan_.linear(pan_tilt.fx_min_, -180, pan_tilt.fx_max_, 180);
+	if (pan_tilt.valid_ && pan_tilt.fy_min_ != pan_tilt.fy_max_)
+		tilt_.linear(pan_tilt.fy_min_, -180, pan_tilt.fy_max_, 180);
+	if (zoom.valid_ && zoom.fx_min_ != zoom.fx_max_)
+		zoom_.linear(zoom.fx_min_, 0, zoom.fx_max_, 1);
+
+	calibrated_ = false;
+}
+
+void PtzCalibration::pixel_to_ptz(float x, float y, float pan_raw, float tilt_raw, float zoom_raw, float& pan, float& tilt) const
+{
+	float pan_degree = pan_.to_value(pan_raw);
+	float tilt_degree = tilt_.to_value(tilt_raw);
+
+	float pan_delta = 0, tilt_delta = 0;
+	fov_.center(x, y, zoom_.to_value(zoom_raw), tilt_degree, pan_delta, tilt_delta);
+
+	pan = pan_.to_raw(wrap_pan(pan_degree + pan_delta));
+	tilt = tilt_.to_raw(tilt_degree + tilt_delta);
+}
+
+bool PtzCalibration::ptz_to_pixel(float pan, float tilt, float pan_raw, float tilt_raw, float zoom_raw, float& x, float& y) const
+{
+	float pan_degree = pan_.to_value(pan_raw);
+	float tilt_degree = tilt_.to_value(tilt_raw);
+
+	// The short way around
+	float pan_delta = pan_.to_value(pan) - pan_degree;
+	if (pan_delta > 180)
+		pan_delta -= 360;
+	else if (pan_delta < -180)
+		pan_delta += 360;
+
+	return fov_.project(pan_delta, tilt_.to_value(tilt) - tilt_degree, zoom_.to_value(zoom_raw), tilt_degree, x, y);
+}
+
+float PtzCalibration::wrap_pan(float degree) const
+{
+	float low = 0, high = 0;
+	pan_.limits(low, high);
+	if (high - low < 359)
+		return degree;
+
+	if (degree > high)
+		degree -= 360;
+	else if (degree < low)
+		degree += 360;
+	return degree;
+}
+
+PtzCalibrator::PtzCalibrator(uint32_t zoom_steps /*= 8*/)
+	: zoom_steps_(zoom_steps)
+{
+}
+
+bool PtzCalibrator::run(CalibrationProbe& probe, float pan, float tilt, PtzCalibration& calibration) const
+{
+	PtzCalibration result = calibration;
+	result.fov_.clear_samples();
+
+	// Pan and tilt scale from steps of a quarter of the known wide field of
+	// view. The feature moves against the camera, center() tells by how much.
+	// The camera tilt enters center() as well, so measure again with the
+	// corrected one until the scale settles.
+	float wide = result.zoom_.to_raw(0);
+	for (int pass = 0; pass < 8; pass++) {
+		float before_pan = 0, before_tilt = 0, after_pan = 0, after_tilt = 0;
+		if (!probe.move(pan, tilt, wide) || !locate(probe, result, tilt, wide, before_pan, before_tilt))
+			return false;
+
+		float pan_degree = result.pan_.to_value(pan);
+		float pan_step = result.pan_.to_raw(pan_degree + result.fov_.hfov(0) / 4) - pan;
+		if (!probe.move(pan + pan_step, tilt, wide) || !locate(probe, result, tilt, wide, after_pan, after_tilt))
+			return false;
+		float pan_scale = (before_pan - after_pan) / (result.pan_.to_value(pan + pan_step) - pan_degree);
+
+		float tilt_degree = result.tilt_.to_value(tilt);
+		float tilt_step = result.tilt_.to_raw(tilt_degree + result.fov_.vfov(0) / 4) - tilt;
+		if (!probe.move(pan, tilt + tilt_step, wide) || !locate(probe, result, tilt + tilt_step, wide, after_pan, after_tilt))
+			return false;
+		float tilt_scale = (before_tilt - after_tilt) / (result.tilt_.to_value(tilt + tilt_step) - tilt_degree);
+
+		if (!isfinite(pan_scale) || fabsf(pan_scale) < 0.01f || !isfinite(tilt_scale) || fabsf(tilt_scale) < 0.01f)
+			return false;
+		result.pan_.scale(pan_scale);
+		result.tilt_.scale(tilt_scale);
+		if (fabsf(pan_scale - 1) < 0.001f && fabsf(tilt_scale - 1) < 0.001f)
+			break;
+	}
+
+	// Field of view at evenly spaced zoom positions, each step sized from the
+	// samples taken so far
+	uint32_t steps = (zoom_steps_ < 1) ? 1 : ((zoom_steps_ > FovModel::MaxSamples - 1) ? FovModel::MaxSamples - 1 : zoom_steps_);
+	for (uint32_t i = 0; i <= steps; i++) {
+		float position = (float) i / steps;
+		float zoom = result.zoom_.to_raw(position);
+		if (!probe.move(pan, tilt, zoom) || !center(probe, result, pan, tilt, zoom))
+			return false;
+
+		float pan_degree = result.pan_.to_value(pan);
+		float tilt_degree = result.tilt_.to_value(tilt);
+		float angle = result.fov_.hfov(position) / 4;
+		float x = 0, y = 0;
+		if (!probe.move(result.pan_.to_raw(pan_degree + angle), tilt, zoom) || !probe.locate(x, y))
+			return false;
+
+		float hfov = solve_hfov(x, y, tilt_degree, result.fov_.aspect(), angle);
+		if (!(hfov > 0))
+			return false;
+		result.fov_.add_sample(position, hfov);
+	}
+
+	// Leave the camera at wide zoom on the feature
+	probe.move(pan, tilt, wide);
+
+	result.calibrated_ = true;
+	calibration = result;
+	return true;
+}
+
+bool PtzCalibrator::locate(CalibrationProbe& probe, const PtzCalibration& calibration, float tilt, float zoom, float& pan_delta, float& tilt_delta)
+{
+	float x = 0, y = 0;
+	if (!probe.locate(x, y))
+		return false;
+
+	calibration.fov_.center(x, y, calibration.zoom_.to_value(zoom), calibration.tilt_.to_value(tilt), pan_delta, tilt_delta);
+	return true;
+}
+
+bool PtzCalibrator::center(CalibrationProbe& probe, const PtzCalibration& calibration, float& pan, float& tilt, float zoom)
+{
+	for (int attempt = 0; attempt < 4; attempt++) {
+		float x = 0, y = 0;
+		if (!probe.locate(x, y))
+			return false;
+		if (fabsf(x) < 0.01f && fabsf(y) < 0.01f)
+			return true;
+
+		float next_pan = 0, next_tilt = 0;
+		calibration.pixel_to_ptz(x, y, pan, tilt, zoom, next_pan, next_tilt);
+		if (!probe.move(next_pan, next_tilt, zoom))
+			return false;
+		pan = next_pan;
+		tilt = next_tilt;
+	}
+
+	// Close enough for the steps taken from here
+	float x = 0, y = 0;
+	return probe.locate(x, y) && fabsf(x) < 0.05f && fabsf(y) < 0.05f;
+}
+
+float PtzCalibrator::solve_hfov(float x, float y, float tilt, float aspect, float pan_step)
+{
+	if (fabsf(x) < 0.001f)
+		return 0;
+
+	// A wider field of view puts the same image point further away
+	float low = 0.1f, high = 179.0f;
+	for (int i = 0; i < 40; i++) {
+		float hfov = (low + high) / 2;
+		FovModel model(hfov, hfov, aspect);
+		float pan_delta = 0, tilt_delta = 0;
+		model.center(x, y, 0, tilt, pan_delta, tilt_delta);
+		if (fabsf(pan_delta) < pan_step)
+			low = hfov;
+		else
+			high = hfov;
+	}
+
+	return (low + high) / 2;
+}
+
+}}}
@@ -0,0 +1,123 @@
+#pragma once
+#include <stdint.h>
+#include <streamer/processor/ptz/fovmodel.h>
+#include <streamer/processor/ptz/ptzdetails.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+// Piecewise linear map of camera values to physical units, extrapolated past
+// the first and last point. Values must be monotonic in the camera value,
+// either direction. Fixed size, copies never allocate.
+class AxisMap {
+public:
+	enum {
+		MaxPoints = 16
+	};
+
+	AxisMap();
+
+	// Straight line through two points, replaces all points
+	void linear(float raw0, float value0, float raw1, float value1);
+
+	// False when full
+	bool add(float raw, float value);
+
+	void clear() { points_ = 0; }
+
+	uint32_t points() const { return points_; }
+
+	void point(uint32_t i, float& raw, float& value) const;
+
+	float to_value(float raw) const;
+
+	float to_raw(float value) const;
+
+	// Multiplies all values, the camera value mapped to 0 stays put
+	void scale(float factor);
+
+	// Values at the first and last point
+	void limits(float& low, float& high) const;
+
+private:
+	// Sorted by camera value
+	float raw_[MaxPoints];
+	float value_[MaxPoints];
+	uint32_t points_;
+};
+
+// Per camera mapping between image points and camera pan/tilt values. Pan and
+// tilt map to degrees, zoom to the 0 (wide) - 1 (tele) position of fov_.
+// Without calibration the maps follow the axis limits as AxisConversion does
+// and fov_ the datasheet. Fixed size so it can be published through a SeqLock.
+class PtzCalibration {
+public:
+	FovModel fov_;
+	AxisMap pan_;
+	AxisMap tilt_;
+	AxisMap zoom_;
+
+	// Set once PtzCalibrator measured fov_ and the pan/tilt scale
+	bool calibrated_;
+
+	PtzCalibration();
+
+	// Default maps from the absolute (or relative) space limits of the camera
+	void set_limits(const AxisScale& pan_tilt, const AxisScale& zoom);
+
+	// Camera pan/tilt that brings image point x, y (-1 to 1, y downwards) to
+	// the center when the camera is at pan_raw, tilt_raw, zoom_raw
+	void pixel_to_ptz(float x, float y, float pan_raw, float tilt_raw, float zoom_raw, float& pan, float& tilt) const;
+
+	// Image point of camera direction pan, tilt seen from pan_raw, tilt_raw,
+	// zoom_raw. False when it is outside the image.
+	bool ptz_to_pixel(float pan, float tilt, float pan_raw, float tilt_raw, float zoom_raw, float& x, float& y) const;
+
+private:
+	// Pan degree brought back into the mapped range of a full turn camera
+	float wrap_pan(float degree) const;
+};
+
+// Camera access of PtzCalibrator, an OnvifControl for a real device or
+// bench::SimulatedCamera
+class CalibrationProbe {
+public:
+	virtual ~CalibrationProbe() {}
+
+	// Absolute move in camera values, returns once the camera stopped
+	virtual bool move(float pan, float tilt, float zoom) = 0;
+
+	// Image point of the reference feature, false when it is not visible
+	virtual bool locate(float& x, float& y) = 0;
+};
+
+// Measures the pan/tilt scale and the field of view over the zoom range by
+// stepping the camera and watching a fixed feature move in the image. The
+// horizontal field of view at wide zoom in calibration.fov_ is the reference,
+// take it from the datasheet. Only the scale of pan and tilt is measured, the
+// camera values of 0 degrees are kept from the limits.
+class PtzCalibrator {
+public:
+	// zoom_steps + 1 zoom positions are measured, at most FovModel::MaxSamples
+	PtzCalibrator(uint32_t zoom_steps = 8);
+
+	// Starts at camera values pan, tilt with the feature near the image center.
+	// calibration is only changed on success.
+	bool run(CalibrationProbe& probe, float pan, float tilt, PtzCalibration& calibration) const;
+
+private:
+	// Pan and tilt change that centers the feature according to calibration
+	static bool locate(CalibrationProbe& probe, const PtzCalibration& calibration, float tilt, float zoom, float& pan_delta, float& tilt_delta);
+
+	// Moves until the feature is centered, updates pan and tilt
+	static bool center(CalibrationProbe& probe, const PtzCalibration& calibration, float& pan, float& tilt, float zoom);
+
+	// Horizontal field of view for which the model puts a feature seen at x, y
+	// pan_step degrees away, constant focal length
+	static float solve_hfov(float x, float y, float tilt, float aspect, float pan_step);
+
+	uint32_t zoom_steps_;
+};
+
+}}}
@@ -0,0 +1,133 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+class ProfileData {
+public:
+	int x_;
+	int y_;
+	int rate_limit_;
+	int encoding_interval_;
+	int bitrate_limit_;
+
+	std::string codec_;
+	std::string name_;
+	std::string token_;
+	std::string video_src_token_;
+
+	bool abs_focus_;
+	bool rel_focus_;
+	bool cont_focus_;
+
+	// DefaultPTZTimeout of the PTZ configuration, 0 when the device does not
+	// report one and may ignore the Timeout of ContinuousMove
+	uint32_t ptz_timeout_ms_;
+
+	ProfileData()
+		:x_(0)
+		,y_(0)
+		,rate_limit_(0)
+		,encoding_interval_(0)
+		,bitrate_limit_(0)
+		,abs_focus_(false)
+		,rel_focus_(false)
+		,cont_focus_(false)
+		,ptz_timeout_ms_(0)
+		{
+		}
+};
+
+class AxisDetails {
+public:
+	std::string name_;
+	std::string uri_;
+
+	float fx_min_;
+	float fx_max_;
+	float fy_min_;
+	float fy_max_;
+
+        AxisDetails() {}
+
+	AxisDetails(const char* name, const char* uri, float fx_min, float fx_max, float fy_min, float fy_max)
+		: name_(name ? name : "")
+		, uri_(uri ? uri : "")
+		, fx_min_(fx_min)
+		, fx_max_(fx_max)
+		, fy_min_(fy_min)
+		, fy_max_(fy_max)
+	{
+	}
+};
+
+enum AxisSpace {
+	AbsPT = 0,
+	RelPT,
+	AbsZ,
+	RelZ,
+	ContPT,
+	ContZ,
+	AxisSpaceCount
+};
+
+// Limits of one PTZ space with the derived ranges, resolved once per camera
+// so commands index a table instead of searching ptz_axis_ by name
+class AxisScale {
+public:
+	bool valid_;
+
+	float fx_min_;
+	float fx_max_;
+	float fy_min_;
+	float fy_max_;
+
+	float x_range_;
+	float y_range_;
+
+	AxisScale()
+		: valid_(false)
+		, fx_min_(0)
+		, fx_max_(0)
+		, fy_min_(0)
+		, fy_max_(0)
+		, x_range_(0)
+		, y_range_(0)
+	{
+	}
+};
+
+class PTZDetails {
+public:
+	std::vector<AxisDetails> ptz_axis_;
+	bool home_support_;
+	bool fixed_home_pos_;
+	int max_preset_;
+
+	// Indexed by AxisSpace, built from ptz_axis_ by OnvifControl
+	AxisScale axis_table_[AxisSpaceCount];
+
+	PTZDetails(): home_support_(false), fixed_home_pos_(false), max_preset_(0)
+	{
+	}
+};
+
+// Everything OnvifControl learns from the device during initialization
+class OnvifDeviceConfig {
+public:
+	std::string firmware_;
+
+	std::string media_url_;
+	std::string ptz_url_;
+	std::string imaging_url_;
+
+	std::vector<ProfileData> profiles_;
+	ProfileData profile_data_;
+
+	PTZDetails ptz_details_;
+};
+
+}}}
@@ -0,0 +1,403 @@
+#include <streamer/processor/ptz/ptzdispatcher.h>
+#include <streamer/processor/ptz/coalescer.h>
+#include <algorithm>
+#include <sys/prctl.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+namespace {
+
+// Worker the current thread belongs to, used to keep rescheduled queues local
+thread_local const void* worker_owner = nullptr;
+thread_local size_t worker_index = 0;
+
+}
+
+PtzDispatcher::PtzDispatcher(size_t workers /*= 0*/, common::Logger::logger_t shared_logger /*= common::Logger::logger_t()*/)
+	: worker_count_(0)
+	, elastic_(!workers)
+	, ready_(0)
+	, next_worker_(0)
+	, stop_(false)
+	, logger_(shared_logger)
+{
+	logger()->trace("PtzDispatcher::{} workers = {} (entry)", __func__, workers);
+
+	// Slots are allocated up front, running workers index them without a lock
+	workers_.resize(elastic_ ? (size_t) MaxWorkers : workers);
+
+	std::lock_guard<std::mutex> lock(cameras_mutex_);
+	grow(elastic_ ? 1 : workers);
+
+	logger()->trace("PtzDispatcher::{} (exit)", __func__);
+}
+
+PtzDispatcher::~PtzDispatcher()
+{
+	stop();
+}
+
+void PtzDispatcher::stop()
+{
+	logger()->trace("PtzDispatcher::{} (entry)", __func__);
+
+	if (!stop_.exchange(true)) {
+		{
+			std::lock_guard<std::mutex> lock(idle_mutex_);
+		}
+		idle_cv_.notify_all();
+
+		// grow() checks stop_ under cameras_mutex_, no worker starts after this
+		{
+			std::lock_guard<std::mutex> lock(cameras_mutex_);
+		}
+
+		size_t count = worker_count_;
+		for (size_t i = 0; i < count; i++) {
+			if (workers_[i]->thread_.joinable())
+				workers_[i]->thread_.join();
+		}
+
+		std::vector<queue_ptr_t> queues;
+		{
+			std::lock_guard<std::mutex> lock(cameras_mutex_);
+			for (std::map<std::string, queue_ptr_t>::iterator it = cameras_.begin(); it != cameras_.end(); ++it)
+				queues.push_back(it->second);
+		}
+		for (size_t i = 0; i < queues.size(); i++)
+			drain(queues[i]);
+	}
+
+	logger()->trace("PtzDispatcher::{} (exit)", __func__);
+}
+
+bool PtzDispatcher::add_camera(const std::string& name, const control_ptr_t& control)
+{
+	logger()->trace("PtzDispatcher::{} name = {} (entry)", __func__, name);
+	bool ret = false;
+
+	queue_ptr_t queue;
+	if (control.get()) {
+		std::lock_guard<std::mutex> lock(cameras_mutex_);
+		if (cameras_.find(name) == cameras_.end()) {
+			queue = std::make_shared<CameraQueue>(name, control);
+			cameras_[name] = queue;
+			if (elastic_)
+				grow(cameras_.size());
+			ret = true;
+		}
+	}
+
+	// Commands the camera queues itself (position refresh) join the same queue
+	if (queue.get()) {
+		std::weak_ptr<CameraQueue> weak = queue;
+		control->set_async_router([this, weak](const data_ptr_t& data, const CameraControl::callback_t& callback) {
+			queue_ptr_t routed = weak.lock();
+			return routed.get() && !stop_ && enqueue(routed, data, callback);
+		});
+	}
+
+	logger()->trace("PtzDispatcher::{} ret = {} (exit)", __func__, ret);
+	return ret;
+}
+
+bool PtzDispatcher::remove_camera(const std::string& name)
+{
+	logger()->trace("PtzDispatcher::{} name = {} (entry)", __func__, name);
+
+	queue_ptr_t queue;
+	{
+		std::lock_guard<std::mutex> lock(cameras_mutex_);
+		std::map<std::string, queue_ptr_t>::iterator it = cameras_.find(name);
+		if (it != cameras_.end()) {
+			queue = it->second;
+			cameras_.erase(it);
+		}
+	}
+
+	// Pending commands fail, a command already running completes
+	if (queue.get())
+		drain(queue);
+
+	logger()->trace("PtzDispatcher::{} ret = {} (exit)", __func__, queue.get() != nullptr);
+	return (queue.get() != nullptr);
+}
+
+PtzDispatcher::control_ptr_t PtzDispatcher::camera(const std::string& name)
+{
+	std::lock_guard<std::mutex> lock(cameras_mutex_);
+	std::map<std::string, queue_ptr_t>::iterator it = cameras_.find(name);
+	return (it != cameras_.end()) ? it->second->control_ : control_ptr_t();
+}
+
+bool PtzDispatcher::dispatch(const data_ptr_t& data, const CameraControl::callback_t& callback /*= CameraControl::callback_t()*/)
+{
+	if (!data.get() || stop_)
+		return false;
+
+	queue_ptr_t queue;
+	{
+		std::lock_guard<std::mutex> lock(cameras_mutex_);
+		std::map<std::string, queue_ptr_t>::iterator it = cameras_.find(data->camera_name);
+		if (it != cameras_.end())
+			queue = it->second;
+	}
+
+	if (!queue.get()) {
+		logger()->error("PtzDispatcher::{} unknown camera = {}", __func__, data->camera_name);
+		return false;
+	}
+
+	return enqueue(queue, data, callback);
+}
+
+bool PtzDispatcher::enqueue(const queue_ptr_t& queue, const data_ptr_t& data, const CameraControl::callback_t& callback)
+{
+	bool schedule_queue = false;
+	{
+		std::lock_guard<std::mutex> lock(queue->mutex_);
+		if (queue->removed_)
+			return false;
+
+		bool merged = false;
+		if (!queue->commands_.empty()) {
+			// Queued commands keep their enqueue time, both callbacks see the merged command
+			Command& pending = queue->commands_.back();
+			Data combined = *pending.data_;
+			if (CommandCoalescer::merge(combined, *data)) {
+				pending.data_ = std::make_shared<Data>(combined);
+				pending.merged_ = true;
+				if (callback) {
+					CameraControl::callback_t previous = pending.callback_;
+					pending.callback_ = [previous, callback](const data_ptr_t& command, const ControlResult& result) {
+						if (previous)
+							previous(command, result);
+						callback(command, result);
+					};
+				}
+				queue->coalesced_++;
+				merged = true;
+			}
+		}
+
+		if (!merged) {
+			Command command;
+			command.data_ = data;
+			command.callback_ = callback;
+			command.enqueued_ = clock_t::now();
+			queue->commands_.push_back(command);
+
+			if (queue->commands_.size() > queue->max_depth_)
+				queue->max_depth_ = queue->commands_.size();
+		}
+
+		if (!queue->scheduled_) {
+			queue->scheduled_ = true;
+			schedule_queue = true;
+		}
+	}
+
+	if (schedule_queue)
+		schedule(queue);
+
+	return true;
+}
+
+void PtzDispatcher::drain(const queue_ptr_t& queue)
+{
+	queue->control_->set_async_router(CameraControl::router_t());
+
+	std::deque<Command> dropped;
+	{
+		std::lock_guard<std::mutex> lock(queue->mutex_);
+		queue->removed_ = true;
+		dropped.swap(queue->commands_);
+	}
+
+	for (size_t i = 0; i < dropped.size(); i++) {
+		if (dropped[i].callback_)
+			dropped[i].callback_(dropped[i].data_, ControlResult());
+	}
+}
+
+void PtzDispatcher::schedule(const queue_ptr_t& queue)
+{
+	size_t index;
+	if (worker_owner == this)
+		index = worker_index;
+	else
+		index = next_worker_++ % worker_count_;
+
+	{
+		std::lock_guard<std::mutex> lock(workers_[index]->mutex_);
+		workers_[index]->ready_.push_back(queue);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(idle_mutex_);
+		ready_++;
+	}
+	idle_cv_.notify_one();
+}
+
+bool PtzDispatcher::next(size_t index, queue_ptr_t& queue)
+{
+	// Own deque first (oldest ready camera), then steal the newest from others
+	{
+		Worker& own = *workers_[index];
+		std::lock_guard<std::mutex> lock(own.mutex_);
+		if (!own.ready_.empty()) {
+			queue = own.ready_.front();
+			own.ready_.pop_front();
+		}
+	}
+
+	size_t count = worker_count_;
+	for (size_t i = 1; !queue.get() && i < count; i++) {
+		Worker& victim = *workers_[(index + i) % count];
+		std::lock_guard<std::mutex> lock(victim.mutex_);
+		if (!victim.ready_.empty()) {
+			queue = victim.ready_.back();
+			victim.ready_.pop_back();
+		}
+	}
+
+	if (queue.get())
+		ready_--;
+
+	return (queue.get() != nullptr);
+}
+
+void PtzDispatcher::run_one(const queue_ptr_t& queue)
+{
+	Command command;
+	bool found = false;
+	{
+		std::lock_guard<std::mutex> lock(queue->mutex_);
+		if (!queue->commands_.empty()) {
+			command = queue->commands_.front();
+			queue->commands_.pop_front();
+			found = true;
+		}
+	}
+
+	if (found) {
+		queue->wait_us_.record(std::chrono::duration_cast<std::chrono::microseconds>(clock_t::now() - command.enqueued_).count());
+
+		// Merged moves that cancel out never reach the camera
+		ControlResult result;
+		if (command.merged_ && CommandCoalescer::noop(*command.data_)) {
+			result.success_ = true;
+			result.send_response_ = true;
+		} else {
+			result = queue->control_->execute(command.data_);
+		}
+		queue->processed_++;
+
+		if (command.callback_)
+			command.callback_(command.data_, result);
+	}
+
+	// One command per turn so a busy camera does not starve the others
+	bool reschedule = false;
+	{
+		std::lock_guard<std::mutex> lock(queue->mutex_);
+		if (!queue->commands_.empty() && !queue->removed_)
+			reschedule = true;
+		else
+			queue->scheduled_ = false;
+	}
+
+	if (reschedule)
+		schedule(queue);
+}
+
+void PtzDispatcher::grow(size_t workers)
+{
+	size_t count = worker_count_;
+	workers = std::min(workers, workers_.size());
+	if (stop_ || count >= workers)
+		return;
+
+	logger()->debug("PtzDispatcher::{} workers = {}", __func__, workers);
+
+	// A worker is complete before the count makes it visible to the others
+	for (size_t i = count; i < workers; i++) {
+		workers_[i].reset(new Worker());
+		workers_[i]->thread_ = std::thread(&PtzDispatcher::run, this, i);
+		worker_count_ = i + 1;
+	}
+}
+
+void PtzDispatcher::run(size_t index)
+{
+	std::string name = std::string("ptz-dispatch-") + std::to_string(index);
+	prctl(PR_SET_NAME, name.substr(0, 15).c_str(), 0, 0, 0);
+
+	worker_owner = this;
+	worker_index = index;
+
+	while (!stop_) {
+		queue_ptr_t queue;
+		if (next(index, queue)) {
+			run_one(queue);
+		} else {
+			std::unique_lock<std::mutex> lock(idle_mutex_);
+			idle_cv_.wait_for(lock, std::chrono::milliseconds(100), [this] { return stop_ || ready_ > 0; });
+		}
+	}
+
+	worker_owner = nullptr;
+}
+
+bool PtzDispatcher::stats(const std::string& name, DispatcherQueueStats& stats)
+{
+	queue_ptr_t queue;
+	{
+		std::lock_guard<std::mutex> lock(cameras_mutex_);
+		std::map<std::string, queue_ptr_t>::iterator it = cameras_.find(name);
+		if (it != cameras_.end())
+			queue = it->second;
+	}
+
+	if (!queue.get())
+		return false;
+
+	{
+		std::lock_guard<std::mutex> lock(queue->mutex_);
+		stats.depth_ = queue->commands_.size();
+		stats.max_depth_ = queue->max_depth_;
+	}
+
+	uint64_t count = queue->wait_us_.count();
+	stats.processed_ = queue->processed_;
+	stats.coalesced_ = queue->coalesced_;
+	stats.mean_wait_us_ = count ? queue->wait_us_.sum() / count : 0;
+	stats.p99_wait_us_ = queue->wait_us_.percentile(99);
+	stats.max_wait_us_ = queue->wait_us_.max();
+
+	return true;
+}
+
+std::map<std::string, DispatcherQueueStats> PtzDispatcher::stats()
+{
+	std::vector<std::string> names;
+	{
+		std::lock_guard<std::mutex> lock(cameras_mutex_);
+		for (std::map<std::string, queue_ptr_t>::iterator it = cameras_.begin(); it != cameras_.end(); ++it)
+			names.push_back(it->first);
+	}
+
+	std::map<std::string, DispatcherQueueStats> ret;
+	for (size_t i = 0; i < names.size(); i++) {
+		DispatcherQueueStats queue_stats;
+		if (stats(names[i], queue_stats))
+			ret[names[i]] = queue_stats;
+	}
+
+	return ret;
+}
+
+}}}
@@ -0,0 +1,171 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <streamer/common/logger.h>
+#include <streamer/processor/ptz/cameracontrol.h>
+#include <streamer/processor/ptz/histogram.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+class DispatcherQueueStats {
+public:
+	uint64_t depth_;
+	uint64_t max_depth_;
+	uint64_t processed_;
+	uint64_t coalesced_;
+	uint64_t mean_wait_us_;
+	uint64_t p99_wait_us_;
+	uint64_t max_wait_us_;
+
+	DispatcherQueueStats()
+		: depth_(0)
+		, max_depth_(0)
+		, processed_(0)
+		, coalesced_(0)
+		, mean_wait_us_(0)
+		, p99_wait_us_(0)
+		, max_wait_us_(0)
+	{
+	}
+};
+
+// Owns the CameraControl instances of a process and runs their commands on a
+// shared pool of workers. Each camera has a FIFO queue that is executed by at
+// most one worker at a time, so commands of one camera keep their order while
+// different cameras run in parallel. Joystick moves still waiting in a queue
+// are merged by CommandCoalescer. Ready camera queues are distributed over
+// per worker deques and idle workers steal from busy ones. control_async() of
+// an added camera is routed into the same queue. Commands dropped by
+// remove_camera() or stop() complete with a failed result.
+//
+// A worker blocks for the whole SOAP exchange of a command, move polls
+// included. With workers = 0 the pool grows to one worker per added camera,
+// so a camera never waits for a slow one. A fixed count shares the workers.
+class PtzDispatcher {
+public:
+	typedef std::shared_ptr<CameraControl> control_ptr_t;
+
+	enum {
+		// Upper bound of the pool that grows with the cameras
+		MaxWorkers = 256
+	};
+
+	PtzDispatcher(size_t workers = 0, common::Logger::logger_t shared_logger = common::Logger::logger_t());
+
+	~PtzDispatcher();
+
+	bool add_camera(const std::string& name, const control_ptr_t& control);
+
+	bool remove_camera(const std::string& name);
+
+	control_ptr_t camera(const std::string& name);
+
+	// Queue a command for the camera named data->camera_name
+	bool dispatch(const data_ptr_t& data, const CameraControl::callback_t& callback = CameraControl::callback_t());
+
+	bool stats(const std::string& name, DispatcherQueueStats& stats);
+
+	std::map<std::string, DispatcherQueueStats> stats();
+
+	void stop();
+
+	spdlog::logger* logger() { return (logger_.get() != nullptr)? logger_.get() : common::get_debug_logger(); }
+
+private:
+	typedef std::chrono::steady_clock clock_t;
+
+	class Command {
+	public:
+		data_ptr_t data_;
+		CameraControl::callback_t callback_;
+		clock_t::time_point enqueued_;
+
+		// Coalesced from several commands
+		bool merged_;
+
+		Command()
+			: merged_(false)
+		{
+		}
+	};
+
+	class CameraQueue {
+	public:
+		std::string name_;
+		control_ptr_t control_;
+
+		std::mutex mutex_;
+		std::deque<Command> commands_;
+		bool scheduled_;
+		bool removed_;
+
+		uint64_t max_depth_;
+		std::atomic<uint64_t> processed_;
+		std::atomic<uint64_t> coalesced_;
+		Histogram wait_us_;
+
+		CameraQueue(const std::string& name, const control_ptr_t& control)
+			: name_(name)
+			, control_(control)
+			, scheduled_(false)
+			, removed_(false)
+			, max_depth_(0)
+			, processed_(0)
+			, coalesced_(0)
+		{
+		}
+	};
+
+	typedef std::shared_ptr<CameraQueue> queue_ptr_t;
+
+	class Worker {
+	public:
+		std::mutex mutex_;
+		std::deque<queue_ptr_t> ready_;
+		std::thread thread_;
+	};
+
+	bool enqueue(const queue_ptr_t& queue, const data_ptr_t& data, const CameraControl::callback_t& callback);
+
+	// Detaches the camera and fails its pending commands
+	void drain(const queue_ptr_t& queue);
+
+	void schedule(const queue_ptr_t& queue);
+
+	bool next(size_t index, queue_ptr_t& queue);
+
+	void run_one(const queue_ptr_t& queue);
+
+	void run(size_t index);
+
+	// With cameras_mutex_ held
+	void grow(size_t workers);
+
+	// Slots for the largest pool, the first worker_count_ are running
+	std::vector<std::unique_ptr<Worker> > workers_;
+	std::atomic<size_t> worker_count_;
+	bool elastic_;
+
+	std::mutex cameras_mutex_;
+	std::map<std::string, queue_ptr_t> cameras_;
+
+	std::mutex idle_mutex_;
+	std::condition_variable idle_cv_;
+	std::atomic<size_t> ready_;
+	std::atomic<size_t> next_worker_;
+	std::atomic<bool> stop_;
+
+	common::Logger::logger_t logger_;
+};
+
+}}}
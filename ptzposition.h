@@ -0,0 +1,57 @@
+#pragma once
+#include <chrono>
+#include <stdint.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+// Last known camera position, published after every GetStatus reply
+class PtzPosition {
+public:
+	// NVR values, degrees for pan/tilt and percent for zoom
+	float pan_;
+	float tilt_;
+	float zoom_;
+
+	// Camera values
+	float pan_raw_;
+	float tilt_raw_;
+	float zoom_raw_;
+
+	// OnvifControl::Status of the reply
+	int32_t status_;
+
+	// Set when a move was issued after this position was read
+	bool stale_;
+
+	// steady_clock time of the reply in microseconds, 0 if never read
+	int64_t timestamp_us_;
+
+	PtzPosition()
+		: pan_(0)
+		, tilt_(0)
+		, zoom_(0)
+		, pan_raw_(0)
+		, tilt_raw_(0)
+		, zoom_raw_(0)
+		, status_(0)
+		, stale_(true)
+		, timestamp_us_(0)
+	{
+	}
+
+	bool valid() const { return timestamp_us_ != 0; }
+
+	static int64_t now_us()
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	uint32_t age_ms() const
+	{
+		return valid() ? (uint32_t) ((now_us() - timestamp_us_) / 1000) : UINT32_MAX;
+	}
+};
+
+}}}
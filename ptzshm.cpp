@@ -0,0 +1,158 @@
+#include <streamer/processor/ptz/ptzshm.h>
+#include <new>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+PtzSharedState::PtzSharedState()
+	: segment_(NULL)
+	, owner_(false)
+{
+}
+
+PtzSharedState::~PtzSharedState()
+{
+	close();
+}
+
+std::string PtzSharedState::name(const std::string& camera)
+{
+	std::string ret("/orion-ptz-");
+	for (size_t i = 0; i < camera.size(); i++)
+		ret += (camera[i] == '/') ? '_' : camera[i];
+	return ret;
+}
+
+bool PtzSharedState::create(const std::string& camera)
+{
+	close();
+
+	std::string shm_name = name(camera);
+	int fd = shm_open(shm_name.c_str(), O_CREAT | O_RDWR, 0644);
+	if (fd < 0)
+		return false;
+
+	bool ret = false;
+	if (!ftruncate(fd, sizeof(PtzShmSegment))) {
+		void* addr = mmap(NULL, sizeof(PtzShmSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+		if (MAP_FAILED != addr) {
+			// Readers check magic_ last, so it is cleared while the layout is rebuilt
+			PtzShmSegment* segment = (PtzShmSegment*) addr;
+			__atomic_store_n(&segment->magic_, 0, __ATOMIC_RELEASE);
+			segment = new (addr) PtzShmSegment();
+			segment->version_ = PtzShmSegment::Version;
+			segment->size_ = sizeof(PtzShmSegment);
+			strncpy(segment->camera_, camera.c_str(), sizeof(segment->camera_) - 1);
+			__atomic_store_n(&segment->magic_, (uint32_t) PtzShmSegment::Magic, __ATOMIC_RELEASE);
+
+			segment_ = segment;
+			name_ = shm_name;
+			owner_ = true;
+			ret = true;
+		}
+	}
+
+	::close(fd);
+	return ret;
+}
+
+bool PtzSharedState::attach(const std::string& camera)
+{
+	close();
+
+	std::string shm_name = name(camera);
+	int fd = shm_open(shm_name.c_str(), O_RDONLY, 0);
+	if (fd < 0)
+		return false;
+
+	bool ret = false;
+	struct stat st;
+	if (!fstat(fd, &st) && st.st_size >= (off_t) sizeof(PtzShmSegment)) {
+		void* addr = mmap(NULL, sizeof(PtzShmSegment), PROT_READ, MAP_SHARED, fd, 0);
+		if (MAP_FAILED != addr) {
+			PtzShmSegment* segment = (PtzShmSegment*) addr;
+			if (PtzShmSegment::Magic == __atomic_load_n(&segment->magic_, __ATOMIC_ACQUIRE)
+				&& PtzShmSegment::Version == segment->version_
+				&& sizeof(PtzShmSegment) == segment->size_) {
+				segment_ = segment;
+				name_ = shm_name;
+				owner_ = false;
+				ret = true;
+			} else {
+				munmap(addr, sizeof(PtzShmSegment));
+			}
+		}
+	}
+
+	::close(fd);
+	return ret;
+}
+
+void PtzSharedState::close()
+{
+	if (!segment_)
+		return;
+
+	// Readers still attached see the segment as gone
+	if (owner_)
+		__atomic_store_n(&segment_->magic_, 0, __ATOMIC_RELEASE);
+
+	munmap(segment_, sizeof(PtzShmSegment));
+	if (owner_)
+		shm_unlink(name_.c_str());
+
+	segment_ = NULL;
+	name_.clear();
+	owner_ = false;
+}
+
+void PtzSharedState::publish(const PtzPosition& position)
+{
+	if (segment_ && owner_)
+		segment_->position_.store(position);
+}
+
+void PtzSharedState::publish(const std::map<std::string, CameraPreset>& presets)
+{
+	if (!segment_ || !owner_)
+		return;
+
+	PtzShmPresets shm;
+	memset(&shm, 0, sizeof(shm));
+
+	std::map<std::string, CameraPreset>::const_iterator it;
+	for (it = presets.begin(); it != presets.end() && shm.count_ < PtzShmPresets::Capacity; ++it) {
+		PtzShmPreset& preset = shm.entries_[shm.count_++];
+		strncpy(preset.token_, it->second.token_.c_str(), sizeof(preset.token_) - 1);
+		strncpy(preset.name_, it->second.name_.c_str(), sizeof(preset.name_) - 1);
+		preset.x_ = it->second.x_;
+		preset.y_ = it->second.y_;
+		preset.z_ = it->second.z_;
+	}
+
+	segment_->presets_.store(shm);
+}
+
+bool PtzSharedState::position(PtzPosition& position) const
+{
+	if (!segment_ || PtzShmSegment::Magic != __atomic_load_n(&segment_->magic_, __ATOMIC_ACQUIRE))
+		return false;
+
+	return segment_->position_.try_load(position, ReadAttempts);
+}
+
+bool PtzSharedState::presets(PtzShmPresets& presets) const
+{
+	if (!segment_ || PtzShmSegment::Magic != __atomic_load_n(&segment_->magic_, __ATOMIC_ACQUIRE))
+		return false;
+
+	return segment_->presets_.try_load(presets, ReadAttempts);
+}
+
+}}}
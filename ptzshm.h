@@ -0,0 +1,97 @@
+#pragma once
+#include <map>
+#include <string>
+#include <stdint.h>
+#include <streamer/processor/ptz/preset.h>
+#include <streamer/processor/ptz/ptzposition.h>
+#include <streamer/processor/ptz/seqlock.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+class PtzShmPreset {
+public:
+	char token_[32];
+	char name_[32];
+	float x_;
+	float y_;
+	float z_;
+};
+
+class PtzShmPresets {
+public:
+	enum {
+		Capacity = 64
+	};
+
+	uint32_t count_;
+	PtzShmPreset entries_[Capacity];
+};
+
+// Layout of the shared segment. Each record sits on its own cache line and is
+// published through a seqlock, readers in other processes copy it without
+// syscalls once the segment is mapped. Fields are only ever appended and
+// version_ is raised whenever the layout changes.
+class PtzShmSegment {
+public:
+	enum {
+		Magic = 0x5a54504d,	// "MPTZ"
+		Version = 1
+	};
+
+	uint32_t magic_;
+	uint32_t version_;
+	uint32_t size_;
+	uint32_t reserved_;
+	char camera_[48];
+
+	alignas(64) SeqLock<PtzPosition> position_;
+
+	alignas(64) SeqLock<PtzShmPresets> presets_;
+};
+
+// Per camera POSIX shared memory segment named /orion-ptz-<camera>. The control
+// process opens it for writing, consumers attach read only.
+class PtzSharedState {
+public:
+	PtzSharedState();
+
+	~PtzSharedState();
+
+	// Create (or take over) the segment of camera, writer side
+	bool create(const std::string& camera);
+
+	// Map an existing segment read only, fails on a layout mismatch
+	bool attach(const std::string& camera);
+
+	void close();
+
+	bool is_open() const { return segment_ != NULL; }
+
+	void publish(const PtzPosition& position);
+
+	void publish(const std::map<std::string, CameraPreset>& presets);
+
+	// False when the writer closed the segment or a store did not finish
+	// within ReadAttempts tries
+	bool position(PtzPosition& position) const;
+
+	bool presets(PtzShmPresets& presets) const;
+
+	static std::string name(const std::string& camera);
+
+private:
+	enum {
+		ReadAttempts = 4096
+	};
+
+	PtzSharedState(const PtzSharedState&);
+	PtzSharedState& operator=(const PtzSharedState&);
+
+	PtzShmSegment* segment_;
+	std::string name_;
+	bool owner_;
+};
+
+}}}
@@ -0,0 +1,14 @@
+#pragma once
+
+// Trace points of the PTZ control path. Building with ORION_PTZ_TRACE=0 removes
+// them entirely, otherwise the arguments are only evaluated when the calling
+// object's trace_enabled() returns true.
+#ifndef ORION_PTZ_TRACE
+#define ORION_PTZ_TRACE 1
+#endif
+
+#if ORION_PTZ_TRACE
+#define PTZ_TRACE(...) do { if (trace_enabled()) logger()->trace(__VA_ARGS__); } while (0)
+#else
+#define PTZ_TRACE(...) do { } while (0)
+#endif
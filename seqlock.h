@@ -0,0 +1,85 @@
+#pragma once
+#include <atomic>
+#include <string.h>
+#include <stdint.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+// Single value published by writers and read without locks. Readers retry while
+// a write is in progress, so T must be trivially copyable and small. Writers are
+// serialized among themselves by the odd sequence number.
+template<typename T>
+class SeqLock {
+public:
+	SeqLock() : seq_(0)
+	{
+		T value = T();
+		write(value);
+	}
+
+	void store(const T& value)
+	{
+		uint32_t seq = seq_.load(std::memory_order_relaxed);
+		while ((seq & 1) || !seq_.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire))
+			seq = seq_.load(std::memory_order_relaxed);
+
+		std::atomic_thread_fence(std::memory_order_release);
+		write(value);
+		seq_.store(seq + 2, std::memory_order_release);
+	}
+
+	T load() const
+	{
+		T value;
+		while (!try_load(value, 0xffffffff))
+			;
+		return value;
+	}
+
+	// Gives up after attempts reads that overlapped a write. A writer in another
+	// process can die halfway through a store and leave the sequence odd for good.
+	bool try_load(T& value, uint32_t attempts) const
+	{
+		uint32_t words[Words];
+
+		for (uint32_t attempt = 0; attempt < attempts; attempt++) {
+			uint32_t seq = seq_.load(std::memory_order_acquire);
+			if (seq & 1)
+				continue;
+
+			for (int i = 0; i < Words; i++)
+				words[i] = words_[i].load(std::memory_order_relaxed);
+
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (seq_.load(std::memory_order_relaxed) == seq) {
+				memcpy(&value, words, sizeof(T));
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Incremented by two on every store
+	uint32_t version() const { return seq_.load(std::memory_order_acquire); }
+
+private:
+	enum {
+		Words = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t)
+	};
+
+	void write(const T& value)
+	{
+		uint32_t words[Words] = { 0 };
+		memcpy(words, &value, sizeof(T));
+		for (int i = 0; i < Words; i++)
+			words_[i].store(words[i], std::memory_order_relaxed);
+	}
+
+	std::atomic<uint32_t> seq_;
+	std::atomic<uint32_t> words_[Words];
+};
+
+}}}
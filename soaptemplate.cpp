@@ -0,0 +1,157 @@
+#include <streamer/processor/ptz/soaptemplate.h>
+#include <stdio.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+static const char* envelope_begin =
+	"<?xml version=\"1.0\" encoding=\"UTF-8\"?>"
+	"<SOAP-ENV:Envelope xmlns:SOAP-ENV=\"http://www.w3.org/2003/05/soap-envelope\""
+	" xmlns:tt=\"http://www.onvif.org/ver10/schema\""
+	" xmlns:tptz=\"http://www.onvif.org/ver20/ptz/wsdl\">"
+	"<SOAP-ENV:Header>%h</SOAP-ENV:Header><SOAP-ENV:Body>";
+
+static const char* envelope_end = "</SOAP-ENV:Body></SOAP-ENV:Envelope>";
+
+static const char* actions[PtzTemplates::RequestCount] = {
+	"http://www.onvif.org/ver20/ptz/wsdl/GetStatus",
+	"http://www.onvif.org/ver20/ptz/wsdl/Stop",
+	"http://www.onvif.org/ver20/ptz/wsdl/Stop",
+	"http://www.onvif.org/ver20/ptz/wsdl/AbsoluteMove",
+	"http://www.onvif.org/ver20/ptz/wsdl/AbsoluteMove",
+	"http://www.onvif.org/ver20/ptz/wsdl/RelativeMove",
+	"http://www.onvif.org/ver20/ptz/wsdl/ContinuousMove",
+	"http://www.onvif.org/ver20/ptz/wsdl/ContinuousMove",
+	"http://www.onvif.org/ver20/ptz/wsdl/AbsoluteMove",
+	"http://www.onvif.org/ver20/ptz/wsdl/ContinuousMove",
+	"http://www.onvif.org/ver20/ptz/wsdl/ContinuousMove"
+};
+
+static const char* responses[PtzTemplates::RequestCount] = {
+	"tptz:GetStatusResponse",
+	"tptz:StopResponse",
+	"tptz:StopResponse",
+	"tptz:AbsoluteMoveResponse",
+	"tptz:AbsoluteMoveResponse",
+	"tptz:RelativeMoveResponse",
+	"tptz:ContinuousMoveResponse",
+	"tptz:ContinuousMoveResponse",
+	"tptz:AbsoluteMoveResponse",
+	"tptz:ContinuousMoveResponse",
+	"tptz:ContinuousMoveResponse"
+};
+
+void SoapTemplate::compile(const std::string& pattern)
+{
+	literals_.clear();
+	slots_.clear();
+	values_ = 0;
+
+	std::string literal;
+	for (size_t i = 0; i < pattern.size(); i++) {
+		if (pattern[i] == '%' && i + 1 < pattern.size() && (pattern[i + 1] == 'h' || pattern[i + 1] == 'f')) {
+			literals_.push_back(literal);
+			literal.clear();
+			if (pattern[i + 1] == 'h') {
+				slots_.push_back(SlotHeader);
+			} else {
+				slots_.push_back((int) values_);
+				values_++;
+			}
+			i++;
+		} else {
+			literal += pattern[i];
+		}
+	}
+
+	literals_.push_back(literal);
+	slots_.push_back(SlotEnd);
+}
+
+void SoapTemplate::render(const std::string& header, const float* values, size_t count, std::string& out) const
+{
+	out.clear();
+
+	for (size_t i = 0; i < literals_.size(); i++) {
+		out += literals_[i];
+
+		int slot = slots_[i];
+		if (SlotHeader == slot) {
+			out += header;
+		} else if (slot >= 0) {
+			// Same precision gSOAP uses for xsd:float
+			char number[32];
+			int len = snprintf(number, sizeof(number), "%.9G", ((size_t) slot < count) ? values[slot] : 0.0f);
+			out.append(number, len);
+		}
+	}
+}
+
+void PtzTemplates::build(const std::string& profile_token)
+{
+	clear();
+	if (profile_token.empty())
+		return;
+
+	std::string token;
+	escape(profile_token, token);
+	token_ = profile_token;
+
+	std::string begin = std::string(envelope_begin);
+	std::string profile = std::string("<tptz:ProfileToken>") + token + "</tptz:ProfileToken>";
+
+	templates_[GetStatus].compile(begin + "<tptz:GetStatus>" + profile + "</tptz:GetStatus>" + envelope_end);
+	templates_[StopPanTilt].compile(begin + "<tptz:Stop>" + profile + "<tptz:PanTilt>true</tptz:PanTilt><tptz:Zoom>false</tptz:Zoom></tptz:Stop>" + envelope_end);
+	templates_[StopZoom].compile(begin + "<tptz:Stop>" + profile + "<tptz:PanTilt>false</tptz:PanTilt><tptz:Zoom>true</tptz:Zoom></tptz:Stop>" + envelope_end);
+	templates_[AbsoluteMovePanTilt].compile(begin + "<tptz:AbsoluteMove>" + profile
+		+ "<tptz:Position><tt:PanTilt x=\"%f\" y=\"%f\"/></tptz:Position></tptz:AbsoluteMove>" + envelope_end);
+	templates_[AbsoluteMoveZoom].compile(begin + "<tptz:AbsoluteMove>" + profile
+		+ "<tptz:Position><tt:Zoom x=\"%f\"/></tptz:Position></tptz:AbsoluteMove>" + envelope_end);
+	templates_[RelativeMove].compile(begin + "<tptz:RelativeMove>" + profile
+		+ "<tptz:Translation><tt:PanTilt x=\"%f\" y=\"%f\"/><tt:Zoom x=\"%f\"/></tptz:Translation></tptz:RelativeMove>" + envelope_end);
+	templates_[ContinuousMovePanTilt].compile(begin + "<tptz:ContinuousMove>" + profile
+		+ "<tptz:Velocity><tt:PanTilt x=\"%f\" y=\"%f\"/></tptz:Velocity></tptz:ContinuousMove>" + envelope_end);
+	templates_[ContinuousMoveZoom].compile(begin + "<tptz:ContinuousMove>" + profile
+		+ "<tptz:Velocity><tt:Zoom x=\"%f\"/></tptz:Velocity></tptz:ContinuousMove>" + envelope_end);
+	templates_[AbsoluteMovePanTiltZoom].compile(begin + "<tptz:AbsoluteMove>" + profile
+		+ "<tptz:Position><tt:PanTilt x=\"%f\" y=\"%f\"/><tt:Zoom x=\"%f\"/></tptz:Position></tptz:AbsoluteMove>" + envelope_end);
+	// Timeout is an xs:duration in seconds, e.g. "PT1.5S"
+	templates_[ContinuousMovePanTiltTimeout].compile(begin + "<tptz:ContinuousMove>" + profile
+		+ "<tptz:Velocity><tt:PanTilt x=\"%f\" y=\"%f\"/></tptz:Velocity><tptz:Timeout>PT%fS</tptz:Timeout></tptz:ContinuousMove>" + envelope_end);
+	templates_[ContinuousMoveZoomTimeout].compile(begin + "<tptz:ContinuousMove>" + profile
+		+ "<tptz:Velocity><tt:Zoom x=\"%f\"/></tptz:Velocity><tptz:Timeout>PT%fS</tptz:Timeout></tptz:ContinuousMove>" + envelope_end);
+}
+
+void PtzTemplates::clear()
+{
+	token_.clear();
+	for (int i = 0; i < RequestCount; i++)
+		templates_[i] = SoapTemplate();
+}
+
+const char* PtzTemplates::action(Request request)
+{
+	return actions[request];
+}
+
+const char* PtzTemplates::response(Request request)
+{
+	return responses[request];
+}
+
+void PtzTemplates::escape(const std::string& text, std::string& out)
+{
+	for (size_t i = 0; i < text.size(); i++) {
+		switch (text[i]) {
+			case '&': out += "&amp;"; break;
+			case '<': out += "&lt;"; break;
+			case '>': out += "&gt;"; break;
+			case '"': out += "&quot;"; break;
+			case '\'': out += "&apos;"; break;
+			default: out += text[i]; break;
+		}
+	}
+}
+
+}}}
@@ -0,0 +1,80 @@
+#pragma once
+#include <string>
+#include <vector>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+// Envelope of one request with its variable parts cut out. The literal text is
+// split once by compile(), render() appends the pieces and the formatted values
+// into a caller owned buffer so a warm buffer is reused without allocating.
+class SoapTemplate {
+public:
+	SoapTemplate()
+		: values_(0)
+	{
+	}
+
+	// "%h" marks the SOAP header content, "%f" the next float value
+	void compile(const std::string& pattern);
+
+	bool empty() const { return literals_.empty(); }
+
+	size_t values() const { return values_; }
+
+	void render(const std::string& header, const float* values, size_t count, std::string& out) const;
+
+private:
+	enum {
+		SlotHeader = -1,
+		SlotEnd = -2
+	};
+
+	std::vector<std::string> literals_;
+	std::vector<int> slots_;
+	size_t values_;
+};
+
+// Per camera templates of the frequent PTZ requests, compiled for the selected
+// profile token. Requests not listed here always go through the gSOAP proxies.
+class PtzTemplates {
+public:
+	enum Request {
+		GetStatus = 0,
+		StopPanTilt,
+		StopZoom,
+		AbsoluteMovePanTilt,
+		AbsoluteMoveZoom,
+		RelativeMove,
+		ContinuousMovePanTilt,
+		ContinuousMoveZoom,
+		AbsoluteMovePanTiltZoom,
+		ContinuousMovePanTiltTimeout,
+		ContinuousMoveZoomTimeout,
+		RequestCount
+	};
+
+	void build(const std::string& profile_token);
+
+	void clear();
+
+	bool empty() const { return token_.empty(); }
+
+	const std::string& token() const { return token_; }
+
+	const SoapTemplate& get(Request request) const { return templates_[request]; }
+
+	static const char* action(Request request);
+
+	// Element name of the response, e.g. "tptz:GetStatusResponse"
+	static const char* response(Request request);
+
+	static void escape(const std::string& text, std::string& out);
+
+private:
+	std::string token_;
+	SoapTemplate templates_[RequestCount];
+};
+
+}}}
@@ -0,0 +1,278 @@
+#include <streamer/processor/ptz/statusparser.h>
+#include <stdlib.h>
+#include <string.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+static bool blank(char c)
+{
+	return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool equals(const char* name, size_t size, const char* literal)
+{
+	return size == strlen(literal) && !memcmp(name, literal, size);
+}
+
+// Strip the namespace prefix of [name, end)
+static const char* local_name(const char* name, const char* end)
+{
+	const char* colon = (const char*) memchr(name, ':', end - name);
+	return colon ? colon + 1 : name;
+}
+
+// Character data from p up to the next tag, surrounding blanks removed
+static bool text(const char* p, const char* end, const char*& begin, size_t& size)
+{
+	const char* next = (const char*) memchr(p, '<', end - p);
+	if (!next)
+		return false;
+
+	while (p < next && blank(*p))
+		p++;
+	while (next > p && blank(next[-1]))
+		next--;
+
+	begin = p;
+	size = next - p;
+	return true;
+}
+
+static int move_status(const char* text, size_t size)
+{
+	if (equals(text, size, "IDLE"))
+		return PtzStatusReply::Idle;
+	if (equals(text, size, "MOVING"))
+		return PtzStatusReply::Moving;
+	return PtzStatusReply::Unknown;
+}
+
+static const char* find(const char* p, const char* end, const char* literal)
+{
+	size_t size = strlen(literal);
+	for (; p + size <= end; p++) {
+		if (!memcmp(p, literal, size))
+			return p;
+	}
+	return NULL;
+}
+
+// Keep the innermost fault code, SOAP 1.2 Subcode/Value or SOAP 1.1 faultcode,
+// e.g. "ter:NotAuthorized"
+static void fault_code(const char* p, const char* end, PtzStatusReply& reply)
+{
+	while ((p = (const char*) memchr(p, '<', end - p)) != NULL) {
+		if (++p >= end || '/' == *p)
+			continue;
+
+		const char* name = p;
+		while (p < end && !blank(*p) && '>' != *p && '/' != *p)
+			p++;
+		const char* local = local_name(name, p);
+		size_t local_size = p - local;
+
+		p = (const char*) memchr(p, '>', end - p);
+		if (!p)
+			return;
+
+		const char* value = NULL;
+		size_t value_size = 0;
+		if ((equals(local, local_size, "Value") || equals(local, local_size, "faultcode")) && text(++p, end, value, value_size) && value_size)
+			reply.set_error(value, value_size);
+	}
+}
+
+int PtzStatusReply::status() const
+{
+	if ((has(PanTiltStatus) && Moving == pan_tilt_status_) || (has(ZoomStatus) && Moving == zoom_status_))
+		return Moving;
+	if ((has(PanTiltStatus) && Unknown == pan_tilt_status_) || (has(ZoomStatus) && Unknown == zoom_status_))
+		return Unknown;
+	return Idle;
+}
+
+void PtzStatusReply::set_error(const char* text, size_t size)
+{
+	if (size >= sizeof(error_))
+		size = sizeof(error_) - 1;
+	memcpy(error_, text, size);
+	error_[size] = '\0';
+	fields_ |= Error;
+}
+
+StatusParser::Result StatusParser::parse(const char* data, size_t size, PtzStatusReply& reply)
+{
+	enum Context {
+		Outside,
+		Status,
+		Position,
+		MoveStatus
+	};
+
+	reply.clear();
+
+	const char* p = data;
+	const char* end = data + size;
+	Context context = Outside;
+
+	while ((p = (const char*) memchr(p, '<', end - p)) != NULL) {
+		if (++p >= end)
+			return Malformed;
+
+		// XML declaration, comment or CDATA
+		if ('?' == *p || '!' == *p) {
+			const char* close = find(p, end, ('!' == *p && end - p > 2 && '-' == p[1] && '-' == p[2]) ? "-->" : ">");
+			if (!close)
+				return Malformed;
+			p = close + 1;
+			continue;
+		}
+
+		bool closing = ('/' == *p);
+		if (closing)
+			p++;
+
+		const char* name = p;
+		while (p < end && !blank(*p) && '>' != *p && '/' != *p)
+			p++;
+		const char* local = local_name(name, p);
+		size_t local_size = p - local;
+
+		// Only x and y are of interest, e.g. <tt:PanTilt x="0.5" y="-0.2" space="..."/>
+		float x = 0, y = 0;
+		bool has_x = false, has_y = false;
+		bool empty = false;
+		for (;;) {
+			while (p < end && blank(*p))
+				p++;
+			if (p >= end)
+				return Malformed;
+			if ('>' == *p) {
+				p++;
+				break;
+			}
+			if ('/' == *p) {
+				if (++p >= end || '>' != *p)
+					return Malformed;
+				p++;
+				empty = true;
+				break;
+			}
+
+			const char* attr = p;
+			while (p < end && !blank(*p) && '=' != *p && '>' != *p && '/' != *p)
+				p++;
+			const char* attr_local = local_name(attr, p);
+			size_t attr_size = p - attr_local;
+
+			while (p < end && blank(*p))
+				p++;
+			if (p >= end || '=' != *p)
+				return Malformed;
+			p++;
+			while (p < end && blank(*p))
+				p++;
+			if (p >= end || ('"' != *p && '\'' != *p))
+				return Malformed;
+
+			const char* close = (const char*) memchr(p + 1, *p, end - p - 1);
+			if (!close)
+				return Malformed;
+
+			// The closing quote ends the number
+			if (equals(attr_local, attr_size, "x")) {
+				x = strtof(p + 1, NULL);
+				has_x = true;
+			} else if (equals(attr_local, attr_size, "y")) {
+				y = strtof(p + 1, NULL);
+				has_y = true;
+			}
+			p = close + 1;
+		}
+
+		if (closing) {
+			if (Position == context && equals(local, local_size, "Position"))
+				context = Status;
+			else if (MoveStatus == context && equals(local, local_size, "MoveStatus"))
+				context = Status;
+			else if (Status == context && equals(local, local_size, "PTZStatus"))
+				return Ok;
+			continue;
+		}
+
+		const char* value = NULL;
+		size_t value_size = 0;
+
+		switch (context) {
+			case Outside:
+				if (equals(local, local_size, "PTZStatus")) {
+					if (empty)
+						return Ok;
+					context = Status;
+				} else if (equals(local, local_size, "Fault")) {
+					if (!empty)
+						fault_code(p, end, reply);
+					return Fault;
+				}
+				break;
+			case Status:
+				if (empty)
+					break;
+				if (equals(local, local_size, "Position")) {
+					context = Position;
+				} else if (equals(local, local_size, "MoveStatus")) {
+					context = MoveStatus;
+					// ONVIF 1.0 devices report one status for both axes as text
+					if (text(p, end, value, value_size) && value_size) {
+						reply.pan_tilt_status_ = reply.zoom_status_ = move_status(value, value_size);
+						reply.fields_ |= PtzStatusReply::PanTiltStatus | PtzStatusReply::ZoomStatus;
+					}
+				} else if (equals(local, local_size, "Error")) {
+					if (text(p, end, value, value_size) && value_size)
+						reply.set_error(value, value_size);
+				}
+				break;
+			case Position:
+				if (equals(local, local_size, "PanTilt") && has_x && has_y) {
+					reply.x_ = x;
+					reply.y_ = y;
+					reply.fields_ |= PtzStatusReply::PanTilt;
+				} else if (equals(local, local_size, "Zoom") && has_x) {
+					reply.z_ = x;
+					reply.fields_ |= PtzStatusReply::Zoom;
+				}
+				break;
+			case MoveStatus:
+				if (empty || !text(p, end, value, value_size))
+					break;
+				if (equals(local, local_size, "PanTilt")) {
+					reply.pan_tilt_status_ = move_status(value, value_size);
+					reply.fields_ |= PtzStatusReply::PanTiltStatus;
+				} else if (equals(local, local_size, "Zoom")) {
+					reply.zoom_status_ = move_status(value, value_size);
+					reply.fields_ |= PtzStatusReply::ZoomStatus;
+				}
+				break;
+		}
+	}
+
+	// Ran out of data inside PTZStatus or never saw it
+	return Malformed;
+}
+
+const char* StatusParser::to_str(Result result)
+{
+	switch (result) {
+		case Ok:
+			return "Ok";
+		case Fault:
+			return "Fault";
+		case Malformed:
+			return "Malformed";
+	}
+	return "Unknown";
+}
+
+}}}
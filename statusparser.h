@@ -0,0 +1,82 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+// Fields of one GetStatus reply, fields_ tells which elements were present
+class PtzStatusReply {
+public:
+	enum Field {
+		PanTilt = 1,
+		Zoom = 2,
+		PanTiltStatus = 4,
+		ZoomStatus = 8,
+		Error = 16
+	};
+
+	// Values of tt:MoveStatus, same as OnvifControl::Status
+	enum MoveStatus {
+		Idle = 0,
+		Moving = 1,
+		Unknown = 2
+	};
+
+	uint32_t fields_;
+
+	float x_;
+	float y_;
+	float z_;
+
+	int pan_tilt_status_;
+	int zoom_status_;
+
+	// Truncated, not unescaped. For a fault the fault code instead.
+	char error_[128];
+
+	PtzStatusReply()
+	{
+		clear();
+	}
+
+	void clear()
+	{
+		fields_ = 0;
+		x_ = y_ = z_ = 0;
+		pan_tilt_status_ = zoom_status_ = Unknown;
+		error_[0] = '\0';
+	}
+
+	bool has(Field field) const { return (fields_ & field) != 0; }
+
+	bool has_position() const { return (fields_ & (PanTilt | Zoom)) != 0; }
+
+	bool has_move_status() const { return (fields_ & (PanTiltStatus | ZoomStatus)) != 0; }
+
+	// Moving if any axis moves, Unknown if any axis is unknown, Idle otherwise
+	int status() const;
+
+	void set_error(const char* text, size_t size);
+};
+
+// Pulls Position, MoveStatus and Error of tt:PTZStatus out of a GetStatusResponse
+// envelope in a single pass over the buffer. Nothing is allocated, elements are
+// matched by local name so any namespace prefix the device picked is accepted.
+class StatusParser {
+public:
+	enum Result {
+		Ok = 0,
+		// The body is a SOAP fault
+		Fault,
+		// No PTZStatus element or a truncated document
+		Malformed
+	};
+
+	static Result parse(const char* data, size_t size, PtzStatusReply& reply);
+
+	static const char* to_str(Result result);
+};
+
+}}}
@@ -0,0 +1,107 @@
+#include <streamer/processor/ptz/trackingcontroller.h>
+#include <math.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+static float clamp(float value, float limit)
+{
+	return (value > limit) ? limit : ((value < -limit) ? -limit : value);
+}
+
+Pid::Pid(float kp, float ki, float kd, float limit)
+	: kp_(kp)
+	, ki_(ki)
+	, kd_(kd)
+	, limit_(limit)
+{
+	reset();
+}
+
+float Pid::update(float error, float dt)
+{
+	// Centered, stop the axis and start over with the next offset
+	if (error == 0) {
+		reset();
+		return 0;
+	}
+
+	if (!(dt > 0))
+		dt = 0;
+
+	// Derivative on the error, skipped for the first sample
+	float derivative = (!first_ && dt > 0) ? (error - previous_) / dt : 0;
+	first_ = false;
+	previous_ = error;
+
+	float output = kp_ * error + ki_ * integral_ + kd_ * derivative;
+
+	// Integrate only while not saturated so the integral does not wind up
+	if (fabsf(output) < limit_ && ki_ != 0) {
+		integral_ += error * dt;
+		integral_ = clamp(integral_, limit_ / ki_);
+	}
+
+	return clamp(output, limit_);
+}
+
+void Pid::reset()
+{
+	integral_ = 0;
+	previous_ = 0;
+	first_ = true;
+}
+
+TrackingController::TrackingController(const TrackingConfig& config)
+	: config_(config)
+	, pan_(config.kp_, config.ki_, config.kd_, config.max_velocity_)
+	, tilt_(config.kp_, config.ki_, config.kd_, config.max_velocity_)
+	, zoom_(config.zoom_kp_, config.zoom_ki_, config.zoom_kd_, config.max_velocity_)
+	, pan_velocity_(0)
+	, tilt_velocity_(0)
+	, zoom_velocity_(0)
+{
+}
+
+bool TrackingController::update(float x, float y, float zoom, float dt, float& pan_velocity, float& tilt_velocity, float& zoom_velocity)
+{
+	float pan = pan_.update(shape(x), dt);
+	// Positive tilt velocity moves up, towards a negative y offset
+	float tilt = tilt_.update(-shape(y), dt);
+	float zoom_speed = zoom_.update(shape(zoom), dt);
+
+	// Always send a change to or from standstill
+	bool changed = fabsf(pan - pan_velocity_) >= config_.min_delta_ || ((pan == 0) != (pan_velocity_ == 0))
+		|| fabsf(tilt - tilt_velocity_) >= config_.min_delta_ || ((tilt == 0) != (tilt_velocity_ == 0))
+		|| fabsf(zoom_speed - zoom_velocity_) >= config_.min_delta_ || ((zoom_speed == 0) != (zoom_velocity_ == 0));
+
+	if (changed) {
+		pan_velocity_ = pan;
+		tilt_velocity_ = tilt;
+		zoom_velocity_ = zoom_speed;
+	}
+
+	pan_velocity = pan_velocity_;
+	tilt_velocity = tilt_velocity_;
+	zoom_velocity = zoom_velocity_;
+	return changed;
+}
+
+void TrackingController::reset()
+{
+	pan_.reset();
+	tilt_.reset();
+	zoom_.reset();
+	pan_velocity_ = tilt_velocity_ = zoom_velocity_ = 0;
+}
+
+// Zero inside the deadband, continuous at its edge
+float TrackingController::shape(float error) const
+{
+	if (!isfinite(error) || fabsf(error) <= config_.deadband_)
+		return 0;
+	return (error > 0) ? error - config_.deadband_ : error + config_.deadband_;
+}
+
+}}}
@@ -0,0 +1,94 @@
+#pragma once
+#include <stdint.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+// PID on one axis, the output is a ContinuousMove velocity
+class Pid {
+public:
+	Pid(float kp = 0, float ki = 0, float kd = 0, float limit = 1);
+
+	// error in normalized image units, dt in seconds. A zero error stops the axis.
+	float update(float error, float dt);
+
+	void reset();
+
+private:
+	float kp_;
+	float ki_;
+	float kd_;
+	float limit_;
+	float integral_;
+	float previous_;
+	bool first_;
+};
+
+class TrackingConfig {
+public:
+	// Gains of pan/tilt and of zoom
+	float kp_;
+	float ki_;
+	float kd_;
+	float zoom_kp_;
+	float zoom_ki_;
+	float zoom_kd_;
+
+	// Offsets smaller than this count as centered
+	float deadband_;
+
+	// Largest velocity sent, 0 - 1
+	float max_velocity_;
+
+	// Velocity changes smaller than this are not sent
+	float min_delta_;
+
+	// Upper bound of ContinuousMove requests per second
+	uint32_t rate_hz_;
+
+	// Stop the camera when no target arrived for this long, also the camera
+	// side timeout of each ContinuousMove
+	uint32_t lost_ms_;
+
+	TrackingConfig()
+		: kp_(0.8f)
+		, ki_(0.1f)
+		, kd_(0.05f)
+		, zoom_kp_(0.5f)
+		, zoom_ki_(0)
+		, zoom_kd_(0)
+		, deadband_(0.03f)
+		, max_velocity_(1.0f)
+		, min_delta_(0.02f)
+		, rate_hz_(10)
+		, lost_ms_(500)
+	{
+	}
+};
+
+// Turns target offsets into pan/tilt/zoom velocities. Offsets are relative to
+// the frame center in -1 to 1, x grows to the right and y downwards. zoom is
+// the wanted zoom change, positive to zoom in.
+class TrackingController {
+public:
+	TrackingController(const TrackingConfig& config = TrackingConfig());
+
+	// Returns true when the velocities differ enough from the last ones to be sent
+	bool update(float x, float y, float zoom, float dt, float& pan_velocity, float& tilt_velocity, float& zoom_velocity);
+
+	void reset();
+
+private:
+	float shape(float error) const;
+
+	TrackingConfig config_;
+	Pid pan_;
+	Pid tilt_;
+	Pid zoom_;
+	float pan_velocity_;
+	float tilt_velocity_;
+	float zoom_velocity_;
+};
+
+}}}
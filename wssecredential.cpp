@@ -0,0 +1,128 @@
+#include <streamer/processor/ptz/wssecredential.h>
+#include <streamer/processor/ptz/soaptemplate.h>
+#include <string.h>
+#include <openssl/crypto.h>
+#include <openssl/evp.h>
+#include <openssl/rand.h>
+#include <openssl/sha.h>
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+WsseCredential::WsseCredential()
+	: sha_(NULL)
+	, pool_used_(PoolSize)
+	, created_time_(0)
+	, skew_(0)
+{
+	created_[0] = '\0';
+}
+
+WsseCredential::~WsseCredential()
+{
+	if (sha_)
+		EVP_MD_CTX_free(sha_);
+	OPENSSL_cleanse(pool_, sizeof(pool_));
+}
+
+void WsseCredential::header(const std::string& username, const std::string& password, std::string& out)
+{
+	out.clear();
+
+	std::lock_guard<std::mutex> lock(mutex_);
+
+	Token token;
+	if (!digest(username, password, token))
+		return;
+
+	out += prefix_;
+	out += token.digest_;
+	out += "</wsse:Password><wsse:Nonce EncodingType=\"http://docs.oasis-open.org/wss/2004/01/oasis-200401-wss-soap-message-security-1.0#Base64Binary\">";
+	out += token.nonce_;
+	out += "</wsse:Nonce><wsu:Created>";
+	out += token.created_;
+	out += "</wsu:Created></wsse:UsernameToken></wsse:Security>";
+}
+
+bool WsseCredential::token(const std::string& username, const std::string& password, Token& out)
+{
+	std::lock_guard<std::mutex> lock(mutex_);
+	return digest(username, password, out);
+}
+
+bool WsseCredential::digest(const std::string& username, const std::string& password, Token& out)
+{
+	if (username.empty())
+		return false;
+
+	if (username != username_ || password != password_ || prefix_.empty())
+		prepare(username, password);
+
+	if (!sha_ && !(sha_ = EVP_MD_CTX_new()))
+		return false;
+
+	unsigned char nonce_bytes[NonceSize];
+	if (!nonce(nonce_bytes))
+		return false;
+
+	const char* stamp = created();
+
+	// Digest = Base64(SHA1(nonce + created + password))
+	unsigned char digest[SHA_DIGEST_LENGTH];
+	bool hashed = EVP_DigestInit_ex(sha_, EVP_sha1(), NULL)
+		&& EVP_DigestUpdate(sha_, nonce_bytes, sizeof(nonce_bytes))
+		&& EVP_DigestUpdate(sha_, stamp, strlen(stamp))
+		&& EVP_DigestUpdate(sha_, password_.data(), password_.size())
+		&& EVP_DigestFinal_ex(sha_, digest, NULL);
+	if (!hashed)
+		return false;
+
+	EVP_EncodeBlock((unsigned char*) out.nonce_, nonce_bytes, sizeof(nonce_bytes));
+	EVP_EncodeBlock((unsigned char*) out.digest_, digest, sizeof(digest));
+	strncpy(out.created_, stamp, sizeof(out.created_) - 1);
+	out.created_[sizeof(out.created_) - 1] = '\0';
+	return true;
+}
+
+void WsseCredential::prepare(const std::string& username, const std::string& password)
+{
+	username_ = username;
+	password_ = password;
+
+	prefix_ = "<wsse:Security xmlns:wsse=\"http://docs.oasis-open.org/wss/2004/01/oasis-200401-wss-wssecurity-secext-1.0.xsd\""
+		" xmlns:wsu=\"http://docs.oasis-open.org/wss/2004/01/oasis-200401-wss-wssecurity-utility-1.0.xsd\""
+		" SOAP-ENV:mustUnderstand=\"true\"><wsse:UsernameToken><wsse:Username>";
+	PtzTemplates::escape(username, prefix_);
+	prefix_ += "</wsse:Username><wsse:Password Type=\"http://docs.oasis-open.org/wss/2004/01/oasis-200401-wss-username-token-profile-1.0#PasswordDigest\">";
+}
+
+// One RAND_bytes call serves PoolSize / NonceSize requests
+bool WsseCredential::nonce(unsigned char* out)
+{
+	if (pool_used_ + NonceSize > PoolSize) {
+		if (1 != RAND_bytes(pool_, sizeof(pool_)))
+			return false;
+		pool_used_ = 0;
+	}
+
+	memcpy(out, pool_ + pool_used_, NonceSize);
+	OPENSSL_cleanse(pool_ + pool_used_, NonceSize);
+	pool_used_ += NonceSize;
+	return true;
+}
+
+// Formatted again only when the second changes
+const char* WsseCredential::created()
+{
+	time_t now = time(NULL) + skew_;
+	if (now != created_time_) {
+		struct tm utc;
+		gmtime_r(&now, &utc);
+		strftime(created_, sizeof(created_), "%Y-%m-%dT%H:%M:%SZ", &utc);
+		created_time_ = now;
+	}
+	return created_;
+}
+
+}}}
@@ -0,0 +1,80 @@
+#pragma once
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <stdint.h>
+#include <time.h>
+
+struct evp_md_ctx_st;
+
+namespace orion {
+namespace streamer {
+namespace processor {
+
+// WS-Security UsernameToken of one camera. The header up to the digest is built
+// once per username, each request only draws a nonce from a pooled buffer,
+// hashes it with a reused digest context and appends the timestamp. Created is
+// shifted by the clock offset of the device so a camera with a wrong clock
+// does not reject the token.
+class WsseCredential {
+public:
+	// Variable parts of one UsernameToken, Base64 and xsd:dateTime text
+	class Token {
+	public:
+		char nonce_[32];
+		char digest_[32];
+		char created_[32];
+	};
+
+	WsseCredential();
+
+	~WsseCredential();
+
+	// Security header content, empty without username or when OpenSSL fails
+	void header(const std::string& username, const std::string& password, std::string& out);
+
+	// A fresh nonce, Created and password digest, false without username or
+	// when OpenSSL fails
+	bool token(const std::string& username, const std::string& password, Token& out);
+
+	// Seconds the device clock is ahead of ours
+	void set_skew(int32_t seconds) { skew_ = seconds; }
+
+	int32_t skew() const { return skew_; }
+
+private:
+	WsseCredential(const WsseCredential&);
+	WsseCredential& operator=(const WsseCredential&);
+
+	enum {
+		NonceSize = 16,
+		PoolSize = 256
+	};
+
+	// Fills out, mutex_ held
+	bool digest(const std::string& username, const std::string& password, Token& out);
+
+	void prepare(const std::string& username, const std::string& password);
+
+	bool nonce(unsigned char* out);
+
+	const char* created();
+
+	std::mutex mutex_;
+
+	std::string username_;
+	std::string password_;
+	std::string prefix_;
+
+	evp_md_ctx_st* sha_;
+
+	unsigned char pool_[PoolSize];
+	size_t pool_used_;
+
+	time_t created_time_;
+	char created_[32];
+
+	std::atomic<int32_t> skew_;
+};
+
+}}}